@@ -0,0 +1,19 @@
+// display_backend.c
+//
+// Backend selection from menuconfig. The linux target has no I2C, so it
+// always gets the memory backend.
+
+#include "sdkconfig.h"
+
+#include "display_backend.h"
+
+esp_err_t display_backend_default(display_backend_t **out)
+{
+#if CONFIG_DISPLAY_BACKEND_MEM || CONFIG_IDF_TARGET_LINUX
+    return display_backend_mem(out);
+#elif CONFIG_DISPLAY_BACKEND_ESP_LCD
+    return display_backend_esp_lcd(out);
+#else
+    return display_backend_ssd1306_i2c(out);
+#endif
+}
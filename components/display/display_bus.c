@@ -0,0 +1,63 @@
+// display_bus.c
+//
+// Owner of the I2C master bus. main.c and rocket.c used to each create
+// their own on the same pins; now everything asks here.
+
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "display_bus.h"
+
+#define BUS_TAG  "DISPLAY_BUS"
+
+static i2c_master_bus_handle_t s_bus = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t display_bus_get(i2c_master_bus_handle_t *out)
+{
+    taskENTER_CRITICAL(&s_lock);
+    i2c_master_bus_handle_t bus = s_bus;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (bus == NULL) {
+        i2c_master_bus_config_t bus_cfg = {
+            .i2c_port   = I2C_NUM_0,
+            .scl_io_num = CONFIG_DISPLAY_I2C_SCL_GPIO,
+            .sda_io_num = CONFIG_DISPLAY_I2C_SDA_GPIO,
+            .clk_source = I2C_CLK_SRC_DEFAULT,
+            .glitch_ignore_cnt = 7,
+            .flags = {
+                .enable_internal_pullup = true,
+            },
+        };
+        esp_err_t err = i2c_new_master_bus(&bus_cfg, &bus);
+        if (err != ESP_OK) {
+            ESP_LOGE(BUS_TAG, "I2C bus init failed: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        taskENTER_CRITICAL(&s_lock);
+        bool won = s_bus == NULL;
+        if (won) {
+            s_bus = bus;
+        }
+        taskEXIT_CRITICAL(&s_lock);
+
+        if (won) {
+            ESP_LOGI(BUS_TAG, "I2C bus on SDA %d / SCL %d",
+                     CONFIG_DISPLAY_I2C_SDA_GPIO, CONFIG_DISPLAY_I2C_SCL_GPIO);
+        } else {
+            // Lost a race with another first user: keep theirs
+            i2c_del_master_bus(bus);
+        }
+    }
+
+    *out = s_bus;
+    return ESP_OK;
+}
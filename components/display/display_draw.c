@@ -0,0 +1,182 @@
+// display_draw.c
+//
+// Drawing into a 1-bpp panel-layout framebuffer. Fills work a page span at
+// a time, 4 columns per 32-bit word, so they cost about the same as the
+// bytes they touch.
+
+#include <string.h>
+
+#include "display.h"
+#include "rmds_sprites.h"   // generated font (sprites/gen_sprites.py)
+
+_Static_assert(RMDS_FONT5X7_CELL == DISPLAY_FONT_ADVANCE, "font cells must match the text advance");
+
+// Bits at or below / at or above row n of a page
+static const uint8_t page_mask_to[8]   = { 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF };
+static const uint8_t page_mask_from[8] = { 0xFF, 0xFE, 0xFC, 0xF8, 0xF0, 0xE0, 0xC0, 0x80 };
+
+void display_clear(uint8_t *fb)
+{
+    memset(fb, 0x00, DISPLAY_FRAME_BYTES);
+}
+
+void display_pixel(uint8_t *fb, int x, int y, bool on)
+{
+    if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) {
+        return;
+    }
+
+    uint8_t *byte = &fb[(y / 8) * DISPLAY_WIDTH + x];
+    uint8_t bit_mask = 1 << (y & 7);
+
+    if (on) {
+        *byte |= bit_mask;
+    } else {
+        *byte &= ~bit_mask;
+    }
+}
+
+// Set or clear the mask bits in columns x0..x1-1 of one page: single bytes
+// up to a word boundary, then 4 columns per 32-bit word
+static void page_span(uint8_t *fb, int page, int x0, int x1, uint8_t mask, bool on)
+{
+    uint8_t *row = &fb[page * DISPLAY_WIDTH];
+    int x = x0;
+
+    for (; x < x1 && (x & 3); x++) {
+        row[x] = on ? (row[x] | mask) : (row[x] & ~mask);
+    }
+
+    uint32_t mask32 = mask * 0x01010101u;
+    uint32_t *word = (uint32_t *)&row[x];
+    for (; x + 4 <= x1; x += 4, word++) {
+        *word = on ? (*word | mask32) : (*word & ~mask32);
+    }
+
+    for (; x < x1; x++) {
+        row[x] = on ? (row[x] | mask) : (row[x] & ~mask);
+    }
+}
+
+void display_fill_rect(uint8_t *fb, int x0, int y0, int w, int h, bool on)
+{
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > DISPLAY_WIDTH) x1 = DISPLAY_WIDTH;
+    if (y1 > DISPLAY_HEIGHT) y1 = DISPLAY_HEIGHT;
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    // One span per page touched, masked at the top and bottom pages
+    int last = y1 - 1;
+    for (int page = y0 / 8; page <= last / 8; page++) {
+        uint8_t mask = 0xFF;
+        if (page == y0 / 8) {
+            mask &= page_mask_from[y0 & 7];
+        }
+        if (page == last / 8) {
+            mask &= page_mask_to[last & 7];
+        }
+        page_span(fb, page, x0, x1, mask, on);
+    }
+}
+
+void display_hline(uint8_t *fb, int x0, int x1, int y, bool on)
+{
+    if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+    display_fill_rect(fb, x0, y, x1 - x0 + 1, 1, on);
+}
+
+void display_vline(uint8_t *fb, int x, int y0, int y1, bool on)
+{
+    if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+    display_fill_rect(fb, x, y0, 1, y1 - y0 + 1, on);
+}
+
+void display_border(uint8_t *fb)
+{
+    display_fill_rect(fb, 0, 0, DISPLAY_WIDTH, 1, true);
+    display_fill_rect(fb, 0, DISPLAY_HEIGHT - 1, DISPLAY_WIDTH, 1, true);
+    display_fill_rect(fb, 0, 0, 1, DISPLAY_HEIGHT, true);
+    display_fill_rect(fb, DISPLAY_WIDTH - 1, 0, 1, DISPLAY_HEIGHT, true);
+}
+
+// Each source byte is shifted across the two pages it straddles; pixels
+// outside the sprite's mask (or, without a mask, its clear bits) are left
+// as they were
+void display_blit(uint8_t *fb, const display_sprite_t *sp, int x, int y)
+{
+    x += sp->ox;
+    y += sp->oy;
+
+    int c0 = x < 0 ? -x : 0;
+    int c1 = x + sp->w > DISPLAY_WIDTH ? DISPLAY_WIDTH - x : sp->w;
+    int page0 = y >= 0 ? y / 8 : (y - 7) / 8;
+    int shift = y - page0 * 8;
+
+    for (int p = 0; p < sp->pages; p++) {
+        const uint8_t *bits = &sp->bits[p * sp->w];
+        const uint8_t *mask = sp->mask ? &sp->mask[p * sp->w] : bits;
+        int top = page0 + p;
+        bool draw_top = top >= 0 && top < DISPLAY_PAGES;
+        bool draw_bot = shift && top + 1 >= 0 && top + 1 < DISPLAY_PAGES;
+
+        for (int c = c0; c < c1; c++) {
+            uint16_t b = (uint16_t)(bits[c] << shift);
+            uint16_t m = (uint16_t)(mask[c] << shift);
+            if (draw_top) {
+                uint8_t *d = &fb[top * DISPLAY_WIDTH + x + c];
+                *d = (*d & ~m) | b;
+            }
+            if (draw_bot) {
+                uint8_t *d = &fb[(top + 1) * DISPLAY_WIDTH + x + c];
+                *d = (*d & ~(m >> 8)) | (b >> 8);
+            }
+        }
+    }
+}
+
+void display_char(uint8_t *fb, int x, int y, char c)
+{
+    if (c < RMDS_FONT5X7_FIRST || c > RMDS_FONT5X7_LAST) {
+        return;
+    }
+    display_blit(fb, &rmds_font5x7[c - RMDS_FONT5X7_FIRST], x, y);
+}
+
+int display_text(uint8_t *fb, int x, int y, const char *text)
+{
+    for (; *text && x < DISPLAY_WIDTH; text++, x += DISPLAY_FONT_ADVANCE) {
+        display_char(fb, x, y, *text);
+    }
+    return x;
+}
+
+// The glyph cells are prerendered with their spacing column, so on a page
+// boundary each character is one copy of DISPLAY_FONT_ADVANCE bytes
+int display_text_page(uint8_t *fb, int x, int page, const char *text)
+{
+    static const uint8_t blank[DISPLAY_FONT_ADVANCE];
+
+    if (page < 0 || page >= DISPLAY_PAGES) {
+        return x;
+    }
+    uint8_t *row = &fb[page * DISPLAY_WIDTH];
+
+    for (; *text && x < DISPLAY_WIDTH; text++, x += DISPLAY_FONT_ADVANCE) {
+        const uint8_t *cell = blank;
+        if (*text >= RMDS_FONT5X7_FIRST && *text <= RMDS_FONT5X7_LAST) {
+            cell = &rmds_font5x7_cells[(*text - RMDS_FONT5X7_FIRST) * DISPLAY_FONT_ADVANCE];
+        }
+
+        int c0 = x < 0 ? -x : 0;
+        int c1 = x + DISPLAY_FONT_ADVANCE > DISPLAY_WIDTH ? DISPLAY_WIDTH - x : DISPLAY_FONT_ADVANCE;
+        if (c0 < c1) {
+            memcpy(&row[x + c0], &cell[c0], c1 - c0);
+        }
+    }
+    return x;
+}
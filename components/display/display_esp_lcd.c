@@ -0,0 +1,90 @@
+// display_esp_lcd.c
+//
+// SSD1306 through the esp_lcd panel driver. A draw_bitmap window has to be
+// contiguous in memory, which a column span of a full-width frame only is
+// within one page, so changed pages go out one at a time.
+
+#include "sdkconfig.h"
+
+#include "esp_log.h"
+#include "driver/i2c_master.h"
+
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_io_i2c.h"
+
+#include "display_backend.h"
+#include "display_bus.h"
+
+#define LCD_TAG  "DISPLAY_LCD"
+
+static esp_lcd_panel_io_handle_t s_io = NULL;
+static esp_lcd_panel_handle_t    s_panel = NULL;
+
+static esp_err_t esp_lcd_write(display_backend_t *backend, const uint8_t *frame,
+                               int x0, int x1, int p0, int p1)
+{
+    (void)backend;
+    (void)p1;   // single page (multi_page = false)
+
+    return esp_lcd_panel_draw_bitmap(s_panel, x0, p0 * 8, x1 + 1, p0 * 8 + 8,
+                                     &frame[p0 * DISPLAY_WIDTH + x0]);
+}
+
+static esp_err_t esp_lcd_set_power(display_backend_t *backend, bool on)
+{
+    (void)backend;
+
+    return esp_lcd_panel_disp_on_off(s_panel, on);
+}
+
+static display_backend_t s_backend = {
+    .name = "esp_lcd",
+    .write = esp_lcd_write,
+    .set_power = esp_lcd_set_power,
+    .multi_page = false,
+    // column (0x21) and page (0x22) address commands, then the data
+    // transfer's address + control byte
+    .window_overhead = 12,
+};
+
+esp_err_t display_backend_esp_lcd(display_backend_t **out)
+{
+    if (s_panel == NULL) {
+        i2c_master_bus_handle_t bus = NULL;
+        esp_err_t err = display_bus_get(&bus);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        // --- Create panel I/O over I2C ---
+        esp_lcd_panel_io_i2c_config_t io_cfg = {
+            .dev_addr            = CONFIG_DISPLAY_I2C_ADDR,
+            .control_phase_bytes = 1,
+            .lcd_cmd_bits        = 8,
+            .lcd_param_bits      = 8,
+            .dc_bit_offset       = 6,
+            .scl_speed_hz        = CONFIG_DISPLAY_I2C_FREQ_HZ,
+        };
+        ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c(bus, &io_cfg, &s_io));
+
+        // --- Create SSD1306 panel (no color_space in v6.1) ---
+        esp_lcd_panel_dev_config_t panel_cfg = {
+            .reset_gpio_num = -1,
+            .bits_per_pixel = 1,
+        };
+        ESP_ERROR_CHECK(esp_lcd_new_panel_ssd1306(s_io, &panel_cfg, &s_panel));
+        ESP_ERROR_CHECK(esp_lcd_panel_reset(s_panel));
+        ESP_ERROR_CHECK(esp_lcd_panel_init(s_panel));
+
+        // The module is mounted upside down: segment remap + COM scan
+        // reverse rotate it 180° in the controller
+        ESP_ERROR_CHECK(esp_lcd_panel_mirror(s_panel, true, true));
+
+        ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(s_panel, true));
+        ESP_LOGI(LCD_TAG, "SSD1306 up through esp_lcd");
+    }
+
+    *out = &s_backend;
+    return ESP_OK;
+}
@@ -0,0 +1,41 @@
+// display_mem.c
+//
+// Backend without a panel: windows are copied into a RAM image of the
+// SSD1306's display memory. Builds on every target, including linux, so
+// drawing and the flush diff can be checked off the board.
+
+#include <string.h>
+
+#include "display_backend.h"
+
+static uint8_t s_panel[DISPLAY_FRAME_BYTES];
+
+static esp_err_t mem_write(display_backend_t *backend, const uint8_t *frame,
+                           int x0, int x1, int p0, int p1)
+{
+    (void)backend;
+
+    for (int page = p0; page <= p1; page++) {
+        memcpy(&s_panel[page * DISPLAY_WIDTH + x0],
+               &frame[page * DISPLAY_WIDTH + x0], x1 - x0 + 1);
+    }
+    return ESP_OK;
+}
+
+static display_backend_t s_backend = {
+    .name = "memory",
+    .write = mem_write,
+    .multi_page = true,
+    .window_overhead = 0,
+};
+
+esp_err_t display_backend_mem(display_backend_t **out)
+{
+    *out = &s_backend;
+    return ESP_OK;
+}
+
+const uint8_t *display_backend_mem_frame(void)
+{
+    return s_panel;
+}
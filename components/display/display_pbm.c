@@ -0,0 +1,94 @@
+// display_pbm.c
+//
+// PBM output for the linux target: a backend that is the memory backend
+// plus a file per flush, and the encoder the host render tests compare
+// against their golden images with.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "display_backend.h"
+
+#define PBM_TAG      "DISPLAY_PBM"
+#define PBM_HEADER   "P4\n128 64\n"
+
+static display_backend_t *s_mem = NULL;
+static const char *s_dir = NULL;
+static uint32_t s_frame_no = 0;
+
+size_t display_pbm_encode(const uint8_t *frame, uint8_t *out, size_t out_len)
+{
+    const size_t header_len = sizeof(PBM_HEADER) - 1;
+    const size_t len = header_len + DISPLAY_WIDTH / 8 * DISPLAY_HEIGHT;
+    if (out_len < len) {
+        return len;
+    }
+
+    memcpy(out, PBM_HEADER, header_len);
+    uint8_t *row = out + header_len;
+
+    // Panel bytes are 8 pixels down a column, PBM bytes 8 across a row
+    for (int y = 0; y < DISPLAY_HEIGHT; y++, row += DISPLAY_WIDTH / 8) {
+        const uint8_t *src = &frame[(y / 8) * DISPLAY_WIDTH];
+        uint8_t bit = 1 << (y & 7);
+        for (int xb = 0; xb < DISPLAY_WIDTH / 8; xb++) {
+            uint8_t b = 0;
+            for (int i = 0; i < 8; i++) {
+                if (src[xb * 8 + i] & bit) {
+                    b |= 0x80 >> i;
+                }
+            }
+            row[xb] = b;
+        }
+    }
+    return len;
+}
+
+esp_err_t display_pbm_save(const uint8_t *frame, const char *path)
+{
+    uint8_t pbm[32 + DISPLAY_FRAME_BYTES];
+    size_t len = display_pbm_encode(frame, pbm, sizeof(pbm));
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        ESP_LOGE(PBM_TAG, "Can't create %s", path);
+        return ESP_FAIL;
+    }
+    size_t written = fwrite(pbm, 1, len, f);
+    fclose(f);
+    return written == len ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t pbm_write(display_backend_t *backend, const uint8_t *frame,
+                           int x0, int x1, int p0, int p1)
+{
+    (void)backend;
+
+    esp_err_t err = s_mem->write(s_mem, frame, x0, x1, p0, p1);
+    if (err != ESP_OK || s_dir == NULL) {
+        return err;
+    }
+
+    // One window per flush (multi_page), so one file per flush
+    char path[256];
+    snprintf(path, sizeof(path), "%s/frame_%04lu.pbm", s_dir, (unsigned long)s_frame_no++);
+    return display_pbm_save(display_backend_mem_frame(), path);
+}
+
+static display_backend_t s_backend = {
+    .name = "pbm",
+    .write = pbm_write,
+    .multi_page = true,
+    .window_overhead = 0,
+};
+
+esp_err_t display_backend_pbm(display_backend_t **out, const char *dir)
+{
+    display_backend_mem(&s_mem);
+    s_dir = dir;
+    s_frame_no = 0;
+    *out = &s_backend;
+    return ESP_OK;
+}
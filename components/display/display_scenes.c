@@ -0,0 +1,71 @@
+// display_scenes.c
+//
+// The splash and rocket animations, out of main.c and the rocket demo so
+// the host tests can render exactly what the panel shows.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "display.h"
+#include "display_scenes.h"
+#include "rmds_sprites.h"   // generated by sprites/gen_sprites.py
+
+// Splash letters: 22x40 sprites, 3 px apart, centred in a 100 px row
+#define RMDS_ROW_W      100
+#define RMDS_LETTER_W   22
+#define RMDS_GAP        3
+#define RMDS_TOP        10
+
+// Some static background stars
+static const struct {
+    uint8_t x, y;
+} stars[] = {
+    {10, 10}, {25, 5}, {40, 15}, {60, 8}, {90, 12},
+    {110, 4}, {15, 30}, {50, 24}, {80, 20}, {120, 28},
+    {5, 50}, {35, 40}, {70, 45}, {100, 38}, {115, 52}
+};
+
+void display_scene_rmds(uint8_t *fb, int letters)
+{
+    static const display_sprite_t *const sprites[] = {
+        &rmds_sprite_letter_R, &rmds_sprite_letter_M,
+        &rmds_sprite_letter_D, &rmds_sprite_letter_S,
+    };
+    int base_x = (DISPLAY_WIDTH - RMDS_ROW_W) / 2;
+
+    display_clear(fb);
+    display_border(fb);
+
+    for (int i = 0; i < letters && i < 4; i++) {
+        display_blit(fb, sprites[i], base_x + i * (RMDS_LETTER_W + RMDS_GAP), RMDS_TOP);
+    }
+}
+
+void display_scene_rocket(uint8_t *fb, int frame)
+{
+    int x = -20 + 2 * frame;
+
+    display_clear(fb);
+
+    // Starfield with slight twinkle
+    for (size_t i = 0; i < sizeof(stars) / sizeof(stars[0]); i++) {
+        bool on = ((i + (frame & 0x03)) & 1) == 0;
+        display_pixel(fb, stars[i].x, stars[i].y, on);
+    }
+
+    // Ground / horizon line
+    int ground_y = DISPLAY_HEIGHT - 6;
+    display_hline(fb, 0, DISPLAY_WIDTH - 1, ground_y, true);
+
+    // Rocket path (slight arc: small vertical sine-ish wobble). The sprite
+    // is anchored at the bottom centre of the body; the flame alternates
+    // between its two lengths.
+    int center_y = ground_y - 8;
+    int wobble = (frame % 16 < 8) ? (frame % 8) : (15 - (frame % 16));
+    bool big_flame = (frame & 1) == 0;
+    display_blit(fb, big_flame ? &rmds_sprite_rocket_big : &rmds_sprite_rocket_small,
+                 x, center_y - wobble);
+
+    // HUD countdown in top-left (0..9)
+    display_char(fb, 4, 4, '0' + (frame / 8) % 10);
+}
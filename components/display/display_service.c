@@ -0,0 +1,248 @@
+// display_service.c
+//
+// Front/back framebuffers for the OLED. Producers render into the back
+// buffer; a low-priority task swaps it to the front and sends what changed
+// through the backend, so a slow or stuck bus only ever delays the panel,
+// never the producer or the higher-priority UART/LoRa tasks.
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "display.h"
+#include "display_backend.h"
+
+#define DISPLAY_TAG          "DISPLAY"
+#define DISPLAY_STATS_EVERY  100     // flushed frames between timing reports
+
+// Stored as words so the renderers' 32-bit fills stay aligned
+static uint32_t s_frames[2][DISPLAY_FRAME_BYTES / 4];
+
+// s_frames[s_front] belongs to the flush task, the other one to the producer
+static int  s_front = 0;
+static bool s_back_ready = false;   // back holds a submitted, unflushed frame
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_flush_task = NULL;
+static display_backend_t *s_backend = NULL;
+
+// What the panel currently shows, so a flush only sends what changed
+static uint8_t s_shadow[DISPLAY_FRAME_BYTES];
+static bool    s_shadow_valid = false;
+
+// Timing, reported every DISPLAY_STATS_EVERY flushes
+static int64_t  s_render_start_us = 0;
+static int64_t  s_render_us_total = 0;
+static int64_t  s_flush_us_total = 0;
+static int64_t  s_flush_us_max = 0;
+static uint32_t s_submitted = 0;
+static uint32_t s_flushed = 0;
+static uint32_t s_dropped = 0;
+static uint64_t s_bus_bytes_total = 0;
+static uint32_t s_windows_total = 0;
+
+static void display_log_stats(void)
+{
+    ESP_LOGI(DISPLAY_TAG,
+             "%lu frames: render avg %lld us, flush avg %lld us (max %lld us), "
+             "avg %llu bus bytes in %lu.%02lu windows, %lu dropped",
+             (unsigned long)s_flushed,
+             (long long)(s_submitted ? s_render_us_total / s_submitted : 0),
+             (long long)(s_flush_us_total / s_flushed),
+             (long long)s_flush_us_max,
+             (unsigned long long)(s_bus_bytes_total / s_flushed),
+             (unsigned long)(s_windows_total / s_flushed),
+             (unsigned long)(s_windows_total * 100 / s_flushed % 100),
+             (unsigned long)s_dropped);
+    s_flush_us_max = 0;
+}
+
+static void display_write_window(const uint8_t *frame, int x0, int x1, int p0, int p1)
+{
+    esp_err_t err = s_backend->write(s_backend, frame, x0, x1, p0, p1);
+    if (err != ESP_OK) {
+        // Whatever the panel shows now is unknown: resend it all next time
+        ESP_LOGW(DISPLAY_TAG, "%s write failed: %s", s_backend->name, esp_err_to_name(err));
+        s_shadow_valid = false;
+        return;
+    }
+
+    for (int page = p0; page <= p1; page++) {
+        memcpy(&s_shadow[page * DISPLAY_WIDTH + x0],
+               &frame[page * DISPLAY_WIDTH + x0], x1 - x0 + 1);
+    }
+    s_bus_bytes_total += (uint32_t)(x1 - x0 + 1) * (p1 - p0 + 1) + s_backend->window_overhead;
+    s_windows_total++;
+}
+
+// Send only what differs from the shadow copy: per page, the span from the
+// first to the last changed column. Backends that take multi-page windows
+// get one window bounding all of them, the others one window per page.
+static void display_flush(const uint8_t *frame)
+{
+    bool full = !s_shadow_valid;
+    s_shadow_valid = true;
+
+    int bx0 = DISPLAY_WIDTH, bx1 = -1;
+    int bp0 = DISPLAY_PAGES, bp1 = -1;
+
+    for (int page = 0; page < DISPLAY_PAGES; page++) {
+        const uint8_t *line   = &frame[page * DISPLAY_WIDTH];
+        const uint8_t *shadow = &s_shadow[page * DISPLAY_WIDTH];
+
+        int x0 = 0;
+        int x1 = DISPLAY_WIDTH - 1;
+        if (!full) {
+            while (x0 < DISPLAY_WIDTH && line[x0] == shadow[x0]) {
+                x0++;
+            }
+            if (x0 == DISPLAY_WIDTH) {
+                continue;   // page unchanged
+            }
+            while (line[x1] == shadow[x1]) {
+                x1--;
+            }
+        }
+
+        if (!s_backend->multi_page) {
+            display_write_window(frame, x0, x1, page, page);
+            continue;
+        }
+        if (x0 < bx0) bx0 = x0;
+        if (x1 > bx1) bx1 = x1;
+        if (page < bp0) bp0 = page;
+        bp1 = page;
+    }
+
+    if (s_backend->multi_page && bp1 >= bp0) {
+        display_write_window(frame, bx0, bx1, bp0, bp1);
+    }
+}
+
+static void display_flush_task(void *pvParameters)
+{
+    (void)pvParameters;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Keep going while the producer submits faster than we can flush
+        while (1) {
+            taskENTER_CRITICAL(&s_lock);
+            bool ready = s_back_ready;
+            if (ready) {
+                s_front ^= 1;
+                s_back_ready = false;
+            }
+            int front = s_front;
+            taskEXIT_CRITICAL(&s_lock);
+
+            if (!ready) {
+                break;
+            }
+
+            int64_t start = esp_timer_get_time();
+            display_flush((const uint8_t *)s_frames[front]);
+            int64_t us = esp_timer_get_time() - start;
+
+            s_flush_us_total += us;
+            if (us > s_flush_us_max) {
+                s_flush_us_max = us;
+            }
+            taskENTER_CRITICAL(&s_lock);
+            s_flushed++;
+            taskEXIT_CRITICAL(&s_lock);
+            if (s_flushed % DISPLAY_STATS_EVERY == 0) {
+                display_log_stats();
+            }
+        }
+    }
+}
+
+esp_err_t display_start(display_backend_t *backend, UBaseType_t priority)
+{
+    if (s_flush_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_backend = backend;
+    s_shadow_valid = false;
+
+    if (xTaskCreate(display_flush_task, "display_flush", 3072, NULL,
+                    priority, &s_flush_task) != pdPASS) {
+        ESP_LOGE(DISPLAY_TAG, "Failed to create display_flush task");
+        s_flush_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(DISPLAY_TAG, "Flushing through %s", backend->name);
+    return ESP_OK;
+}
+
+uint8_t *display_begin_frame(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    if (s_back_ready) {
+        s_dropped++;            // flush task never got to it
+        s_back_ready = false;   // and must not take it half redrawn
+    }
+    int back = s_front ^ 1;
+    taskEXIT_CRITICAL(&s_lock);
+
+    s_render_start_us = esp_timer_get_time();
+    return (uint8_t *)s_frames[back];
+}
+
+uint8_t *display_begin_update(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    // A frame still waiting is the latest one: take it back and patch it.
+    // Otherwise the flush task has the latest as its front buffer; it only
+    // reads that, so it can be copied while a flush is running.
+    bool pending = s_back_ready;
+    s_back_ready = false;
+    int back = s_front ^ 1;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!pending) {
+        memcpy(s_frames[back], s_frames[back ^ 1], sizeof(s_frames[back]));
+    }
+    s_render_start_us = esp_timer_get_time();
+    return (uint8_t *)s_frames[back];
+}
+
+void display_submit(void)
+{
+    s_render_us_total += esp_timer_get_time() - s_render_start_us;
+    s_submitted++;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_back_ready = true;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (s_flush_task != NULL) {
+        xTaskNotifyGive(s_flush_task);
+    }
+}
+
+uint32_t display_frames_flushed(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t flushed = s_flushed;
+    taskEXIT_CRITICAL(&s_lock);
+    return flushed;
+}
+
+esp_err_t display_set_power(bool on)
+{
+    if (s_backend == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_backend->set_power == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return s_backend->set_power(s_backend, on);
+}
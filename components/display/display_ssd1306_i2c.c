@@ -0,0 +1,138 @@
+// display_ssd1306_i2c.c
+//
+// Raw SSD1306 over I2C. A window is two transactions however many pages it
+// covers: the column/page address commands, then the control byte followed
+// by each page row straight out of the frame (no staging copy).
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_log.h"
+#include "driver/i2c_master.h"
+
+#include "display_backend.h"
+#include "display_bus.h"
+
+#define SSD1306_TAG          "SSD1306"
+#define SSD1306_CMD          0x00
+#define SSD1306_DATA         0x40
+#define SSD1306_TIMEOUT_MS   1000
+
+static i2c_master_dev_handle_t s_dev = NULL;
+
+// One I2C transaction: control byte followed by the given buffers
+// (bufs[0] is filled in here)
+static esp_err_t ssd1306_transmit(uint8_t control,
+                                  i2c_master_transmit_multi_buffer_info_t *bufs,
+                                  size_t count)
+{
+    bufs[0].write_buffer = &control;
+    bufs[0].buffer_size = 1;
+    return i2c_master_multi_buffer_transmit(s_dev, bufs, count,
+                                            SSD1306_TIMEOUT_MS / portTICK_PERIOD_MS);
+}
+
+// A whole command stream in one transaction
+static esp_err_t ssd1306_write_commands(const uint8_t *cmds, size_t len)
+{
+    i2c_master_transmit_multi_buffer_info_t bufs[2] = {
+        [1] = { .write_buffer = (uint8_t *)cmds, .buffer_size = len },
+    };
+    return ssd1306_transmit(SSD1306_CMD, bufs, 2);
+}
+
+// With horizontal addressing the panel wraps to the next page at x1 by
+// itself, so the page rows just follow each other in the data transaction
+static esp_err_t ssd1306_write(display_backend_t *backend, const uint8_t *frame,
+                               int x0, int x1, int p0, int p1)
+{
+    (void)backend;
+
+    const uint8_t window[] = {
+        0x21, (uint8_t)x0, (uint8_t)x1,     // column range
+        0x22, (uint8_t)p0, (uint8_t)p1,     // page range
+    };
+    esp_err_t err = ssd1306_write_commands(window, sizeof(window));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    i2c_master_transmit_multi_buffer_info_t bufs[1 + DISPLAY_PAGES];
+    size_t count = 1;
+    for (int page = p0; page <= p1; page++) {
+        bufs[count].write_buffer = (uint8_t *)&frame[page * DISPLAY_WIDTH + x0];
+        bufs[count].buffer_size = x1 - x0 + 1;
+        count++;
+    }
+    return ssd1306_transmit(SSD1306_DATA, bufs, count);
+}
+
+// Display OFF is the controller's sleep mode: RAM kept, charge pump off
+static esp_err_t ssd1306_set_power(display_backend_t *backend, bool on)
+{
+    (void)backend;
+
+    const uint8_t cmd = on ? 0xAF : 0xAE;
+    return ssd1306_write_commands(&cmd, 1);
+}
+
+static display_backend_t s_backend = {
+    .name = "ssd1306-i2c",
+    .write = ssd1306_write,
+    .set_power = ssd1306_set_power,
+    .multi_page = true,
+    // address + control + 6 command bytes, then address + control for the data
+    .window_overhead = 10,
+};
+
+esp_err_t display_backend_ssd1306_i2c(display_backend_t **out)
+{
+    if (s_dev == NULL) {
+        i2c_master_bus_handle_t bus = NULL;
+        esp_err_t err = display_bus_get(&bus);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        i2c_device_config_t dev_cfg = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address  = CONFIG_DISPLAY_I2C_ADDR,
+            .scl_speed_hz    = CONFIG_DISPLAY_I2C_FREQ_HZ,
+        };
+        err = i2c_master_bus_add_device(bus, &dev_cfg, &s_dev);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        const uint8_t init_cmds[] = {
+            0xAE,       // Display OFF
+            0xD5, 0x80, // Clock divide / oscillator freq
+            0xA8, 0x3F, // Multiplex ratio (1/64)
+            0xD3, 0x00, // Display offset = 0
+            0x40,       // Start line = 0
+            0x8D, 0x14, // Charge pump ON
+            0x20, 0x00, // Memory mode = horizontal
+            0xA1,       // Segment remap      } together the 180°
+            0xC8,       // COM scan remapped  } rotation
+            0xDA, 0x12, // COM pins config
+            0x81, 0x7F, // Contrast
+            0xD9, 0xF1, // Pre-charge
+            0xDB, 0x40, // VCOMH deselect level
+            0xA4,       // Display from RAM
+            0xA6,       // Normal (not inverted)
+            0x2E,       // Deactivate scroll
+            0xAF        // Display ON
+        };
+        err = ssd1306_write_commands(init_cmds, sizeof(init_cmds));
+        if (err != ESP_OK) {
+            ESP_LOGE(SSD1306_TAG, "Panel init failed: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    *out = &s_backend;
+    return ESP_OK;
+}
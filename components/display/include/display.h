@@ -0,0 +1,104 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// SSD1306 128x64 display: framebuffer, drawing and flush service
+// ================================================================
+//
+// Frames are 1 bpp in panel layout: DISPLAY_PAGES rows of DISPLAY_WIDTH
+// bytes, each byte 8 vertical pixels with bit 0 on top. The panel itself is
+// set up rotated 180°, so (x, y) maps straight to page y/8, column x.
+//
+// A producer renders into the back buffer and submits it; a low-priority
+// task sends whatever changed to the panel through a backend (see
+// display_backend.h). Submitting never waits for the bus: if the flush task
+// is still busy the newest frame replaces the one waiting, so a slow panel
+// drops frames instead of stalling the producer.
+
+#define DISPLAY_WIDTH         128
+#define DISPLAY_HEIGHT        64
+#define DISPLAY_PAGES         (DISPLAY_HEIGHT / 8)
+#define DISPLAY_FRAME_BYTES   (DISPLAY_WIDTH * DISPLAY_PAGES)
+
+// Constant 1-bpp bitmap in panel layout: pages * w bytes, page-major,
+// bit 0 = top row of the page. Drawn at (x + ox, y + oy). The generated
+// ones are in rmds_sprites.h (sprites/gen_sprites.py).
+typedef struct {
+    int8_t  ox, oy;
+    uint8_t w, pages;
+    const uint8_t *bits;
+    const uint8_t *mask;    // pixels painted (on or off); NULL = set bits only
+} display_sprite_t;
+
+// Horizontal advance of display_text()
+#define DISPLAY_FONT_ADVANCE  6
+
+typedef struct display_backend display_backend_t;
+
+// ---- Flush service ----
+
+// Start the flush task on the given backend (already initialised).
+esp_err_t display_start(display_backend_t *backend, UBaseType_t priority);
+
+// Back buffer to render the next frame into, 4-byte aligned. Its previous
+// contents are undefined (it may be the frame before last), so draw the
+// whole frame.
+uint8_t *display_begin_frame(void);
+
+// Back buffer holding the latest submitted frame, for producers that
+// patch only the regions that changed. Submit it like a fresh frame.
+uint8_t *display_begin_update(void);
+
+// Hand the back buffer to the flush task
+void display_submit(void);
+
+// Panel on or off (SSD1306 sleep); the frame and the flushes carry on.
+// ESP_ERR_NOT_SUPPORTED if the backend has no power control.
+esp_err_t display_set_power(bool on);
+
+// Frames the flush task has sent to the backend so far
+uint32_t display_frames_flushed(void);
+
+// ---- Drawing (into any DISPLAY_FRAME_BYTES buffer, 4-byte aligned) ----
+//
+// Everything is clipped to the screen.
+
+void display_clear(uint8_t *fb);
+void display_pixel(uint8_t *fb, int x, int y, bool on);
+void display_fill_rect(uint8_t *fb, int x, int y, int w, int h, bool on);
+void display_hline(uint8_t *fb, int x0, int x1, int y, bool on);
+void display_vline(uint8_t *fb, int x, int y0, int y1, bool on);
+
+// 1-pixel frame around the whole screen
+void display_border(uint8_t *fb);
+
+// Sprite anchored at (x, y), merged through its mask
+void display_blit(uint8_t *fb, const display_sprite_t *sp, int x, int y);
+
+// 5x7 text with its top-left corner at (x, y). Characters the font doesn't
+// have are skipped (their cell is left blank). Returns the x after the
+// last character.
+int display_text(uint8_t *fb, int x, int y, const char *text);
+void display_char(uint8_t *fb, int x, int y, char c);
+
+// Opaque text on one page row (y = page * 8): every character replaces its
+// whole DISPLAY_FONT_ADVANCE x 8 cell, unknown ones with a blank cell, so
+// redrawing a changed value needs no clear first. Returns the x after the
+// last character.
+int display_text_page(uint8_t *fb, int x, int page, const char *text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
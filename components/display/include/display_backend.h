@@ -0,0 +1,69 @@
+#ifndef DISPLAY_BACKEND_H
+#define DISPLAY_BACKEND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "display.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Display backends
+// ================================================================
+//
+// A backend moves part of a frame to wherever the pixels end up. The flush
+// task diffs each frame against what the panel already shows and asks for
+// the changed columns only, either as one window spanning every changed
+// page (multi_page) or one window per changed page.
+
+struct display_backend {
+    const char *name;
+
+    // Write columns x0..x1 of pages p0..p1 (inclusive) of frame
+    esp_err_t (*write)(display_backend_t *backend, const uint8_t *frame,
+                       int x0, int x1, int p0, int p1);
+
+    // Panel display on / off, contents kept (NULL: always on)
+    esp_err_t (*set_power)(display_backend_t *backend, bool on);
+
+    bool     multi_page;        // one window may span several pages
+    uint32_t window_overhead;   // bus bytes per window besides the pixels
+
+    void *ctx;
+};
+
+// SSD1306 driven directly over I2C: the window command and all its page
+// rows go out as two bus transactions. The fastest path on hardware.
+esp_err_t display_backend_ssd1306_i2c(display_backend_t **out);
+
+// SSD1306 through the esp_lcd panel driver, one draw per changed page
+esp_err_t display_backend_esp_lcd(display_backend_t **out);
+
+// No panel: frames land in RAM (display_backend_mem_frame()), for host
+// builds and tests
+esp_err_t display_backend_mem(display_backend_t **out);
+const uint8_t *display_backend_mem_frame(void);
+
+// The memory backend, and with a directory set every flush is also saved
+// there as frame_NNNN.pbm (linux target)
+esp_err_t display_backend_pbm(display_backend_t **out, const char *dir);
+
+// frame as a binary PBM (P4, 1 = black, so lit pixels come out dark).
+// Returns the bytes needed; writes nothing if they don't fit in out_len.
+size_t display_pbm_encode(const uint8_t *frame, uint8_t *out, size_t out_len);
+esp_err_t display_pbm_save(const uint8_t *frame, const char *path);
+
+// The backend picked in menuconfig (Display Configuration)
+esp_err_t display_backend_default(display_backend_t **out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
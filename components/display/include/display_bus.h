@@ -0,0 +1,24 @@
+#ifndef DISPLAY_BUS_H
+#define DISPLAY_BUS_H
+
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Shared I2C bus (OLED and anything else on SDA/SCL)
+// ================================================================
+
+// The board's I2C master bus, created on first use with the pins from
+// menuconfig. Add devices to it instead of creating another bus on the
+// same pins.
+esp_err_t display_bus_get(i2c_master_bus_handle_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
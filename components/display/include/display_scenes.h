@@ -0,0 +1,34 @@
+#ifndef DISPLAY_SCENES_H
+#define DISPLAY_SCENES_H
+
+#include <stdint.h>
+
+#include "display.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Scenes drawn by the firmware, the rocket demo and the host tests
+// ================================================================
+//
+// Each call draws a whole frame (clear included) into fb.
+
+// One left-to-right pass of the rocket: x = -20 .. DISPLAY_WIDTH + 18, 2 px
+// per frame
+#define DISPLAY_ROCKET_FRAMES  ((DISPLAY_WIDTH + 40) / 2)
+
+// RMDS splash: border plus the first `letters` of R, M, D, S (0 = border
+// only, the blink-off frame)
+void display_scene_rmds(uint8_t *fb, int letters);
+
+// Rocket demo frame 0 .. DISPLAY_ROCKET_FRAMES - 1: twinkling stars, ground
+// line, wobbling rocket with flickering flame and a 0-9 HUD countdown
+void display_scene_rocket(uint8_t *fb, int frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
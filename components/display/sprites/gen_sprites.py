@@ -0,0 +1,302 @@
+#!/usr/bin/env python3
+# Generate rmds_sprites.h: the fixed OLED shapes (RMDS splash letters,
+# rocket, 5x7 font) as page-aligned 1-bpp bitmaps for display_blit().
+#
+# The shapes are drawn here with the same integer math the firmware used to
+# run every frame, so the blitted result is pixel-identical.
+#
+# usage: gen_sprites.py <output header>
+
+import sys
+
+# 5x7 glyphs for printable ASCII, one byte per column, bit 0 = top row
+FONT5X7 = {
+    ' ':  (0x00, 0x00, 0x00, 0x00, 0x00),
+    '!':  (0x00, 0x00, 0x5F, 0x00, 0x00),
+    '"':  (0x00, 0x07, 0x00, 0x07, 0x00),
+    '#':  (0x14, 0x7F, 0x14, 0x7F, 0x14),
+    '$':  (0x24, 0x2A, 0x7F, 0x2A, 0x12),
+    '%':  (0x23, 0x13, 0x08, 0x64, 0x62),
+    '&':  (0x36, 0x49, 0x55, 0x22, 0x50),
+    "'":  (0x00, 0x05, 0x03, 0x00, 0x00),
+    '(':  (0x00, 0x1C, 0x22, 0x41, 0x00),
+    ')':  (0x00, 0x41, 0x22, 0x1C, 0x00),
+    '*':  (0x14, 0x08, 0x3E, 0x08, 0x14),
+    '+':  (0x08, 0x08, 0x3E, 0x08, 0x08),
+    ',':  (0x00, 0x50, 0x30, 0x00, 0x00),
+    '-':  (0x08, 0x08, 0x08, 0x08, 0x08),
+    '.':  (0x00, 0x60, 0x60, 0x00, 0x00),
+    '/':  (0x20, 0x10, 0x08, 0x04, 0x02),
+    '0':  (0x3E, 0x51, 0x49, 0x45, 0x3E),
+    '1':  (0x00, 0x42, 0x7F, 0x40, 0x00),
+    '2':  (0x42, 0x61, 0x51, 0x49, 0x46),
+    '3':  (0x21, 0x41, 0x45, 0x4B, 0x31),
+    '4':  (0x18, 0x14, 0x12, 0x7F, 0x10),
+    '5':  (0x27, 0x45, 0x45, 0x45, 0x39),
+    '6':  (0x3C, 0x4A, 0x49, 0x49, 0x30),
+    '7':  (0x01, 0x71, 0x09, 0x05, 0x03),
+    '8':  (0x36, 0x49, 0x49, 0x49, 0x36),
+    '9':  (0x06, 0x49, 0x49, 0x29, 0x1E),
+    ':':  (0x00, 0x36, 0x36, 0x00, 0x00),
+    ';':  (0x00, 0x56, 0x36, 0x00, 0x00),
+    '<':  (0x08, 0x14, 0x22, 0x41, 0x00),
+    '=':  (0x14, 0x14, 0x14, 0x14, 0x14),
+    '>':  (0x00, 0x41, 0x22, 0x14, 0x08),
+    '?':  (0x02, 0x01, 0x51, 0x09, 0x06),
+    '@':  (0x32, 0x49, 0x79, 0x41, 0x3E),
+    'A':  (0x7E, 0x11, 0x11, 0x11, 0x7E),
+    'B':  (0x7F, 0x49, 0x49, 0x49, 0x36),
+    'C':  (0x3E, 0x41, 0x41, 0x41, 0x22),
+    'D':  (0x7F, 0x41, 0x41, 0x22, 0x1C),
+    'E':  (0x7F, 0x49, 0x49, 0x49, 0x41),
+    'F':  (0x7F, 0x09, 0x09, 0x09, 0x01),
+    'G':  (0x3E, 0x41, 0x49, 0x49, 0x7A),
+    'H':  (0x7F, 0x08, 0x08, 0x08, 0x7F),
+    'I':  (0x00, 0x41, 0x7F, 0x41, 0x00),
+    'J':  (0x20, 0x40, 0x41, 0x3F, 0x01),
+    'K':  (0x7F, 0x08, 0x14, 0x22, 0x41),
+    'L':  (0x7F, 0x40, 0x40, 0x40, 0x40),
+    'M':  (0x7F, 0x02, 0x0C, 0x02, 0x7F),
+    'N':  (0x7F, 0x04, 0x08, 0x10, 0x7F),
+    'O':  (0x3E, 0x41, 0x41, 0x41, 0x3E),
+    'P':  (0x7F, 0x09, 0x09, 0x09, 0x06),
+    'Q':  (0x3E, 0x41, 0x51, 0x21, 0x5E),
+    'R':  (0x7F, 0x09, 0x19, 0x29, 0x46),
+    'S':  (0x46, 0x49, 0x49, 0x49, 0x31),
+    'T':  (0x01, 0x01, 0x7F, 0x01, 0x01),
+    'U':  (0x3F, 0x40, 0x40, 0x40, 0x3F),
+    'V':  (0x1F, 0x20, 0x40, 0x20, 0x1F),
+    'W':  (0x3F, 0x40, 0x38, 0x40, 0x3F),
+    'X':  (0x63, 0x14, 0x08, 0x14, 0x63),
+    'Y':  (0x07, 0x08, 0x70, 0x08, 0x07),
+    'Z':  (0x61, 0x51, 0x49, 0x45, 0x43),
+    '[':  (0x00, 0x7F, 0x41, 0x41, 0x00),
+    '\\': (0x02, 0x04, 0x08, 0x10, 0x20),
+    ']':  (0x00, 0x41, 0x41, 0x7F, 0x00),
+    '^':  (0x04, 0x02, 0x01, 0x02, 0x04),
+    '_':  (0x40, 0x40, 0x40, 0x40, 0x40),
+    '`':  (0x00, 0x01, 0x02, 0x04, 0x00),
+    'a':  (0x20, 0x54, 0x54, 0x54, 0x78),
+    'b':  (0x7F, 0x48, 0x44, 0x44, 0x38),
+    'c':  (0x38, 0x44, 0x44, 0x44, 0x20),
+    'd':  (0x38, 0x44, 0x44, 0x48, 0x7F),
+    'e':  (0x38, 0x54, 0x54, 0x54, 0x18),
+    'f':  (0x08, 0x7E, 0x09, 0x01, 0x02),
+    'g':  (0x0C, 0x52, 0x52, 0x52, 0x3E),
+    'h':  (0x7F, 0x08, 0x04, 0x04, 0x78),
+    'i':  (0x00, 0x44, 0x7D, 0x40, 0x00),
+    'j':  (0x20, 0x40, 0x44, 0x3D, 0x00),
+    'k':  (0x7F, 0x10, 0x28, 0x44, 0x00),
+    'l':  (0x00, 0x41, 0x7F, 0x40, 0x00),
+    'm':  (0x7C, 0x04, 0x18, 0x04, 0x78),
+    'n':  (0x7C, 0x08, 0x04, 0x04, 0x78),
+    'o':  (0x38, 0x44, 0x44, 0x44, 0x38),
+    'p':  (0x7C, 0x14, 0x14, 0x14, 0x08),
+    'q':  (0x08, 0x14, 0x14, 0x18, 0x7C),
+    'r':  (0x7C, 0x08, 0x04, 0x04, 0x08),
+    's':  (0x48, 0x54, 0x54, 0x54, 0x20),
+    't':  (0x04, 0x3F, 0x44, 0x40, 0x20),
+    'u':  (0x3C, 0x40, 0x40, 0x20, 0x7C),
+    'v':  (0x1C, 0x20, 0x40, 0x20, 0x1C),
+    'w':  (0x3C, 0x40, 0x30, 0x40, 0x3C),
+    'x':  (0x44, 0x28, 0x10, 0x28, 0x44),
+    'y':  (0x0C, 0x50, 0x50, 0x50, 0x3C),
+    'z':  (0x44, 0x64, 0x54, 0x4C, 0x44),
+    '{':  (0x00, 0x08, 0x36, 0x41, 0x00),
+    '|':  (0x00, 0x00, 0x7F, 0x00, 0x00),
+    '}':  (0x00, 0x41, 0x36, 0x08, 0x00),
+    '~':  (0x10, 0x08, 0x08, 0x10, 0x08),
+}
+
+# Glyph cell width, DISPLAY_FONT_ADVANCE in display.h
+FONT_CELL = 6
+
+# Splash letter box (main/main.c draw_rmds_partial)
+LETTER_W = 22
+LETTER_H = 40
+
+
+class Canvas:
+    """Pixels painted relative to the draw position; later writes win."""
+
+    def __init__(self):
+        self.px = {}
+
+    def pixel(self, x, y, on=True):
+        self.px[(x, y)] = on
+
+    def rect(self, x0, y0, w, h, on=True):
+        for y in range(y0, y0 + h):
+            for x in range(x0, x0 + w):
+                self.pixel(x, y, on)
+
+    def hline(self, x0, x1, y, on=True):
+        if x0 > x1:
+            x0, x1 = x1, x0
+        self.rect(x0, y, x1 - x0 + 1, 1, on)
+
+
+def cdiv(a, b):
+    """C integer division (truncates toward zero)."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b > 0) else -q
+
+
+def letter_r(c, w, h):
+    stroke = max(cdiv(w, 4), 2)
+    right = w - 1
+    mid_y = cdiv(h, 2)
+    c.rect(0, 0, stroke, h)
+    c.rect(0, 0, w - stroke, stroke)
+    c.rect(0, mid_y - cdiv(stroke, 2), w - stroke, stroke)
+    c.rect(right - stroke + 1, stroke, stroke, mid_y - stroke)
+    for i in range(cdiv(h, 2)):
+        x = stroke + cdiv((w - 2 * stroke) * i, cdiv(h, 2))
+        c.rect(x, mid_y + i, stroke, 2)
+
+
+def letter_m(c, w, h):
+    stroke = max(cdiv(w, 5), 2)
+    right = w - 1
+    mid_x = cdiv(w, 2)
+    c.rect(0, 0, stroke, h)
+    c.rect(right - stroke + 1, 0, stroke, h)
+    for i in range(cdiv(h, 2)):
+        x_left = stroke + cdiv((mid_x - stroke) * i, cdiv(h, 2))
+        x_right = right - stroke - cdiv((right - stroke - mid_x) * i, cdiv(h, 2))
+        c.rect(x_left, i, stroke, 1)
+        c.rect(x_right, i, stroke, 1)
+
+
+def letter_d(c, w, h):
+    stroke = max(cdiv(w, 4), 2)
+    right = w - 1
+    bottom = h - 1
+    c.rect(0, 0, stroke, h)
+    c.rect(0, 0, w - stroke, stroke)
+    c.rect(0, bottom - stroke + 1, w - stroke, stroke)
+    c.rect(right - stroke + 1, stroke, stroke, h - 2 * stroke)
+
+
+def letter_s(c, w, h):
+    stroke = max(cdiv(w, 4), 2)
+    right = w - 1
+    bottom = h - 1
+    mid_y = cdiv(h, 2)
+    c.rect(cdiv(stroke, 2), 0, w - stroke, stroke)
+    c.rect(0, 0, stroke, mid_y)
+    c.rect(cdiv(stroke, 2), mid_y - cdiv(stroke, 2), w - stroke, stroke)
+    c.rect(right - stroke + 1, mid_y, stroke, bottom - mid_y + 1)
+    c.rect(cdiv(stroke, 2), bottom - stroke + 1, w - stroke, stroke)
+
+
+def rocket(c, big_flame):
+    # As the rocket example used to draw it at cx = cy = 0
+    body_w, body_h = 14, 26
+    x0 = -cdiv(body_w, 2)
+    y0 = -body_h
+
+    c.rect(x0, y0, body_w, body_h)
+
+    for i in range(5):
+        line_w = body_w - 2 * i
+        lx0 = -cdiv(line_w, 2)
+        c.hline(lx0, lx0 + line_w - 1, y0 - i - 1)
+
+    for i in range(5):
+        ly = -5 + i
+        c.hline(x0 - i, x0 - 1, ly)
+        c.hline(x0 + body_w, x0 + body_w + i, ly)
+
+    wy = -body_h + 6
+    for dx, dy in ((0, 0), (-1, 0), (1, 0), (0, -1), (0, 1)):
+        c.pixel(dx, wy + dy, False)
+
+    flame_h = 9 if big_flame else 5
+    for y in range(flame_h):
+        row_w = 8 - cdiv(y, 2)
+        flx0 = -cdiv(row_w, 2)
+        for x in range(row_w):
+            on = ((x + y) & 1) == (0 if big_flame else 1)
+            c.pixel(flx0 + x, 1 + y, on)
+
+
+def pack(canvas, opaque):
+    """Page-aligned bits (and mask when off pixels must be painted too)."""
+    xs = [x for x, _ in canvas.px]
+    ys = [y for _, y in canvas.px]
+    ox, oy = min(xs), min(ys)
+    w = max(xs) - ox + 1
+    pages = (max(ys) - oy) // 8 + 1
+    bits = [0] * (w * pages)
+    mask = [0] * (w * pages)
+    for (x, y), on in canvas.px.items():
+        col, row = x - ox, y - oy
+        i = (row // 8) * w + col
+        mask[i] |= 1 << (row & 7)
+        if on:
+            bits[i] |= 1 << (row & 7)
+    return ox, oy, w, pages, bits, (mask if opaque else None)
+
+
+def c_bytes(name, data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ', '.join('0x%02X' % b for b in data[i:i + 16]) + ',')
+    return 'static const uint8_t %s[%d] = {\n%s\n};\n' % (name, len(data), '\n'.join(lines))
+
+
+def emit_sprite(out, name, packed):
+    ox, oy, w, pages, bits, mask = packed
+    out.append(c_bytes(name + '_bits', bits))
+    if mask is not None:
+        out.append(c_bytes(name + '_mask', mask))
+    out.append('static const display_sprite_t %s = { %d, %d, %d, %d, %s_bits, %s };\n' % (
+        name, ox, oy, w, pages, name, (name + '_mask') if mask is not None else 'NULL'))
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('usage: gen_sprites.py <output header>')
+
+    out = ['''// rmds_sprites.h - generated by components/display/sprites/gen_sprites.py, do not edit
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "display.h"    // display_sprite_t
+''']
+
+    for name, fn in (('R', letter_r), ('M', letter_m), ('D', letter_d), ('S', letter_s)):
+        c = Canvas()
+        fn(c, LETTER_W, LETTER_H)
+        emit_sprite(out, 'rmds_sprite_letter_' + name, pack(c, False))
+
+    for name, big in (('big', True), ('small', False)):
+        c = Canvas()
+        rocket(c, big)
+        emit_sprite(out, 'rmds_sprite_rocket_' + name, pack(c, True))
+
+    # Each glyph as a whole DISPLAY_FONT_ADVANCE-column cell (spacing column
+    # included), so page-aligned text is a byte copy per character
+    # (display_text_page); the sprites for display_text() point into it
+    chars = sorted(FONT5X7)
+    assert len(chars) == ord(chars[-1]) - ord(chars[0]) + 1, 'font must be a contiguous range'
+    out.append('#define RMDS_FONT5X7_FIRST \'%s\'\n#define RMDS_FONT5X7_LAST  \'%s\'\n#define RMDS_FONT5X7_CELL  %d\n' % (
+        chars[0], chars[-1], FONT_CELL))
+    cells = []
+    sprites = []
+    for i, ch in enumerate(chars):
+        cell = FONT5X7[ch] + (0,) * (FONT_CELL - len(FONT5X7[ch]))
+        cells.append('    %s,   // %r\n' % (', '.join('0x%02X' % b for b in cell), ch))
+        sprites.append('    { 0, 0, 5, 1, &rmds_font5x7_cells[%d], NULL },   // %r\n' % (i * FONT_CELL, ch))
+    out.append('static const uint8_t rmds_font5x7_cells[%d] = {\n%s};\n' % (len(chars) * FONT_CELL, ''.join(cells)))
+    out.append('static const display_sprite_t rmds_font5x7[] = {\n%s};\n' % ''.join(sprites))
+
+    with open(sys.argv[1], 'w') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,429 @@
+// test_display_host.c
+//
+// Render tests for components/display on the linux target:
+//   1. the RMDS splash steps and a set of rocket frames, each compared with
+//      its golden PBM (main/golden); a mismatch is written next to the
+//      binary as <name>.actual.pbm
+//   2. a whole rocket pass through the flush service and the PBM backend,
+//      checking the changed-column diff leaves the panel equal to every frame
+//   3. the prerendered-cell text path against the blitted one, and a
+//      patch through display_begin_update() on top of the last frame
+//   4. the RMDS splash against the per-pixel reference it replaced (the
+//      procedural letters main.c drew before the sprites), step by step
+//   5. render time per frame for each scene and for that reference
+//
+// pytest_display_host.py checks the summary line, the benchmark figures
+// and the speedup over the reference. To accept an intended change of the artwork, copy the
+// .actual.pbm files over the goldens.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_timer.h"
+
+#include "display.h"
+#include "display_backend.h"
+#include "display_scenes.h"
+
+#define BENCH_FRAMES      2000
+#define BENCH_ROUNDS      10    // the fastest round counts
+#define FLUSH_TASK_PRIO   1
+#define FLUSH_WAIT_MS     1000
+
+// Set to save every flushed frame of test 2 as frame_NNNN.pbm
+#define PBM_DIR_ENV       "DISPLAY_PBM_DIR"
+
+#define GOLDEN(name)                                                          \
+    extern const uint8_t golden_##name##_start[] asm("_binary_" #name "_pbm_start"); \
+    extern const uint8_t golden_##name##_end[]   asm("_binary_" #name "_pbm_end")
+
+GOLDEN(rmds_0);
+GOLDEN(rmds_1);
+GOLDEN(rmds_2);
+GOLDEN(rmds_3);
+GOLDEN(rmds_4);
+GOLDEN(rocket_00);
+GOLDEN(rocket_01);
+GOLDEN(rocket_21);
+GOLDEN(rocket_42);
+GOLDEN(rocket_83);
+
+typedef struct {
+    const char *name;
+    void (*draw)(uint8_t *fb, int arg);
+    int arg;
+    const uint8_t *golden;
+    const uint8_t *golden_end;
+} render_case_t;
+
+#define CASE(name, draw, arg)  { #name, draw, arg, golden_##name##_start, golden_##name##_end }
+
+static const render_case_t cases[] = {
+    CASE(rmds_0, display_scene_rmds, 0),
+    CASE(rmds_1, display_scene_rmds, 1),
+    CASE(rmds_2, display_scene_rmds, 2),
+    CASE(rmds_3, display_scene_rmds, 3),
+    CASE(rmds_4, display_scene_rmds, 4),
+    CASE(rocket_00, display_scene_rocket, 0),
+    CASE(rocket_01, display_scene_rocket, 1),
+    CASE(rocket_21, display_scene_rocket, 21),
+    CASE(rocket_42, display_scene_rocket, 42),
+    CASE(rocket_83, display_scene_rocket, 83),
+};
+
+static uint32_t s_frame[DISPLAY_FRAME_BYTES / 4];
+static int s_passed = 0;
+static int s_failed = 0;
+
+static void check(bool ok, const char *name)
+{
+    printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+    if (ok) {
+        s_passed++;
+    } else {
+        s_failed++;
+    }
+}
+
+static void test_golden_images(void)
+{
+    uint8_t *fb = (uint8_t *)s_frame;
+    static uint8_t pbm[32 + DISPLAY_FRAME_BYTES];
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const render_case_t *c = &cases[i];
+        c->draw(fb, c->arg);
+
+        size_t len = display_pbm_encode(fb, pbm, sizeof(pbm));
+        bool ok = len == (size_t)(c->golden_end - c->golden) &&
+                  memcmp(pbm, c->golden, len) == 0;
+        if (!ok) {
+            char path[64];
+            snprintf(path, sizeof(path), "%s.actual.pbm", c->name);
+            display_pbm_save(fb, path);
+        }
+        check(ok, c->name);
+    }
+}
+
+// Every frame of a rocket pass goes through the double buffer and the
+// diff; the panel image must match what was drawn each time
+static void test_flush_path(void)
+{
+    static uint8_t expected[DISPLAY_FRAME_BYTES];
+    display_backend_t *backend = NULL;
+
+    display_backend_pbm(&backend, getenv(PBM_DIR_ENV));
+    if (display_start(backend, FLUSH_TASK_PRIO) != ESP_OK) {
+        check(false, "flush_path (start)");
+        return;
+    }
+
+    bool ok = true;
+    for (int frame = 0; frame < DISPLAY_ROCKET_FRAMES && ok; frame++) {
+        uint32_t flushed = display_frames_flushed();
+        uint8_t *fb = display_begin_frame();
+        display_scene_rocket(fb, frame);
+        memcpy(expected, fb, sizeof(expected));
+        display_submit();
+
+        for (int waited = 0; display_frames_flushed() == flushed; waited++) {
+            if (waited == FLUSH_WAIT_MS) {
+                printf("frame %d never flushed\n", frame);
+                ok = false;
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+        if (ok && memcmp(display_backend_mem_frame(), expected, sizeof(expected)) != 0) {
+            printf("panel differs from frame %d\n", frame);
+            ok = false;
+        }
+    }
+    check(ok, "flush_path");
+}
+
+// On a page boundary and a blank background the opaque cells must come out
+// exactly like the blitted glyphs, for every character of the font
+static void test_text_page(void)
+{
+    static uint8_t blitted[DISPLAY_FRAME_BYTES];
+    uint8_t *fb = (uint8_t *)s_frame;
+    char line[DISPLAY_WIDTH / DISPLAY_FONT_ADVANCE + 2];
+    bool ok = true;
+
+    for (int first = ' '; first <= '~' && ok; first += sizeof(line) - 1) {
+        // Padded with blanks to the full width, from x = -3 so the first
+        // and last cells are both clipped
+        for (size_t n = 0; n < sizeof(line) - 1; n++) {
+            line[n] = first + (int)n <= '~' ? (char)(first + n) : ' ';
+        }
+        line[sizeof(line) - 1] = '\0';
+
+        display_clear(blitted);
+        display_text(blitted, -3, 24, line);
+
+        // Lit background: the cells have to overwrite all of it
+        memset(fb, 0xFF, DISPLAY_FRAME_BYTES);
+        display_text_page(fb, -3, 3, line);
+        memset(fb, 0x00, 3 * DISPLAY_WIDTH);
+        memset(fb + 4 * DISPLAY_WIDTH, 0x00, 4 * DISPLAY_WIDTH);
+        ok = memcmp(fb, blitted, DISPLAY_FRAME_BYTES) == 0;
+    }
+    check(ok, "text_page");
+}
+
+// A patched frame keeps everything it didn't touch from the last one
+static void test_begin_update(void)
+{
+    static uint8_t expected[DISPLAY_FRAME_BYTES];
+
+    display_scene_rocket(expected, 42);
+    memcpy(display_begin_frame(), expected, sizeof(expected));
+    display_submit();
+
+    uint8_t *fb = display_begin_update();
+    bool ok = memcmp(fb, expected, sizeof(expected)) == 0;
+    display_text_page(fb, 0, 7, "OK");
+    display_text_page(expected, 0, 7, "OK");
+    ok = ok && memcmp(fb, expected, sizeof(expected)) == 0;
+    display_submit();
+
+    check(ok, "begin_update");
+}
+
+// ---- Per-pixel reference ----
+// The splash as main.c drew it before gen_sprites.py and the word fills:
+// block letters built from rectangles, each rectangle set pixel by pixel
+// with the 180° rotation done in software. Test-only, kept as the baseline
+// the sprites are checked and timed against.
+
+static uint8_t *s_ref_fb = NULL;
+
+static void fill_rect_reference(int x0, int y0, int w, int h, bool on)
+{
+    for (int y = y0; y < y0 + h; y++) {
+        for (int x = x0; x < x0 + w; x++) {
+            if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) {
+                continue;
+            }
+            int hw_x = (DISPLAY_WIDTH  - 1) - x;
+            int hw_y = (DISPLAY_HEIGHT - 1) - y;
+            uint8_t bit_mask = 1 << (hw_y & 7);
+            if (on) {
+                s_ref_fb[(hw_y / 8) * DISPLAY_WIDTH + hw_x] |= bit_mask;
+            } else {
+                s_ref_fb[(hw_y / 8) * DISPLAY_WIDTH + hw_x] &= ~bit_mask;
+            }
+        }
+    }
+}
+
+// Block-style R
+static void draw_letter_R(int x0, int y0, int w, int h)
+{
+    int stroke = w / 4;
+    if (stroke < 2) stroke = 2;
+
+    int right = x0 + w - 1;
+    int mid_y = y0 + h / 2;
+
+    // Left vertical bar
+    fill_rect_reference(x0, y0, stroke, h, true);
+
+    // Top horizontal bar
+    fill_rect_reference(x0, y0, w - stroke, stroke, true);
+
+    // Middle bar
+    fill_rect_reference(x0, mid_y - stroke / 2, w - stroke, stroke, true);
+
+    // Right vertical of the upper loop
+    fill_rect_reference(right - stroke + 1, y0 + stroke,
+                        stroke, mid_y - y0 - stroke, true);
+
+    // Diagonal leg
+    for (int i = 0; i < h / 2; i++) {
+        int y = mid_y + i;
+        int x = x0 + stroke + (w - 2 * stroke) * i / (h / 2);
+        fill_rect_reference(x, y, stroke, 2, true);
+    }
+}
+
+// Block-style M
+static void draw_letter_M(int x0, int y0, int w, int h)
+{
+    int stroke = w / 5;
+    if (stroke < 2) stroke = 2;
+
+    int right = x0 + w - 1;
+    int mid_x = x0 + w / 2;
+
+    // Two vertical bars
+    fill_rect_reference(x0, y0, stroke, h, true);
+    fill_rect_reference(right - stroke + 1, y0, stroke, h, true);
+
+    // Diagonals to the center
+    for (int i = 0; i < h / 2; i++) {
+        int y = y0 + i;
+        int x_left  = x0 + stroke + (mid_x - x0 - stroke) * i / (h / 2);
+        int x_right = right - stroke - (right - stroke - mid_x) * i / (h / 2);
+
+        fill_rect_reference(x_left,  y, stroke, 1, true);
+        fill_rect_reference(x_right, y, stroke, 1, true);
+    }
+}
+
+// Block-style D
+static void draw_letter_D(int x0, int y0, int w, int h)
+{
+    int stroke = w / 4;
+    if (stroke < 2) stroke = 2;
+
+    int right  = x0 + w - 1;
+    int bottom = y0 + h - 1;
+
+    // Left vertical bar
+    fill_rect_reference(x0, y0, stroke, h, true);
+    // Top bar
+    fill_rect_reference(x0, y0, w - stroke, stroke, true);
+    // Bottom bar
+    fill_rect_reference(x0, bottom - stroke + 1, w - stroke, stroke, true);
+    // Right vertical bar
+    fill_rect_reference(right - stroke + 1, y0 + stroke,
+                        stroke, h - 2 * stroke, true);
+}
+
+// Block-style S
+static void draw_letter_S(int x0, int y0, int w, int h)
+{
+    int stroke = w / 4;
+    if (stroke < 2) stroke = 2;
+
+    int right  = x0 + w - 1;
+    int bottom = y0 + h - 1;
+    int mid_y  = y0 + h / 2;
+
+    // Top bar
+    fill_rect_reference(x0 + stroke / 2, y0, w - stroke, stroke, true);
+    // Upper left vertical
+    fill_rect_reference(x0, y0, stroke, mid_y - y0, true);
+
+    // Middle bar
+    fill_rect_reference(x0 + stroke / 2, mid_y - stroke / 2,
+                        w - stroke, stroke, true);
+
+    // Lower right vertical
+    fill_rect_reference(right - stroke + 1, mid_y,
+                        stroke, bottom - mid_y + 1, true);
+    // Bottom bar
+    fill_rect_reference(x0 + stroke / 2, bottom - stroke + 1,
+                        w - stroke, stroke, true);
+}
+
+// Same arguments as display_scene_rmds(), output rotated 180°
+static void draw_rmds_reference(uint8_t *fb, int letters_to_show)
+{
+    s_ref_fb = fb;
+    display_clear(fb);
+    fill_rect_reference(0, 0, DISPLAY_WIDTH, 1, true);
+    fill_rect_reference(0, DISPLAY_HEIGHT - 1, DISPLAY_WIDTH, 1, true);
+    fill_rect_reference(0, 0, 1, DISPLAY_HEIGHT, true);
+    fill_rect_reference(DISPLAY_WIDTH - 1, 0, 1, DISPLAY_HEIGHT, true);
+
+    int total_w  = 100;
+    int base_x   = (DISPLAY_WIDTH - total_w) / 2;
+    int base_y   = 10;
+    int letter_w = 22;
+    int letter_h = 40;
+    int gap      = 3;
+
+    int x = base_x;
+
+    if (letters_to_show >= 1) {
+        draw_letter_R(x, base_y, letter_w, letter_h);
+    }
+    x += letter_w + gap;
+
+    if (letters_to_show >= 2) {
+        draw_letter_M(x, base_y, letter_w, letter_h);
+    }
+    x += letter_w + gap;
+
+    if (letters_to_show >= 3) {
+        draw_letter_D(x, base_y, letter_w, letter_h);
+    }
+    x += letter_w + gap;
+
+    if (letters_to_show >= 4) {
+        draw_letter_S(x, base_y, letter_w, letter_h);
+    }
+}
+
+// Every splash step from the sprites must equal the reference turned back
+static void test_rmds_reference(void)
+{
+    static uint8_t reference[DISPLAY_FRAME_BYTES];
+    uint8_t *fb = (uint8_t *)s_frame;
+    bool ok = true;
+
+    for (int letters = 0; letters <= 4 && ok; letters++) {
+        draw_rmds_reference(reference, letters);
+        display_scene_rmds(fb, letters);
+
+        for (size_t i = 0; i < sizeof(reference); i++) {
+            uint8_t b = reference[sizeof(reference) - 1 - i];
+            b = (uint8_t)((b * 0x0202020202ULL & 0x010884422010ULL) % 1023);   // bit reverse
+            if (b != fb[i]) {
+                printf("rmds step %d differs from the reference at byte %u\n",
+                       letters, (unsigned int)i);
+                ok = false;
+                break;
+            }
+        }
+    }
+    check(ok, "rmds_reference");
+}
+
+static double bench(const char *name, void (*draw)(uint8_t *fb, int arg), int args)
+{
+    uint8_t *fb = (uint8_t *)s_frame;
+    int64_t best = INT64_MAX;
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < BENCH_FRAMES; i++) {
+            draw(fb, i % args);
+        }
+        int64_t us = esp_timer_get_time() - start;
+        if (us < best) {
+            best = us;
+        }
+    }
+    double us = (double)best / BENCH_FRAMES;
+
+    printf("BENCH %s: %.2f us/frame\n", name, us);
+    return us;
+}
+
+void app_main(void)
+{
+    test_golden_images();
+    test_flush_path();
+    test_text_page();
+    test_begin_update();
+    test_rmds_reference();
+
+    double ref_us = bench("rmds_reference", draw_rmds_reference, 5);
+    double rmds_us = bench("rmds", display_scene_rmds, 5);
+    bench("rocket", display_scene_rocket, DISPLAY_ROCKET_FRAMES);
+    printf("BENCH rmds speedup: %.1fx\n", rmds_us > 0 ? ref_us / rmds_us : 0.0);
+
+    printf("Display host tests: %d passed, %d failed\n", s_passed, s_failed);
+    fflush(stdout);
+    exit(s_failed ? 1 : 0);
+}
@@ -0,0 +1,37 @@
+# SPDX-License-Identifier: CC0-1.0
+import logging
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+
+# Render time ceilings on the host (us/frame). Today's word-wise raster and
+# sprites take about a microsecond, so crossing these means rendering regressed.
+BENCH_LIMIT_US = {
+    'rmds': 50.0,
+    'rocket': 50.0,
+}
+# The RMDS splash against the per-pixel reference it replaced, both timed in
+# the same run. Measured about 4.5x in the default (-Og) build, 2x at -O2.
+RMDS_MIN_SPEEDUP = 1.5
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_display_host(dut: IdfDut) -> None:
+    dut.expect_exact('PASS rmds_reference')
+    ref_us = float(dut.expect(r'BENCH rmds_reference: ([0-9.]+) us/frame').group(1))
+
+    bench_us = {}
+    for name, limit in BENCH_LIMIT_US.items():
+        us = float(dut.expect(rf'BENCH {name}: ([0-9.]+) us/frame').group(1))
+        logging.info(f'{name}: {us:.2f} us/frame (limit {limit})')
+        assert us < limit, f'{name} rendering takes {us:.2f} us/frame, limit {limit}'
+        bench_us[name] = us
+
+    speedup = ref_us / bench_us['rmds']
+    logging.info(f'rmds: per-pixel reference {ref_us:.2f} us/frame, {speedup:.1f}x slower')
+    assert speedup >= RMDS_MIN_SPEEDUP, \
+        f'rmds is only {speedup:.1f}x faster than the per-pixel reference, expected {RMDS_MIN_SPEEDUP}x'
+
+    dut.expect(r'Display host tests: \d+ passed, 0 failed')
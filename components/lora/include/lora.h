@@ -2,11 +2,32 @@
 #ifndef __LORA_H__
 #define __LORA_H__
 
+#include <stdint.h>
+
+typedef struct {
+   uint64_t sleep_us;
+   uint64_t standby_us;
+   uint64_t tx_us;
+   uint64_t rx_us;
+   uint64_t cad_us;
+   uint32_t restores;   // register restores after the radio lost its config
+} lora_mode_times_t;
+
+typedef struct {
+   uint32_t packets;     // sends that listened first (CONFIG_LORA_LBT)
+   uint32_t clear_first; // channel clear on the first listen
+   uint32_t busy_rssi;   // listens that heard energy above the threshold
+   uint32_t busy_cad;    // listens where CAD found a LoRa preamble
+   uint32_t forced;      // sent anyway after CONFIG_LORA_LBT_MAX_BACKOFFS
+   uint64_t wait_us;     // jitter and backoff time
+} lora_lbt_stats_t;
+
 void lora_reset(void);
 void lora_explicit_header_mode(void);
 void lora_implicit_header_mode(int size);
 void lora_idle(void);
 void lora_sleep(void); 
+void lora_auto_sleep(int enable);
 void lora_receive(void);
 void lora_set_tx_power(int level);
 void lora_set_frequency(long frequency);
@@ -19,9 +40,14 @@ void lora_enable_crc(void);
 void lora_disable_crc(void);
 int lora_init(void);
 void lora_send_packet(uint8_t *buf, int size);
+int lora_cad(void);
 int lora_receive_packet(uint8_t *buf, int size);
 int lora_received(void);
+uint32_t lora_crc_error_count(void);
+void lora_get_mode_times(lora_mode_times_t *out);
 int lora_packet_rssi(void);
+int lora_channel_rssi(void);
+void lora_get_lbt_stats(lora_lbt_stats_t *out);
 float lora_packet_snr(void);
 void lora_close(void);
 int lora_initialized(void);
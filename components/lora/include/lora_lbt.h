@@ -0,0 +1,18 @@
+#ifndef __LORA_LBT_H__
+#define __LORA_LBT_H__
+
+#include <stdint.h>
+
+/*
+ * Listen-before-talk backoff. No radio access in here, so the host
+ * simulation (test_apps/lbt_sim) draws its delays from the same code
+ * as the driver.
+ */
+
+/* The backoff window stops doubling after this many busy listens */
+#define LORA_LBT_MAX_EXP               6
+
+uint32_t lora_lbt_rand(uint32_t *state);
+uint32_t lora_lbt_backoff_us(uint32_t *state, int busy, uint32_t slot_us);
+
+#endif
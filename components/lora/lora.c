@@ -1,12 +1,19 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_rom_sys.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "driver/spi_master.h"
 #include "soc/gpio_struct.h"
 #include "driver/gpio.h"
 #include <string.h>
 
+#include "lora.h"
+#include "lora_lbt.h"
+
 /* Compatibility shim for different ESP-IDF versions / targets */
 #ifndef VSPI_HOST
 #define VSPI_HOST SPI3_HOST   // On newer IDF, VSPI_HOST is replaced by SPI3_HOST
@@ -30,6 +37,7 @@
 #define REG_RX_NB_BYTES                0x13
 #define REG_PKT_SNR_VALUE              0x19
 #define REG_PKT_RSSI_VALUE             0x1a
+#define REG_RSSI_VALUE                 0x1b
 #define REG_MODEM_CONFIG_1             0x1d
 #define REG_MODEM_CONFIG_2             0x1e
 #define REG_PREAMBLE_MSB               0x20
@@ -52,6 +60,7 @@
 #define MODE_TX                        0x03
 #define MODE_RX_CONTINUOUS             0x05
 #define MODE_RX_SINGLE                 0x06
+#define MODE_CAD                       0x07
 
 /*
  * PA configuration
@@ -61,6 +70,8 @@
 /*
  * IRQ masks
  */
+#define IRQ_CAD_DETECTED_MASK          0x01
+#define IRQ_CAD_DONE_MASK              0x04
 #define IRQ_TX_DONE_MASK               0x08
 #define IRQ_PAYLOAD_CRC_ERROR_MASK     0x20
 #define IRQ_RX_DONE_MASK               0x40
@@ -69,11 +80,51 @@
 #define PA_OUTPUT_PA_BOOST_PIN         1
 
 #define TIMEOUT_RESET                  100
+#define TIMEOUT_CAD_US                 50000
+
+/*
+ * Listen before talk: RSSI needs this long in RX before it reflects the
+ * channel, and the wideband RSSI noise bits are read this far apart.
+ */
+#define LBT_RSSI_SETTLE_US             1000
+#define LBT_SEED_BIT_US                1000
+#define LBT_CLEAR                      0
+#define LBT_BUSY_RSSI                  1
+#define LBT_BUSY_CAD                   2
+
+/*
+ * Configuration registers kept in the shadow copy (one bit per address).
+ */
+#define SHADOW_REGS ((1ULL << REG_FRF_MSB) | (1ULL << REG_FRF_MID) | (1ULL << REG_FRF_LSB) | \
+                     (1ULL << REG_PA_CONFIG) | (1ULL << REG_LNA) | \
+                     (1ULL << REG_FIFO_TX_BASE_ADDR) | (1ULL << REG_FIFO_RX_BASE_ADDR) | \
+                     (1ULL << REG_MODEM_CONFIG_1) | (1ULL << REG_MODEM_CONFIG_2) | \
+                     (1ULL << REG_PREAMBLE_MSB) | (1ULL << REG_PREAMBLE_LSB) | \
+                     (1ULL << REG_PAYLOAD_LENGTH) | (1ULL << REG_MODEM_CONFIG_3) | \
+                     (1ULL << REG_DETECTION_OPTIMIZE) | (1ULL << REG_DETECTION_THRESHOLD) | \
+                     (1ULL << REG_SYNC_WORD))
 
 static spi_device_handle_t __spi;
 
 static int __implicit;
 static long __frequency;
+static volatile uint32_t __crc_errors;
+
+static uint8_t __shadow[64];
+static uint64_t __shadow_valid;
+static int __sleeping;
+static int __auto_sleep;
+static uint32_t __restores;
+
+static int __mode = -1;
+static int64_t __mode_since;
+static uint64_t __mode_us[8];
+
+static lora_lbt_stats_t __lbt;
+#if CONFIG_LORA_LBT
+/* Backoff generator, seeded from radio noise once per cold boot */
+RTC_DATA_ATTR static uint32_t __lbt_rng;
+#endif
 
 /**
  * Write a value to a register.
@@ -96,6 +147,11 @@ lora_write_reg(int reg, int val)
    gpio_set_level(CONFIG_CS_GPIO, 0);
    spi_device_transmit(__spi, &t);
    gpio_set_level(CONFIG_CS_GPIO, 1);
+
+   if (reg < 64 && ((SHADOW_REGS >> reg) & 1)) {
+      __shadow[reg] = (uint8_t)val;
+      __shadow_valid |= 1ULL << reg;
+   }
 }
 
 /**
@@ -122,6 +178,73 @@ lora_read_reg(int reg)
    return in[1];
 }
 
+/**
+ * Account the time spent in the previous operating mode and record
+ * the new one. Used directly when the radio changes mode by itself
+ * (TX done, CAD done).
+ * @param mode MODE_* value the radio is now in.
+ */
+static void
+lora_note_mode(int mode)
+{
+   int64_t now = esp_timer_get_time();
+   if (__mode >= 0) __mode_us[__mode] += now - __mode_since;
+   __mode = mode;
+   __mode_since = now;
+}
+
+/**
+ * Switch the operating mode (LoRa mode bit always set).
+ * @param mode MODE_* value.
+ */
+static void
+lora_set_mode(int mode)
+{
+   lora_note_mode(mode);
+   lora_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | mode);
+}
+
+/**
+ * Write every shadowed configuration register back to the radio.
+ * Must be called in sleep mode so the LoRa mode bit can be set.
+ */
+static void
+lora_restore_registers(void)
+{
+   lora_set_mode(MODE_SLEEP);
+   for (int reg = 0; reg < 64; reg++) {
+      if ((__shadow_valid >> reg) & 1) lora_write_reg(reg, __shadow[reg]);
+   }
+   __restores++;
+}
+
+/**
+ * Check a register against its shadow copy.
+ * @param reg Register index.
+ * @return Non-zero if the register was configured and no longer matches.
+ */
+static int
+lora_shadow_lost(int reg)
+{
+   return ((__shadow_valid >> reg) & 1) && lora_read_reg(reg) != __shadow[reg];
+}
+
+/**
+ * Leave sleep mode bookkeeping before any other operation.
+ * Configuration survives SLEEP, but not a reset or brown-out of the
+ * radio, so spot-check two registers and restore all of them on mismatch.
+ */
+static void
+lora_wake(void)
+{
+   if (!__sleeping) return;
+   __sleeping = 0;
+
+   if (lora_shadow_lost(REG_SYNC_WORD) || lora_shadow_lost(REG_MODEM_CONFIG_1)) {
+      lora_restore_registers();
+   }
+}
+
 /**
  * Perform physical reset on the Lora chip
  */
@@ -165,17 +288,31 @@ lora_implicit_header_mode(int size)
 void 
 lora_idle(void)
 {
-   lora_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_STDBY);
+   lora_wake();
+   lora_set_mode(MODE_STDBY);
 }
 
 /**
  * Sets the radio transceiver in sleep mode.
- * Low power consumption and FIFO is lost.
+ * Low power consumption and FIFO is lost. Configuration registers are
+ * checked and restored by the next call that wakes the radio.
  */
 void 
 lora_sleep(void)
 { 
-   lora_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_SLEEP);
+   lora_set_mode(MODE_SLEEP);
+   __sleeping = 1;
+}
+
+/**
+ * Put the radio to sleep after every transmission instead of leaving it
+ * in standby. The next send wakes it again.
+ * @param enable Non-zero to enable.
+ */
+void
+lora_auto_sleep(int enable)
+{
+   __auto_sleep = enable;
 }
 
 /**
@@ -185,7 +322,8 @@ lora_sleep(void)
 void 
 lora_receive(void)
 {
-   lora_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_CONTINUOUS);
+   lora_wake();
+   lora_set_mode(MODE_RX_CONTINUOUS);
 }
 
 /**
@@ -356,6 +494,9 @@ lora_init(void)
     * Perform hardware reset.
     */
    lora_reset();
+   __shadow_valid = 0;
+   __sleeping = 0;
+   memset(&__lbt, 0, sizeof(__lbt));
 
    /*
     * Check version.
@@ -383,6 +524,104 @@ lora_init(void)
    return 1;
 }
 
+/**
+ * Return the RSSI of the channel right now, in dBm.
+ * Only meaningful while the radio is receiving.
+ */
+int
+lora_channel_rssi(void)
+{
+   return (lora_read_reg(REG_RSSI_VALUE) - (__frequency < 868E6 ? 164 : 157));
+}
+
+#if CONFIG_LORA_LBT
+/**
+ * Seed the backoff generator. Bit 0 of the wideband RSSI is thermal
+ * noise, so nodes powered up together by the same switch still draw
+ * different delays. The radio must be receiving. Takes about 32 ms.
+ */
+static void
+lora_lbt_seed(void)
+{
+   uint32_t seed = 0;
+   for (int i = 0; i < 32; i++) {
+      esp_rom_delay_us(LBT_SEED_BIT_US);
+      seed = (seed << 1) | (lora_read_reg(REG_RSSI_WIDEBAND) & 0x01);
+   }
+   __lbt_rng = seed ? seed : 1;   /* xorshift never leaves zero */
+}
+
+/**
+ * Listen to the channel once: sample the RSSI for
+ * CONFIG_LORA_LBT_LISTEN_US, then (with CONFIG_LORA_LBT_CAD) run a CAD,
+ * which also catches LoRa packets too weak to raise the RSSI.
+ * @return LBT_CLEAR, LBT_BUSY_RSSI or LBT_BUSY_CAD.
+ */
+static int
+lora_lbt_listen(void)
+{
+   lora_receive();
+   esp_rom_delay_us(LBT_RSSI_SETTLE_US);
+
+   int busy = 0;
+   int64_t end = esp_timer_get_time() + CONFIG_LORA_LBT_LISTEN_US;
+   do {
+      if (lora_channel_rssi() > CONFIG_LORA_LBT_THRESHOLD_DBM) busy = 1;
+   } while (!busy && esp_timer_get_time() < end);
+   if (busy) return LBT_BUSY_RSSI;
+
+#if CONFIG_LORA_LBT_CAD
+   if (lora_cad()) return LBT_BUSY_CAD;
+#endif
+   return LBT_CLEAR;
+}
+
+/**
+ * Wait a random jitter, then listen until the channel is clear, backing
+ * off for a random, doubling time after each busy listen. Gives up and
+ * lets the packet go after CONFIG_LORA_LBT_MAX_BACKOFFS busy listens.
+ */
+static void
+lora_lbt_wait_clear(void)
+{
+   const uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+
+   if (__lbt_rng == 0) {
+      lora_receive();
+      lora_lbt_seed();
+   }
+
+   __lbt.packets++;
+   for (int busy = 0; ; busy++) {
+      /*
+       * Whole ticks sleep (the radio too, if it sleeps between sends),
+       * the rest is spun so short jitters keep their resolution.
+       */
+      uint32_t wait = lora_lbt_backoff_us(&__lbt_rng, busy, CONFIG_LORA_LBT_SLOT_MS * 1000);
+      if (wait >= tick_us) {
+         if (__auto_sleep) lora_sleep();
+         else lora_idle();
+         vTaskDelay(wait / tick_us);
+      }
+      esp_rom_delay_us(wait % tick_us);
+      __lbt.wait_us += wait;
+
+      int result = lora_lbt_listen();
+      if (result == LBT_CLEAR) {
+         if (busy == 0) __lbt.clear_first++;
+         return;
+      }
+      if (result == LBT_BUSY_RSSI) __lbt.busy_rssi++;
+      else __lbt.busy_cad++;
+
+      if (busy >= CONFIG_LORA_LBT_MAX_BACKOFFS) {
+         __lbt.forced++;
+         return;
+      }
+   }
+}
+#endif
+
 /**
  * Send a packet.
  * @param buf Data to be sent
@@ -391,6 +630,10 @@ lora_init(void)
 void 
 lora_send_packet(uint8_t *buf, int size)
 {
+#if CONFIG_LORA_LBT
+   lora_lbt_wait_clear();
+#endif
+
    /*
     * Transfer data to radio.
     */
@@ -405,11 +648,41 @@ lora_send_packet(uint8_t *buf, int size)
    /*
     * Start transmission and wait for conclusion.
     */
-   lora_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_TX);
+   lora_set_mode(MODE_TX);
    while((lora_read_reg(REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) == 0)
       vTaskDelay(2);
 
+   lora_note_mode(MODE_STDBY);   // radio drops back to standby by itself
    lora_write_reg(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+
+   if (__auto_sleep) lora_sleep();
+}
+
+/**
+ * Run one Channel Activity Detection.
+ * Takes roughly (2^SF + 32) / BW seconds (about 1.3 ms at SF7/125 kHz),
+ * after which the radio is back in standby.
+ * @return 1 if a LoRa preamble was detected, 0 otherwise.
+ */
+int
+lora_cad(void)
+{
+   lora_idle();
+   lora_write_reg(REG_IRQ_FLAGS, IRQ_CAD_DONE_MASK | IRQ_CAD_DETECTED_MASK);
+   lora_set_mode(MODE_CAD);
+
+   int irq;
+   int64_t deadline = esp_timer_get_time() + TIMEOUT_CAD_US;
+   while(((irq = lora_read_reg(REG_IRQ_FLAGS)) & IRQ_CAD_DONE_MASK) == 0) {
+      if (esp_timer_get_time() > deadline) {
+         lora_idle();
+         return 0;
+      }
+   }
+
+   lora_note_mode(MODE_STDBY);
+   lora_write_reg(REG_IRQ_FLAGS, IRQ_CAD_DONE_MASK | IRQ_CAD_DETECTED_MASK);
+   return (irq & IRQ_CAD_DETECTED_MASK) != 0;
 }
 
 /**
@@ -429,7 +702,10 @@ lora_receive_packet(uint8_t *buf, int size)
    int irq = lora_read_reg(REG_IRQ_FLAGS);
    lora_write_reg(REG_IRQ_FLAGS, irq);
    if((irq & IRQ_RX_DONE_MASK) == 0) return 0;
-   if(irq & IRQ_PAYLOAD_CRC_ERROR_MASK) return 0;
+   if(irq & IRQ_PAYLOAD_CRC_ERROR_MASK) {
+      __crc_errors++;
+      return 0;
+   }
 
    /*
     * Find packet size.
@@ -459,6 +735,46 @@ lora_received(void)
    return 0;
 }
 
+/**
+ * Return the number of packets dropped because of a payload CRC error.
+ */
+uint32_t
+lora_crc_error_count(void)
+{
+   return __crc_errors;
+}
+
+/**
+ * Return the time spent in each operating mode since lora_init(),
+ * including the mode the radio is in right now.
+ * @param out Filled with per-mode totals in microseconds.
+ */
+void
+lora_get_mode_times(lora_mode_times_t *out)
+{
+   uint64_t us[8];
+   memcpy(us, __mode_us, sizeof(us));
+   if (__mode >= 0) us[__mode] += esp_timer_get_time() - __mode_since;
+
+   out->sleep_us = us[MODE_SLEEP];
+   out->standby_us = us[MODE_STDBY];
+   out->tx_us = us[MODE_TX];
+   out->rx_us = us[MODE_RX_CONTINUOUS] + us[MODE_RX_SINGLE];
+   out->cad_us = us[MODE_CAD];
+   out->restores = __restores;
+}
+
+/**
+ * Return listen-before-talk counters since lora_init() (all zero when
+ * CONFIG_LORA_LBT is off).
+ * @param out Filled with the counters.
+ */
+void
+lora_get_lbt_stats(lora_lbt_stats_t *out)
+{
+   *out = __lbt;
+}
+
 /**
  * Return last packet's RSSI.
  */
@@ -0,0 +1,34 @@
+#include "lora_lbt.h"
+
+/**
+ * Next number from a xorshift32 generator.
+ * @param state Generator state, must not be zero.
+ * @return Pseudo-random 32-bit value.
+ */
+uint32_t
+lora_lbt_rand(uint32_t *state)
+{
+   uint32_t x = *state;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   return *state = x;
+}
+
+/**
+ * Random wait before the next listen, binary exponential: uniform in
+ * [0, slot) before the first listen of a packet, so nodes that woke
+ * together don't all listen at the same instant, then [0, slot << busy)
+ * after each busy one.
+ * @param state Generator state (see lora_lbt_rand).
+ * @param busy Busy listens so far for this packet.
+ * @param slot_us Backoff slot in microseconds.
+ * @return Wait in microseconds.
+ */
+uint32_t
+lora_lbt_backoff_us(uint32_t *state, int busy, uint32_t slot_us)
+{
+   if (busy > LORA_LBT_MAX_EXP) busy = LORA_LBT_MAX_EXP;
+   uint32_t window = slot_us << busy;
+   return window ? lora_lbt_rand(state) % window : 0;
+}
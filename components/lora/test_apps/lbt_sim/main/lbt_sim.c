@@ -0,0 +1,293 @@
+// lbt_sim.c
+//
+// Channel-access simulation for the listen-before-talk option: N sensor
+// nodes in one collision domain (everyone hears everyone, no capture),
+// each producing a packet every SIM_PERIOD_US from a common power-up, with
+// a few ppm of crystal drift. Each node count is run twice, sending
+// blindly (what lora_send_packet() does without CONFIG_LORA_LBT) and with
+// listen before talk, whose delays come from lora_lbt_backoff_us() as on
+// the radio.
+//
+// A packet is delivered if no other transmission overlaps it. Packets
+// wait in a small queue, as readings wait in the node's RTC ring; when it
+// is full the oldest is dropped.
+//
+// pytest_lbt_sim.py checks the delivery lines.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lora_lbt.h"
+
+// Traffic and radio timing (SF7, 125 kHz, CR 4/5, 8-symbol preamble)
+#define SIM_PERIOD_US        400000
+#define SIM_PAYLOAD_BYTES    48
+#define SIM_PERIODS          2000
+#define SIM_DRIFT_PPM        20
+#define SIM_START_SPREAD_US  1000    // power-up to first packet, all nodes
+#define SIM_QUEUE_MAX        4
+
+// Listen before talk, as the Kconfig defaults: RSSI settle + listen, then
+// a CAD of (2^SF + 32) / BW. Filling the FIFO and the RX -> TX switch
+// leave a gap before the packet is on air.
+#define SIM_SLOT_US          50000
+#define SIM_MAX_BACKOFFS     8
+#define SIM_SENSE_US         (1000 + 2000 + 1280)
+#define SIM_TURNAROUND_US    2000
+
+#define SIM_MAX_NODES        16
+#define SIM_MAX_TX           (SIM_MAX_NODES * 4)
+
+static const int s_node_counts[] = { 1, 2, 4, 8, 12, 16 };
+
+typedef enum {
+    NODE_IDLE,      // queue empty
+    NODE_WAIT,      // jitter or backoff before the next listen
+    NODE_SENSE,     // listening, verdict at the end of the window
+    NODE_TX,
+} node_state_t;
+
+typedef struct {
+    node_state_t state;
+    int64_t  next_gen;      // next packet produced
+    int64_t  period;        // SIM_PERIOD_US with this node's drift
+    int64_t  next_act;      // end of the current wait / listen / transmission
+    int64_t  sense_start;
+    int      queued;
+    int      busy;          // busy listens for the head packet
+    int      tx;            // slot in s_tx while transmitting
+    uint32_t rng;
+} node_t;
+
+typedef struct {
+    int64_t start;
+    int64_t end;
+    int     node;           // -1: free slot
+} tx_t;
+
+typedef struct {
+    uint32_t generated;
+    uint32_t delivered;
+    uint32_t collided;
+    uint32_t dropped;       // queue overflow
+    uint32_t busy;
+    uint32_t forced;
+    int64_t  wait_us;
+    uint32_t sent;
+} sim_result_t;
+
+static node_t s_nodes[SIM_MAX_NODES];
+static tx_t   s_tx[SIM_MAX_TX];
+
+// Time on air of an explicit-header packet with CRC (SX127x datasheet 4.1.1.7)
+static int64_t sim_airtime_us(int payload)
+{
+    const int sf = 7, cr = 1, preamble = 8;
+    const int64_t symbol_us = (1000000LL << sf) / 125000;
+
+    int num = 8 * payload - 4 * sf + 28 + 16;
+    int symbols = 8 + (num > 0 ? (num + 4 * sf - 1) / (4 * sf) * (cr + 4) : 0);
+    return (preamble * 4 + 17) * symbol_us / 4 + symbols * symbol_us;
+}
+
+static bool sim_channel_busy(int64_t from, int64_t to)
+{
+    for (int i = 0; i < SIM_MAX_TX; i++) {
+        if (s_tx[i].node >= 0 && s_tx[i].start < to && s_tx[i].end > from) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sim_start_tx(int n, int64_t t, int64_t airtime)
+{
+    node_t *node = &s_nodes[n];
+    for (int i = 0; i < SIM_MAX_TX; i++) {
+        if (s_tx[i].node < 0) {
+            s_tx[i] = (tx_t){ .start = t, .end = t + airtime, .node = n };
+            node->tx = i;
+            node->state = NODE_TX;
+            node->next_act = t + airtime;
+            return;
+        }
+    }
+    abort();    // SIM_MAX_TX too small
+}
+
+// Transmission over: every overlapping one has started by now
+static void sim_end_tx(int n, sim_result_t *r)
+{
+    node_t *node = &s_nodes[n];
+    tx_t *tx = &s_tx[node->tx];
+
+    bool hit = false;
+    for (int i = 0; i < SIM_MAX_TX; i++) {
+        if (i != node->tx && s_tx[i].node >= 0 &&
+            s_tx[i].start < tx->end && s_tx[i].end > tx->start) {
+            hit = true;
+        }
+    }
+    r->sent++;
+    if (hit) {
+        r->collided++;
+    } else {
+        r->delivered++;
+    }
+
+    // Forget transmissions that can no longer overlap anything
+    int64_t airtime = tx->end - tx->start;
+    for (int i = 0; i < SIM_MAX_TX; i++) {
+        if (s_tx[i].node >= 0 && s_tx[i].end + airtime < tx->end) {
+            s_tx[i].node = -1;
+        }
+    }
+    node->queued--;
+}
+
+// Head of the queue goes through channel access
+static void sim_begin_packet(int n, int64_t t, bool lbt, sim_result_t *r)
+{
+    node_t *node = &s_nodes[n];
+    node->busy = 0;
+    if (!lbt) {
+        sim_start_tx(n, t, sim_airtime_us(SIM_PAYLOAD_BYTES));
+        return;
+    }
+    uint32_t wait = lora_lbt_backoff_us(&node->rng, 0, SIM_SLOT_US);
+    r->wait_us += wait;
+    node->state = NODE_WAIT;
+    node->next_act = t + wait;
+}
+
+static void sim_run(int nodes, bool lbt, sim_result_t *r)
+{
+    const int64_t airtime = sim_airtime_us(SIM_PAYLOAD_BYTES);
+    uint32_t seed = 0x2545F491u;
+
+    memset(r, 0, sizeof(*r));
+    for (int i = 0; i < SIM_MAX_TX; i++) {
+        s_tx[i].node = -1;
+    }
+    for (int n = 0; n < nodes; n++) {
+        node_t *node = &s_nodes[n];
+        memset(node, 0, sizeof(*node));
+        node->rng = lora_lbt_rand(&seed) | 1;
+        int ppm = (int)(lora_lbt_rand(&seed) % (2 * SIM_DRIFT_PPM + 1)) - SIM_DRIFT_PPM;
+        node->period = SIM_PERIOD_US + (int64_t)SIM_PERIOD_US * ppm / 1000000;
+        node->next_gen = lora_lbt_rand(&seed) % SIM_START_SPREAD_US;
+        node->next_act = INT64_MAX;
+        node->state = NODE_IDLE;
+    }
+
+    const int64_t end = (int64_t)SIM_PERIODS * SIM_PERIOD_US;
+    while (1) {
+        // Earliest pending event of any node; generation first on a tie
+        int n = -1;
+        bool gen = false;
+        int64_t t = INT64_MAX;
+        for (int i = 0; i < nodes; i++) {
+            if (s_nodes[i].next_gen < t) {
+                t = s_nodes[i].next_gen; n = i; gen = true;
+            }
+            if (s_nodes[i].next_act < t) {
+                t = s_nodes[i].next_act; n = i; gen = false;
+            }
+        }
+        if (t >= end) {
+            break;
+        }
+        node_t *node = &s_nodes[n];
+
+        if (gen) {
+            r->generated++;
+            node->next_gen += node->period;
+            if (node->queued == SIM_QUEUE_MAX) {
+                r->dropped++;       // oldest waiting reading lost, count stays
+            } else {
+                node->queued++;
+            }
+            if (node->state == NODE_IDLE) {
+                sim_begin_packet(n, t, lbt, r);
+            }
+            continue;
+        }
+
+        switch (node->state) {
+        case NODE_WAIT:
+            node->state = NODE_SENSE;
+            node->sense_start = t;
+            node->next_act = t + SIM_SENSE_US;
+            break;
+
+        case NODE_SENSE:
+            if (!sim_channel_busy(node->sense_start, t)) {
+                sim_start_tx(n, t + SIM_TURNAROUND_US, airtime);
+                break;
+            }
+            r->busy++;
+            if (node->busy >= SIM_MAX_BACKOFFS) {
+                r->forced++;
+                sim_start_tx(n, t + SIM_TURNAROUND_US, airtime);
+                break;
+            }
+            node->busy++;
+            uint32_t wait = lora_lbt_backoff_us(&node->rng, node->busy, SIM_SLOT_US);
+            r->wait_us += wait;
+            node->state = NODE_WAIT;
+            node->next_act = t + wait;
+            break;
+
+        case NODE_TX:
+            sim_end_tx(n, r);
+            node->state = NODE_IDLE;
+            node->next_act = INT64_MAX;
+            if (node->queued) {
+                sim_begin_packet(n, t, lbt, r);
+            }
+            break;
+
+        case NODE_IDLE:
+            node->next_act = INT64_MAX;
+            break;
+        }
+    }
+}
+
+static double percent(uint32_t part, uint32_t whole)
+{
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+void app_main(void)
+{
+    printf("LBT sim: %d ms period, %lld ms on air, %d periods\n",
+           SIM_PERIOD_US / 1000, (long long)(sim_airtime_us(SIM_PAYLOAD_BYTES) / 1000),
+           SIM_PERIODS);
+
+    for (size_t i = 0; i < sizeof(s_node_counts) / sizeof(s_node_counts[0]); i++) {
+        int nodes = s_node_counts[i];
+        sim_result_t aloha, lbt;
+        sim_run(nodes, false, &aloha);
+        sim_run(nodes, true, &lbt);
+
+        printf("SIM nodes=%d blind=%.1f%% lbt=%.1f%% "
+               "(lbt: %.1f%% of sends collided, %lu busy listens, %lu forced, "
+               "%.1f ms avg wait, %lu dropped)\n",
+               nodes,
+               percent(aloha.delivered, aloha.generated),
+               percent(lbt.delivered, lbt.generated),
+               percent(lbt.collided, lbt.sent),
+               (unsigned long)lbt.busy,
+               (unsigned long)lbt.forced,
+               lbt.sent ? (double)lbt.wait_us / lbt.sent / 1000 : 0.0,
+               (unsigned long)lbt.dropped);
+    }
+
+    printf("LBT sim done\n");
+    fflush(stdout);
+    exit(0);
+}
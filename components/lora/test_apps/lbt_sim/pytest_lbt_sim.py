@@ -0,0 +1,30 @@
+# SPDX-License-Identifier: CC0-1.0
+import logging
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+
+NODE_COUNTS = [1, 2, 4, 8, 12, 16]
+
+# Two nodes use half the channel; listen before talk should deliver nearly
+# all of it even though both start on the same period at the same moment
+LBT_MIN_2_NODES = 85.0
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_lora_lbt_sim(dut: IdfDut) -> None:
+    delivery = {}
+    for nodes in NODE_COUNTS:
+        m = dut.expect(rf'SIM nodes={nodes} blind=([0-9.]+)% lbt=([0-9.]+)%')
+        blind, lbt = float(m.group(1)), float(m.group(2))
+        logging.info(f'{nodes} nodes: blind {blind:.1f}%, lbt {lbt:.1f}%')
+        delivery[nodes] = (blind, lbt)
+    dut.expect('LBT sim done')
+
+    assert delivery[1] == (100.0, 100.0), 'a lone node must always get through'
+    assert delivery[2][1] >= LBT_MIN_2_NODES, f'2 nodes with LBT: {delivery[2][1]:.1f}% delivered'
+    for nodes in NODE_COUNTS[1:]:
+        blind, lbt = delivery[nodes]
+        assert lbt > blind, f'{nodes} nodes: LBT {lbt:.1f}% is no better than blind {blind:.1f}%'
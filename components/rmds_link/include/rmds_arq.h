@@ -0,0 +1,86 @@
+#ifndef RMDS_ARQ_H
+#define RMDS_ARQ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Acknowledged delivery (ARQ) for sensor frames
+// ================================================================
+//
+// The gateway answers every frame from a node with an ACK naming the
+// newest packet sequence number it has from that node plus a bitmap of
+// the RMDS_ARQ_ACK_BITS before it, so one ACK also covers earlier frames
+// whose own ACK was lost. The node keeps each frame it sent in a small
+// retransmit buffer until an ACK covers it, resending it with exponential
+// backoff and giving up after RMDS_ARQ_MAX_TRIES sends. The gateway drops
+// the duplicates this produces by node and sequence number (rmds_nodes.h).
+//
+// The buffer is plain data, so the node can keep it in RTC memory and
+// carry unacknowledged frames across deep sleep.
+
+#define RMDS_ARQ_WINDOW       4       // frames kept awaiting an ACK
+#define RMDS_ARQ_FRAME_MAX    200     // longest frame (RMDS_LORA_PACKET_MAX_LEN)
+#define RMDS_ARQ_MAX_TRIES    6       // sends per frame, the first included
+#define RMDS_ARQ_BACKOFF_MS   250     // wait before the first resend
+#define RMDS_ARQ_BACKOFF_EXP  4       // backoff stops doubling here
+#define RMDS_ARQ_ACK_BITS     32
+
+typedef struct {
+    uint32_t seq;
+    uint16_t len;           // 0 = free entry
+    uint8_t  tries;
+    int64_t  due_ms;        // next resend
+    uint8_t  data[RMDS_ARQ_FRAME_MAX];
+} rmds_arq_frame_t;
+
+typedef struct {
+    rmds_arq_frame_t frame[RMDS_ARQ_WINDOW];
+    uint32_t sent;          // frames buffered
+    uint32_t resent;        // retransmissions
+    uint32_t acked;
+    uint32_t gave_up;       // dropped after RMDS_ARQ_MAX_TRIES
+    uint32_t evicted;       // pushed out by a newer frame
+} rmds_arq_tx_t;
+
+void rmds_arq_init(rmds_arq_tx_t *tx);
+
+// Keep a frame just sent for the first time; the oldest one makes room if
+// the buffer is full. rnd is any random value (backoff jitter).
+void rmds_arq_sent(rmds_arq_tx_t *tx, uint32_t seq, const void *data, size_t len,
+                   int64_t now_ms, uint32_t rnd);
+
+// Release every frame the ACK covers (bit i of bitmap: seq - i received).
+// Returns how many were released.
+int rmds_arq_ack(rmds_arq_tx_t *tx, uint32_t seq, uint32_t bitmap);
+
+// Oldest frame due for a resend at now_ms, or NULL. Frames that had their
+// last try are dropped here once their backoff has passed without an ACK.
+rmds_arq_frame_t *rmds_arq_due(rmds_arq_tx_t *tx, int64_t now_ms);
+
+// f was sent again: schedule the next try
+void rmds_arq_resent(rmds_arq_tx_t *tx, rmds_arq_frame_t *f, int64_t now_ms, uint32_t rnd);
+
+// Earliest resend time, or INT64_MAX with nothing to resend
+int64_t rmds_arq_next_due(const rmds_arq_tx_t *tx);
+
+// Frames waiting for an ACK
+int rmds_arq_pending(const rmds_arq_tx_t *tx);
+
+// Wait before the next send of a frame already sent tries times
+uint32_t rmds_arq_backoff_ms(int tries, uint32_t rnd);
+
+// "ACK,N=<node hex>,S=<seq>,B=<bitmap hex>"; -1 if buf is too small
+int rmds_arq_ack_format(char *buf, size_t size, uint32_t node, uint32_t seq, uint32_t bitmap);
+bool rmds_arq_ack_parse(const char *text, uint32_t *node, uint32_t *seq, uint32_t *bitmap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RMDS_ARQ_H
@@ -0,0 +1,129 @@
+#ifndef RMDS_FEC_H
+#define RMDS_FEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Packet-level erasure code for sensor frames
+// ================================================================
+//
+// The node groups its data frames by K and sends M repair packets after
+// each group. The gateway can rebuild any M lost frames of a group from the
+// ones it got, with no reverse channel.
+//
+// Each frame is coded as a symbol: 2 length bytes, then the frame,
+// zero-padded to the longest frame of the group. Repair j is
+// sum_i c[j][i] * symbol_i over GF(2^8). c is a Cauchy matrix with its
+// columns scaled so that row 0 is all ones: repair 0 is plain XOR parity,
+// and any K of the K+M packets rebuild the group (Reed-Solomon-like, MDS).
+//
+// The node keeps only the M running repair sums (rmds_fec_tx_t, plain data
+// for RTC memory), so a group may span several wakes. A repair packet names
+// its group by node, first packet sequence number and a bitmap of members,
+// so other packets (telemetry) can sit between the members:
+//
+//   "FEC,N=<node hex>,G=<first seq>,B=<member bitmap hex>,J=<row>:" + symbol
+//
+// The gateway keeps the last RMDS_FEC_RX_FRAMES data frames and
+// RMDS_FEC_RX_REPAIRS repair packets from all nodes, and decodes a group
+// when enough of it is in. A group spans K wakes of a node, so the frame
+// cache must hold K frames of every node reporting meanwhile.
+
+#define RMDS_FEC_K_MAX        16
+#define RMDS_FEC_M_MAX        4
+#define RMDS_FEC_FRAME_MAX    200     // longest frame (RMDS_LORA_PACKET_MAX_LEN)
+#define RMDS_FEC_SYMBOL_MAX   (2 + RMDS_FEC_FRAME_MAX)
+#define RMDS_FEC_HEADER_MAX   48
+#define RMDS_FEC_PACKET_MAX   (RMDS_FEC_HEADER_MAX + RMDS_FEC_SYMBOL_MAX)
+#define RMDS_FEC_SPAN         32      // members lie within this many sequence numbers
+
+#define RMDS_FEC_RX_FRAMES    64
+#define RMDS_FEC_RX_REPAIRS   16
+
+// ---------------------------------------------------------------
+// Node side
+// ---------------------------------------------------------------
+
+typedef struct {
+    uint8_t  k, m;          // 0: not set up (rmds_fec_tx_init)
+    uint8_t  count;         // members so far
+    uint16_t sym_len;       // longest member symbol so far
+    uint32_t base_seq;
+    uint32_t mask;          // bit i: base_seq + i is a member
+    uint8_t  repair[RMDS_FEC_M_MAX][RMDS_FEC_SYMBOL_MAX];
+    uint32_t groups;        // completed
+    uint32_t cut;           // abandoned, next frame too far from the first
+} rmds_fec_tx_t;
+
+// k in 1..RMDS_FEC_K_MAX, m in 1..RMDS_FEC_M_MAX
+void rmds_fec_tx_init(rmds_fec_tx_t *tx, int k, int m);
+
+// Add a data frame just sent. Returns true once the group has k frames:
+// send the m repair packets (rmds_fec_tx_repair), then rmds_fec_tx_next().
+bool rmds_fec_tx_add(rmds_fec_tx_t *tx, uint32_t seq, const void *frame, size_t len);
+
+// Repair packet j of the complete group; its length, -1 if buf is too small
+int rmds_fec_tx_repair(const rmds_fec_tx_t *tx, int j, uint32_t node, uint8_t *buf, size_t size);
+
+void rmds_fec_tx_next(rmds_fec_tx_t *tx);
+
+// ---------------------------------------------------------------
+// Gateway side
+// ---------------------------------------------------------------
+
+typedef struct {
+    uint32_t node;          // 0 = free entry
+    uint32_t seq;
+    uint32_t stamp;         // arrival order, oldest is replaced first
+    uint16_t len;
+    uint8_t  data[RMDS_FEC_FRAME_MAX];
+} rmds_fec_rx_frame_t;
+
+typedef struct {
+    uint32_t node;          // 0 = free entry
+    uint32_t base_seq;
+    uint32_t mask;
+    uint32_t stamp;
+    uint8_t  j;
+    uint16_t sym_len;
+    uint8_t  sym[RMDS_FEC_SYMBOL_MAX];
+} rmds_fec_rx_repair_t;
+
+typedef struct {
+    rmds_fec_rx_frame_t  frame[RMDS_FEC_RX_FRAMES];
+    rmds_fec_rx_repair_t repair[RMDS_FEC_RX_REPAIRS];
+    uint32_t stamp;
+    uint32_t repairs;       // repair packets taken in
+    uint32_t recovered;     // frames rebuilt
+} rmds_fec_rx_t;
+
+// Called for every frame rebuilt, not NUL-terminated
+typedef void (*rmds_fec_rebuilt_cb_t)(uint32_t node, uint32_t seq,
+                                      const uint8_t *frame, size_t len, void *arg);
+
+void rmds_fec_rx_init(rmds_fec_rx_t *rx);
+
+// Remember a data frame received from node (again is fine)
+void rmds_fec_rx_data(rmds_fec_rx_t *rx, uint32_t node, uint32_t seq, const void *frame, size_t len);
+
+bool rmds_fec_is_repair(const void *pkt, size_t len);
+
+/**
+ * Take in a repair packet and rebuild what its group is missing, if enough
+ * of the group is in by now. Rebuilt frames go to cb and into the frame
+ * cache. Returns how many were rebuilt, -1 for a malformed packet.
+ */
+int rmds_fec_rx_repair(rmds_fec_rx_t *rx, const void *pkt, size_t len,
+                       rmds_fec_rebuilt_cb_t cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RMDS_FEC_H
@@ -0,0 +1,86 @@
+#ifndef RMDS_NODES_H
+#define RMDS_NODES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Per-node link table for the gateway
+// ================================================================
+//
+// Open addressing with linear probing over a fixed array, keyed by the
+// node ID each frame carries (NODE=<hex>). A lookup hashes the ID and
+// probes a few neighbouring entries; the table never fills past
+// RMDS_NODES_MAX_LOAD, so probes stay short. Nothing is allocated: the
+// caller owns the table (48 bytes per entry, 24 KB in all).
+//
+// Not thread-safe; the RX task is the only writer.
+
+#define RMDS_NODES_CAPACITY_BITS  9
+#define RMDS_NODES_CAPACITY       (1 << RMDS_NODES_CAPACITY_BITS)
+#define RMDS_NODES_MAX_LOAD       (RMDS_NODES_CAPACITY * 3 / 4)
+
+// Packet sequence numbers remembered behind the newest one, to tell a
+// duplicate from a late packet. A sequence number further back than this
+// means the node restarted (its counter is reset on a cold boot).
+#define RMDS_NODES_SEQ_WINDOW     32
+
+// EWMA weight of a new RSSI/SNR sample, 1/2^n
+#define RMDS_NODES_EWMA_SHIFT     3
+
+typedef struct {
+    uint32_t node;          // 0 = empty entry
+    uint32_t first_seq;     // oldest packet sequence number accounted for
+    uint32_t last_seq;      // newest packet sequence number
+    uint32_t seq_seen;      // bit i: last_seq - i received
+    uint32_t packets;       // distinct packets received
+    uint32_t lost;          // gaps in the sequence not (yet) filled
+    uint32_t duplicates;
+    uint32_t restarts;
+    int32_t  rssi_q4;       // RSSI EWMA, dBm * 16
+    int32_t  snr_q4;        // SNR EWMA, dB * 16
+    int64_t  last_seen_ms;
+} rmds_node_entry_t;
+
+typedef struct {
+    rmds_node_entry_t entry[RMDS_NODES_CAPACITY];
+    uint32_t count;
+    uint32_t refused;       // new nodes turned away at RMDS_NODES_MAX_LOAD
+} rmds_nodes_t;
+
+typedef enum {
+    RMDS_NODE_PKT_NEW,          // next or later sequence number
+    RMDS_NODE_PKT_LATE,         // fills an earlier gap
+    RMDS_NODE_PKT_DUPLICATE,    // already received: drop it
+    RMDS_NODE_PKT_FIRST,        // node not seen before
+    RMDS_NODE_PKT_RESTART,      // sequence went far back: counting starts over
+    RMDS_NODE_PKT_FULL,         // unknown node and no room for it
+} rmds_node_pkt_t;
+
+void rmds_nodes_init(rmds_nodes_t *t);
+
+// Entry of node, or NULL if it isn't tracked
+rmds_node_entry_t *rmds_nodes_find(rmds_nodes_t *t, uint32_t node);
+
+/**
+ * Account one received packet: sequence bookkeeping, RSSI/SNR averages and
+ * last-seen time. node must not be 0. The entry is returned in *out (NULL
+ * on RMDS_NODE_PKT_FULL) if out is given.
+ */
+rmds_node_pkt_t rmds_nodes_update(rmds_nodes_t *t, uint32_t node, uint32_t seq,
+                                  int rssi, float snr, int64_t now_ms,
+                                  rmds_node_entry_t **out);
+
+// Forget nodes not heard for max_age_ms. Walks the whole table; run it
+// from a housekeeping tick, not per packet. Returns how many were dropped.
+uint32_t rmds_nodes_expire(rmds_nodes_t *t, int64_t now_ms, int64_t max_age_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RMDS_NODES_H
@@ -0,0 +1,112 @@
+#ifndef RMDS_TDMA_H
+#define RMDS_TDMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Slotted TDMA coordinated by gateway beacons
+// ================================================================
+//
+// The gateway broadcasts a beacon at the start of every superframe:
+//
+//   | beacon | join | slot 0 | slot 1 | ... | slot nslots-1 | beacon ...
+//
+// The beacon lists the node owning each data slot. A node hears it, works
+// out where its slot starts from the moment the beacon began and sleeps
+// until then. A node without a slot sends in the join slot (contention);
+// the gateway gives every node it hears the lowest free slot and frees the
+// slot of a node it hasn't heard for the expiry time. The superframe only
+// covers the slots up to the highest one owned, so it grows and shrinks as
+// nodes come and go.
+//
+// No radio access in here: both ends of the firmware and the host
+// simulation (test_apps/link_sim) run the same code.
+
+#define RMDS_TDMA_MAX_SLOTS       16
+#define RMDS_TDMA_SLOT_MS         400    // one full-size packet at SF7 + guard
+#define RMDS_TDMA_BEACON_SLOT_MS  300    // longest beacon at SF7 + guard
+
+// Slot number of the contention slot, for nodes not (or no longer) listed
+#define RMDS_TDMA_JOIN_SLOT       (-1)
+
+// Failed joins stop doubling the superframes skipped after this many
+#define RMDS_TDMA_JOIN_MAX_EXP    4
+
+typedef struct {
+    uint32_t time_ms;       // gateway clock when the beacon was due
+    uint32_t period_ms;     // beacon to beacon
+    uint32_t slot_ms;
+    uint8_t  nslots;        // data slots in this superframe
+    uint32_t owner[RMDS_TDMA_MAX_SLOTS];   // node ID per data slot, 0 = free
+} rmds_tdma_beacon_t;
+
+// "BCN,T=<ms>,P=<ms>,L=<slot ms>,A=<node hex>;<node hex>;..." (0 = free).
+// Returns the length, or -1 if buf is too small. 24-bit node IDs in every
+// slot fit in RMDS_TDMA_BEACON_MAX_LEN.
+#define RMDS_TDMA_BEACON_MAX_LEN  (48 + 7 * RMDS_TDMA_MAX_SLOTS)
+int rmds_tdma_beacon_format(const rmds_tdma_beacon_t *b, char *buf, size_t size);
+
+// Parse a received packet; false if it isn't a (well-formed) beacon
+bool rmds_tdma_beacon_parse(const char *text, rmds_tdma_beacon_t *b);
+
+// Data slot of node in this superframe, or RMDS_TDMA_JOIN_SLOT
+int rmds_tdma_slot_of(const rmds_tdma_beacon_t *b, uint32_t node);
+
+// Start of a slot (RMDS_TDMA_JOIN_SLOT included), ms after the beacon began
+uint32_t rmds_tdma_slot_start_ms(const rmds_tdma_beacon_t *b, int slot);
+
+// Superframe length for a number of data slots
+uint32_t rmds_tdma_period_ms(int nslots, uint32_t slot_ms);
+
+/**
+ * Superframes a node skips before its next join attempt, after failures
+ * attempts that didn't get it a slot: uniform in [0, 2^failures), capped
+ * at RMDS_TDMA_JOIN_MAX_EXP. rnd is any random 32-bit value.
+ */
+uint32_t rmds_tdma_join_skip(uint32_t rnd, int failures);
+
+/**
+ * Time on air of an explicit-header LoRa packet with CRC (SX127x
+ * datasheet 4.1.1.7). cr is the denominator of the coding rate (5..8).
+ */
+uint32_t rmds_tdma_airtime_us(size_t len, int sf, long bw_hz, int cr, int preamble);
+
+// ---- Gateway schedule ----
+
+typedef struct {
+    uint32_t node;          // 0 = free
+    uint32_t heard_ms;
+} rmds_tdma_owner_t;
+
+typedef struct {
+    rmds_tdma_owner_t owner[RMDS_TDMA_MAX_SLOTS];
+    uint32_t slot_ms;
+    uint32_t expire_ms;
+    uint32_t joins;         // slots handed out
+    uint32_t leaves;        // slots freed by expiry
+    uint32_t refused;       // heard a node while every slot was taken
+} rmds_tdma_sched_t;
+
+void rmds_tdma_sched_init(rmds_tdma_sched_t *s, uint32_t slot_ms, uint32_t expire_ms);
+
+// A packet from node decoded at now_ms. Returns its slot, or
+// RMDS_TDMA_JOIN_SLOT if none is free.
+int rmds_tdma_sched_heard(rmds_tdma_sched_t *s, uint32_t node, uint32_t now_ms);
+
+// Expire silent nodes and fill in the beacon due at now_ms
+void rmds_tdma_sched_beacon(rmds_tdma_sched_t *s, uint32_t now_ms, rmds_tdma_beacon_t *b);
+
+// Data slots currently owned
+int rmds_tdma_sched_owned(const rmds_tdma_sched_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RMDS_TDMA_H
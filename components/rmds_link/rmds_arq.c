@@ -0,0 +1,158 @@
+// rmds_arq.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rmds_arq.h"
+
+#define ACK_PREFIX  "ACK,"
+
+void rmds_arq_init(rmds_arq_tx_t *tx)
+{
+    memset(tx, 0, sizeof(*tx));
+}
+
+uint32_t rmds_arq_backoff_ms(int tries, uint32_t rnd)
+{
+    int exp = tries > 0 ? tries - 1 : 0;
+    if (exp > RMDS_ARQ_BACKOFF_EXP) {
+        exp = RMDS_ARQ_BACKOFF_EXP;
+    }
+    // Jitter so nodes that lost frames to the same collision don't resend
+    // into each other again
+    return (RMDS_ARQ_BACKOFF_MS << exp) + rnd % RMDS_ARQ_BACKOFF_MS;
+}
+
+// Sequence numbers wrap: a is older than b
+static bool arq_older(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+void rmds_arq_sent(rmds_arq_tx_t *tx, uint32_t seq, const void *data, size_t len,
+                   int64_t now_ms, uint32_t rnd)
+{
+    rmds_arq_frame_t *slot = NULL;
+
+    for (int i = 0; i < RMDS_ARQ_WINDOW; i++) {
+        rmds_arq_frame_t *f = &tx->frame[i];
+        if (f->len == 0) {
+            slot = f;
+            break;
+        }
+        if (slot == NULL || arq_older(f->seq, slot->seq)) {
+            slot = f;
+        }
+    }
+    if (slot->len != 0) {
+        tx->evicted++;
+    }
+
+    if (len > RMDS_ARQ_FRAME_MAX) {
+        len = RMDS_ARQ_FRAME_MAX;
+    }
+    memcpy(slot->data, data, len);
+    slot->len = (uint16_t)len;
+    slot->seq = seq;
+    slot->tries = 1;
+    slot->due_ms = now_ms + rmds_arq_backoff_ms(1, rnd);
+    tx->sent++;
+}
+
+int rmds_arq_ack(rmds_arq_tx_t *tx, uint32_t seq, uint32_t bitmap)
+{
+    int released = 0;
+
+    for (int i = 0; i < RMDS_ARQ_WINDOW; i++) {
+        rmds_arq_frame_t *f = &tx->frame[i];
+        uint32_t behind = seq - f->seq;
+        if (f->len != 0 && behind < RMDS_ARQ_ACK_BITS && (bitmap & (1u << behind))) {
+            f->len = 0;
+            tx->acked++;
+            released++;
+        }
+    }
+    return released;
+}
+
+rmds_arq_frame_t *rmds_arq_due(rmds_arq_tx_t *tx, int64_t now_ms)
+{
+    rmds_arq_frame_t *due = NULL;
+
+    for (int i = 0; i < RMDS_ARQ_WINDOW; i++) {
+        rmds_arq_frame_t *f = &tx->frame[i];
+        if (f->len == 0 || f->due_ms > now_ms) {
+            continue;
+        }
+        if (f->tries >= RMDS_ARQ_MAX_TRIES) {
+            // Its last ACK window is long over
+            f->len = 0;
+            tx->gave_up++;
+            continue;
+        }
+        if (due == NULL || arq_older(f->seq, due->seq)) {
+            due = f;
+        }
+    }
+    return due;
+}
+
+void rmds_arq_resent(rmds_arq_tx_t *tx, rmds_arq_frame_t *f, int64_t now_ms, uint32_t rnd)
+{
+    tx->resent++;
+    f->tries++;
+    f->due_ms = now_ms + rmds_arq_backoff_ms(f->tries, rnd);
+}
+
+int64_t rmds_arq_next_due(const rmds_arq_tx_t *tx)
+{
+    int64_t next = INT64_MAX;
+
+    for (int i = 0; i < RMDS_ARQ_WINDOW; i++) {
+        const rmds_arq_frame_t *f = &tx->frame[i];
+        // A frame out of tries only waits to be dropped, not for a send
+        if (f->len != 0 && f->tries < RMDS_ARQ_MAX_TRIES && f->due_ms < next) {
+            next = f->due_ms;
+        }
+    }
+    return next;
+}
+
+int rmds_arq_pending(const rmds_arq_tx_t *tx)
+{
+    int n = 0;
+    for (int i = 0; i < RMDS_ARQ_WINDOW; i++) {
+        n += tx->frame[i].len != 0;
+    }
+    return n;
+}
+
+int rmds_arq_ack_format(char *buf, size_t size, uint32_t node, uint32_t seq, uint32_t bitmap)
+{
+    int len = snprintf(buf, size, ACK_PREFIX "N=%lx,S=%lu,B=%lx",
+                       (unsigned long)node, (unsigned long)seq, (unsigned long)bitmap);
+    return len < 0 || len >= (int)size ? -1 : len;
+}
+
+bool rmds_arq_ack_parse(const char *text, uint32_t *node, uint32_t *seq, uint32_t *bitmap)
+{
+    if (!text || strncmp(text, ACK_PREFIX "N=", strlen(ACK_PREFIX "N=")) != 0) {
+        return false;
+    }
+
+    const char *p = text + strlen(ACK_PREFIX "N=");
+    char *end = NULL;
+    *node = (uint32_t)strtoul(p, &end, 16);
+    if (end == p || strncmp(end, ",S=", 3) != 0) {
+        return false;
+    }
+    p = end + 3;
+    *seq = (uint32_t)strtoul(p, &end, 10);
+    if (end == p || strncmp(end, ",B=", 3) != 0) {
+        return false;
+    }
+    p = end + 3;
+    *bitmap = (uint32_t)strtoul(p, &end, 16);
+    return end != p && *end == '\0';
+}
@@ -0,0 +1,390 @@
+// rmds_fec.c
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rmds_fec.h"
+
+#define FEC_PREFIX  "FEC,"
+#define FEC_POLY    0x11D   // x^8 + x^4 + x^3 + x^2 + 1
+
+// GF(2^8) log/antilog tables and the repair coefficients, built on first use
+static uint8_t s_exp[512];
+static uint8_t s_log[256];
+static uint8_t s_coef[RMDS_FEC_M_MAX][RMDS_FEC_K_MAX];
+static bool    s_ready = false;
+
+static uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    return a && b ? s_exp[s_log[a] + s_log[b]] : 0;
+}
+
+static uint8_t gf_inv(uint8_t a)
+{
+    return s_exp[255 - s_log[a]];
+}
+
+static void fec_tables_init(void)
+{
+    if (s_ready) {
+        return;
+    }
+
+    unsigned x = 1;
+    for (int i = 0; i < 255; i++) {
+        s_exp[i] = (uint8_t)x;
+        s_log[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100) {
+            x ^= FEC_POLY;
+        }
+    }
+    for (int i = 255; i < 512; i++) {
+        s_exp[i] = s_exp[i - 255];
+    }
+
+    // Cauchy 1 / (x_j + y_i) with x_j = j, y_i = M_MAX + i (all distinct),
+    // each column times y_i so that row 0 comes out all ones
+    for (int j = 0; j < RMDS_FEC_M_MAX; j++) {
+        for (int i = 0; i < RMDS_FEC_K_MAX; i++) {
+            uint8_t y = (uint8_t)(RMDS_FEC_M_MAX + i);
+            s_coef[j][i] = gf_mul(gf_inv((uint8_t)(j ^ y)), y);
+        }
+    }
+    s_ready = true;
+}
+
+// dst += c * src
+static void fec_addmul(uint8_t *dst, const uint8_t *src, uint8_t c, size_t n)
+{
+    if (c == 1) {
+        for (size_t b = 0; b < n; b++) {
+            dst[b] ^= src[b];
+        }
+        return;
+    }
+    if (c == 0) {
+        return;
+    }
+    unsigned lc = s_log[c];
+    for (size_t b = 0; b < n; b++) {
+        if (src[b]) {
+            dst[b] ^= s_exp[lc + s_log[src[b]]];
+        }
+    }
+}
+
+// dst += c * symbol of a frame (length bytes, then the frame)
+static void fec_addmul_frame(uint8_t *dst, const uint8_t *frame, size_t len, uint8_t c)
+{
+    uint8_t hdr[2] = { (uint8_t)(len >> 8), (uint8_t)len };
+    fec_addmul(dst, hdr, c, 2);
+    fec_addmul(dst + 2, frame, c, len);
+}
+
+// ---------------------------------------------------------------
+// Node side
+// ---------------------------------------------------------------
+
+void rmds_fec_tx_init(rmds_fec_tx_t *tx, int k, int m)
+{
+    fec_tables_init();
+    memset(tx, 0, sizeof(*tx));
+    tx->k = (uint8_t)(k < 1 ? 1 : k > RMDS_FEC_K_MAX ? RMDS_FEC_K_MAX : k);
+    tx->m = (uint8_t)(m < 1 ? 1 : m > RMDS_FEC_M_MAX ? RMDS_FEC_M_MAX : m);
+}
+
+void rmds_fec_tx_next(rmds_fec_tx_t *tx)
+{
+    memset(tx->repair, 0, sizeof(tx->repair));
+    tx->count = 0;
+    tx->sym_len = 0;
+    tx->mask = 0;
+}
+
+bool rmds_fec_tx_add(rmds_fec_tx_t *tx, uint32_t seq, const void *frame, size_t len)
+{
+    if (len > RMDS_FEC_FRAME_MAX) {
+        return false;   // sent unprotected
+    }
+    // Tables live in RAM, so are gone after deep sleep even if tx isn't
+    fec_tables_init();
+
+    if (tx->count > 0 && seq - tx->base_seq >= RMDS_FEC_SPAN) {
+        tx->cut++;
+        rmds_fec_tx_next(tx);
+    }
+    if (tx->count == 0) {
+        tx->base_seq = seq;
+    }
+    uint32_t bit = 1u << (seq - tx->base_seq);
+    if (tx->mask & bit) {
+        return false;   // same frame again
+    }
+
+    for (int j = 0; j < tx->m; j++) {
+        fec_addmul_frame(tx->repair[j], frame, len, s_coef[j][tx->count]);
+    }
+    if (2 + len > tx->sym_len) {
+        tx->sym_len = (uint16_t)(2 + len);
+    }
+    tx->mask |= bit;
+    if (++tx->count < tx->k) {
+        return false;
+    }
+    tx->groups++;
+    return true;
+}
+
+int rmds_fec_tx_repair(const rmds_fec_tx_t *tx, int j, uint32_t node, uint8_t *buf, size_t size)
+{
+    if (j < 0 || j >= tx->m || tx->count == 0) {
+        return -1;
+    }
+
+    int hdr = snprintf((char *)buf, size, FEC_PREFIX "N=%lx,G=%lu,B=%lx,J=%d:",
+                       (unsigned long)node, (unsigned long)tx->base_seq,
+                       (unsigned long)tx->mask, j);
+    if (hdr < 0 || (size_t)hdr + tx->sym_len > size) {
+        return -1;
+    }
+    memcpy(buf + hdr, tx->repair[j], tx->sym_len);
+    return hdr + tx->sym_len;
+}
+
+// ---------------------------------------------------------------
+// Gateway side
+// ---------------------------------------------------------------
+
+void rmds_fec_rx_init(rmds_fec_rx_t *rx)
+{
+    fec_tables_init();
+    memset(rx, 0, sizeof(*rx));
+}
+
+static rmds_fec_rx_frame_t *fec_rx_find(rmds_fec_rx_t *rx, uint32_t node, uint32_t seq)
+{
+    for (int i = 0; i < RMDS_FEC_RX_FRAMES; i++) {
+        rmds_fec_rx_frame_t *f = &rx->frame[i];
+        if (f->node == node && f->seq == seq && node != 0) {
+            return f;
+        }
+    }
+    return NULL;
+}
+
+void rmds_fec_rx_data(rmds_fec_rx_t *rx, uint32_t node, uint32_t seq, const void *frame, size_t len)
+{
+    if (node == 0 || len > RMDS_FEC_FRAME_MAX) {
+        return;
+    }
+
+    rmds_fec_rx_frame_t *f = fec_rx_find(rx, node, seq);
+    for (int i = 0; f == NULL && i < RMDS_FEC_RX_FRAMES; i++) {
+        if (rx->frame[i].node == 0) {
+            f = &rx->frame[i];
+        }
+    }
+    if (f == NULL) {
+        f = &rx->frame[0];
+        for (int i = 1; i < RMDS_FEC_RX_FRAMES; i++) {
+            if ((int32_t)(rx->frame[i].stamp - f->stamp) < 0) {
+                f = &rx->frame[i];
+            }
+        }
+    }
+
+    f->node = node;
+    f->seq = seq;
+    f->stamp = ++rx->stamp;
+    f->len = (uint16_t)len;
+    memcpy(f->data, frame, len);
+}
+
+bool rmds_fec_is_repair(const void *pkt, size_t len)
+{
+    return len > strlen(FEC_PREFIX) && memcmp(pkt, FEC_PREFIX, strlen(FEC_PREFIX)) == 0;
+}
+
+// Header and symbol of a repair packet into r
+static bool fec_rx_parse(const uint8_t *pkt, size_t len, rmds_fec_rx_repair_t *r)
+{
+    const uint8_t *colon = memchr(pkt, ':', len < RMDS_FEC_HEADER_MAX ? len : RMDS_FEC_HEADER_MAX);
+    if (colon == NULL) {
+        return false;
+    }
+
+    char hdr[RMDS_FEC_HEADER_MAX + 1];
+    size_t hdr_len = (size_t)(colon - pkt);
+    memcpy(hdr, pkt, hdr_len);
+    hdr[hdr_len] = '\0';
+
+    unsigned long node, base, mask;
+    int j, end = 0;
+    if (sscanf(hdr, FEC_PREFIX "N=%lx,G=%lu,B=%lx,J=%d%n", &node, &base, &mask, &j, &end) != 4 ||
+        (size_t)end != hdr_len) {
+        return false;
+    }
+
+    size_t sym_len = len - hdr_len - 1;
+    if (node == 0 || mask == 0 || !(mask & 1) || __builtin_popcountl(mask) > RMDS_FEC_K_MAX ||
+        j < 0 || j >= RMDS_FEC_M_MAX || sym_len < 2 || sym_len > RMDS_FEC_SYMBOL_MAX) {
+        return false;
+    }
+
+    r->node = (uint32_t)node;
+    r->base_seq = (uint32_t)base;
+    r->mask = (uint32_t)mask;
+    r->j = (uint8_t)j;
+    r->sym_len = (uint16_t)sym_len;
+    memcpy(r->sym, colon + 1, sym_len);
+    return true;
+}
+
+static bool fec_same_group(const rmds_fec_rx_repair_t *a, const rmds_fec_rx_repair_t *b)
+{
+    return a->node == b->node && a->base_seq == b->base_seq && a->mask == b->mask;
+}
+
+// Keep a repair packet, replacing the same one or else the oldest
+static const rmds_fec_rx_repair_t *fec_rx_keep(rmds_fec_rx_t *rx, const rmds_fec_rx_repair_t *in)
+{
+    rmds_fec_rx_repair_t *slot = NULL;
+
+    for (int i = 0; i < RMDS_FEC_RX_REPAIRS; i++) {
+        rmds_fec_rx_repair_t *r = &rx->repair[i];
+        if (r->node != 0 && fec_same_group(r, in) && r->j == in->j) {
+            slot = r;
+            break;
+        }
+        if (slot == NULL || (slot->node != 0 &&
+                             (r->node == 0 || (int32_t)(r->stamp - slot->stamp) < 0))) {
+            slot = r;
+        }
+    }
+
+    *slot = *in;
+    slot->stamp = ++rx->stamp;
+    return slot;
+}
+
+int rmds_fec_rx_repair(rmds_fec_rx_t *rx, const void *pkt, size_t len,
+                       rmds_fec_rebuilt_cb_t cb, void *arg)
+{
+    static rmds_fec_rx_repair_t in;     // one RX task; keeps it off its stack
+    static uint8_t work[RMDS_FEC_M_MAX][RMDS_FEC_SYMBOL_MAX];
+
+    if (!fec_rx_parse(pkt, len, &in)) {
+        return -1;
+    }
+    rx->repairs++;
+    const rmds_fec_rx_repair_t *group = fec_rx_keep(rx, &in);
+
+    // Members in sequence order; which of them are missing
+    const rmds_fec_rx_frame_t *have[RMDS_FEC_K_MAX];
+    uint32_t seqs[RMDS_FEC_K_MAX];
+    int lost[RMDS_FEC_M_MAX];
+    int k = 0, e = 0;
+    for (uint32_t off = 0; off < RMDS_FEC_SPAN; off++) {
+        if (!(group->mask & (1u << off))) {
+            continue;
+        }
+        seqs[k] = group->base_seq + off;
+        have[k] = fec_rx_find(rx, group->node, seqs[k]);
+        if (have[k] == NULL) {
+            if (e == RMDS_FEC_M_MAX) {
+                return 0;   // more lost than any group could repair
+            }
+            lost[e++] = k;
+        }
+        k++;
+    }
+    if (e == 0) {
+        return 0;
+    }
+
+    // As many repair rows as frames lost
+    const rmds_fec_rx_repair_t *rows[RMDS_FEC_M_MAX];
+    int r = 0;
+    for (int i = 0; i < RMDS_FEC_RX_REPAIRS && r < e; i++) {
+        if (rx->repair[i].node != 0 && fec_same_group(&rx->repair[i], group)) {
+            rows[r++] = &rx->repair[i];
+        }
+    }
+    if (r < e) {
+        return 0;   // wait for more of the group
+    }
+
+    // Take out the frames we have: work[r] = sum of c * lost symbols
+    uint16_t sym_len = group->sym_len;
+    uint8_t a[RMDS_FEC_M_MAX][RMDS_FEC_M_MAX];
+    for (r = 0; r < e; r++) {
+        memset(work[r], 0, sizeof(work[r]));
+        memcpy(work[r], rows[r]->sym, rows[r]->sym_len < sym_len ? rows[r]->sym_len : sym_len);
+        for (int i = 0; i < k; i++) {
+            if (have[i] != NULL) {
+                fec_addmul_frame(work[r], have[i]->data, have[i]->len, s_coef[rows[r]->j][i]);
+            }
+        }
+        for (int c = 0; c < e; c++) {
+            a[r][c] = s_coef[rows[r]->j][lost[c]];
+        }
+    }
+
+    // Gauss-Jordan: a * lost = work
+    for (int c = 0; c < e; c++) {
+        int p = c;
+        while (p < e && a[p][c] == 0) {
+            p++;
+        }
+        if (p == e) {
+            return 0;   // not with a Cauchy matrix
+        }
+        if (p != c) {
+            uint8_t tmp[RMDS_FEC_SYMBOL_MAX];
+            for (int i = 0; i < e; i++) {
+                uint8_t t = a[p][i];
+                a[p][i] = a[c][i];
+                a[c][i] = t;
+            }
+            memcpy(tmp, work[p], sym_len);
+            memcpy(work[p], work[c], sym_len);
+            memcpy(work[c], tmp, sym_len);
+        }
+
+        uint8_t inv = gf_inv(a[c][c]);
+        for (int i = 0; i < e; i++) {
+            a[c][i] = gf_mul(a[c][i], inv);
+        }
+        for (int b = 0; b < sym_len; b++) {
+            work[c][b] = gf_mul(work[c][b], inv);
+        }
+        for (int row = 0; row < e; row++) {
+            uint8_t f = a[row][c];
+            if (row == c || f == 0) {
+                continue;
+            }
+            for (int i = 0; i < e; i++) {
+                a[row][i] ^= gf_mul(f, a[c][i]);
+            }
+            fec_addmul(work[row], work[c], f, sym_len);
+        }
+    }
+
+    int rebuilt = 0;
+    uint32_t node = group->node;
+    for (int c = 0; c < e; c++) {
+        size_t flen = (size_t)work[c][0] << 8 | work[c][1];
+        if (flen > RMDS_FEC_FRAME_MAX || 2 + flen > sym_len) {
+            continue;   // corrupt repair packet
+        }
+        uint32_t seq = seqs[lost[c]];
+        rmds_fec_rx_data(rx, node, seq, work[c] + 2, flen);
+        rx->recovered++;
+        rebuilt++;
+        if (cb) {
+            cb(node, seq, work[c] + 2, flen, arg);
+        }
+    }
+    return rebuilt;
+}
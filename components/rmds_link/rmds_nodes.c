@@ -0,0 +1,159 @@
+// rmds_nodes.c
+
+#include <string.h>
+
+#include "rmds_nodes.h"
+
+#define NODES_MASK  (RMDS_NODES_CAPACITY - 1)
+
+// Fibonacci hashing: node IDs are often sequential or share their high bytes
+static uint32_t nodes_home(uint32_t node)
+{
+    return (node * 2654435761u) >> (32 - RMDS_NODES_CAPACITY_BITS);
+}
+
+// Index of node, or of the empty entry where it would go
+static uint32_t nodes_probe(const rmds_nodes_t *t, uint32_t node)
+{
+    uint32_t i = nodes_home(node);
+    while (t->entry[i].node != 0 && t->entry[i].node != node) {
+        i = (i + 1) & NODES_MASK;
+    }
+    return i;
+}
+
+void rmds_nodes_init(rmds_nodes_t *t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+rmds_node_entry_t *rmds_nodes_find(rmds_nodes_t *t, uint32_t node)
+{
+    if (node == 0) {
+        return NULL;
+    }
+    rmds_node_entry_t *e = &t->entry[nodes_probe(t, node)];
+    return e->node == node ? e : NULL;
+}
+
+static void nodes_ewma(int32_t *avg_q4, int32_t sample_q4)
+{
+    *avg_q4 += (sample_q4 - *avg_q4) / (1 << RMDS_NODES_EWMA_SHIFT);
+}
+
+rmds_node_pkt_t rmds_nodes_update(rmds_nodes_t *t, uint32_t node, uint32_t seq,
+                                  int rssi, float snr, int64_t now_ms,
+                                  rmds_node_entry_t **out)
+{
+    rmds_node_entry_t *e = &t->entry[nodes_probe(t, node)];
+    if (out) {
+        *out = NULL;
+    }
+
+    if (e->node == 0) {
+        if (node == 0 || t->count >= RMDS_NODES_MAX_LOAD) {
+            t->refused++;
+            return RMDS_NODE_PKT_FULL;
+        }
+        memset(e, 0, sizeof(*e));
+        e->node = node;
+        e->first_seq = seq;
+        e->last_seq = seq;
+        e->seq_seen = 1;
+        e->packets = 1;
+        e->rssi_q4 = rssi * 16;
+        e->snr_q4 = (int32_t)(snr * 16.0f);
+        e->last_seen_ms = now_ms;
+        t->count++;
+        if (out) {
+            *out = e;
+        }
+        return RMDS_NODE_PKT_FIRST;
+    }
+
+    if (out) {
+        *out = e;
+    }
+    e->last_seen_ms = now_ms;
+    nodes_ewma(&e->rssi_q4, rssi * 16);
+    nodes_ewma(&e->snr_q4, (int32_t)(snr * 16.0f));
+
+    uint32_t ahead = seq - e->last_seq;     // modulo 2^32
+    if (ahead == 0) {
+        e->duplicates++;
+        return RMDS_NODE_PKT_DUPLICATE;
+    }
+    if (ahead < 0x80000000u) {
+        // Everything skipped counts as lost until it turns up late
+        e->lost += ahead - 1;
+        e->seq_seen = ahead < RMDS_NODES_SEQ_WINDOW ? (e->seq_seen << ahead) | 1 : 1;
+        e->last_seq = seq;
+        e->packets++;
+        return RMDS_NODE_PKT_NEW;
+    }
+
+    uint32_t behind = e->last_seq - seq;
+    if (behind < RMDS_NODES_SEQ_WINDOW) {
+        uint32_t bit = 1u << behind;
+        if (e->seq_seen & bit) {
+            e->duplicates++;
+            return RMDS_NODE_PKT_DUPLICATE;
+        }
+        e->seq_seen |= bit;
+        if (behind > e->last_seq - e->first_seq) {
+            // Older than anything seen yet: what lies between is missing
+            e->lost += e->first_seq - seq - 1;
+            e->first_seq = seq;
+        } else {
+            e->lost--;
+        }
+        e->packets++;
+        return RMDS_NODE_PKT_LATE;
+    }
+
+    e->first_seq = seq;
+    e->last_seq = seq;
+    e->seq_seen = 1;
+    e->packets++;
+    e->restarts++;
+    return RMDS_NODE_PKT_RESTART;
+}
+
+// Empty entry i, then pull later entries of the same probe run back into
+// the hole so every lookup still ends at the first empty entry
+static void nodes_remove(rmds_nodes_t *t, uint32_t i)
+{
+    uint32_t j = i;
+    while (1) {
+        t->entry[i].node = 0;
+        do {
+            j = (j + 1) & NODES_MASK;
+            if (t->entry[j].node == 0) {
+                return;
+            }
+            // Stays put if its home lies cyclically in (i, j]
+            uint32_t home = nodes_home(t->entry[j].node);
+            if (i <= j ? (i < home && home <= j) : (i < home || home <= j)) {
+                continue;
+            }
+            break;
+        } while (1);
+        t->entry[i] = t->entry[j];
+        i = j;
+    }
+}
+
+uint32_t rmds_nodes_expire(rmds_nodes_t *t, int64_t now_ms, int64_t max_age_ms)
+{
+    uint32_t dropped = 0;
+
+    for (uint32_t i = 0; i < RMDS_NODES_CAPACITY; i++) {
+        // A removal can pull another entry into i: look at it again
+        while (t->entry[i].node != 0 && now_ms - t->entry[i].last_seen_ms > max_age_ms) {
+            nodes_remove(t, i);
+            t->count--;
+            dropped++;
+        }
+    }
+    return dropped;
+}
@@ -0,0 +1,186 @@
+// rmds_tdma.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rmds_tdma.h"
+
+#define BEACON_PREFIX  "BCN,"
+
+int rmds_tdma_beacon_format(const rmds_tdma_beacon_t *b, char *buf, size_t size)
+{
+    int len = snprintf(buf, size, BEACON_PREFIX "T=%lu,P=%lu,L=%lu,A=",
+                       (unsigned long)b->time_ms,
+                       (unsigned long)b->period_ms,
+                       (unsigned long)b->slot_ms);
+    if (len < 0 || len >= (int)size) {
+        return -1;
+    }
+    for (int i = 0; i < b->nslots; i++) {
+        int w = snprintf(buf + len, size - len, "%s%lx", i ? ";" : "",
+                         (unsigned long)b->owner[i]);
+        if (w < 0 || w >= (int)(size - len)) {
+            return -1;
+        }
+        len += w;
+    }
+    return len;
+}
+
+// "key=<number>," at p; returns the position after the comma or NULL
+static const char *beacon_u32(const char *p, const char *key, uint32_t *out)
+{
+    size_t n = strlen(key);
+    if (strncmp(p, key, n) != 0) {
+        return NULL;
+    }
+    char *end = NULL;
+    unsigned long v = strtoul(p + n, &end, 10);
+    if (end == p + n || *end != ',') {
+        return NULL;
+    }
+    *out = (uint32_t)v;
+    return end + 1;
+}
+
+bool rmds_tdma_beacon_parse(const char *text, rmds_tdma_beacon_t *b)
+{
+    if (!text || !b || strncmp(text, BEACON_PREFIX, strlen(BEACON_PREFIX)) != 0) {
+        return false;
+    }
+
+    const char *p = text + strlen(BEACON_PREFIX);
+    if (!(p = beacon_u32(p, "T=", &b->time_ms)) ||
+        !(p = beacon_u32(p, "P=", &b->period_ms)) ||
+        !(p = beacon_u32(p, "L=", &b->slot_ms)) ||
+        strncmp(p, "A=", 2) != 0) {
+        return false;
+    }
+    p += 2;
+
+    b->nslots = 0;
+    while (*p != '\0') {
+        if (b->nslots == RMDS_TDMA_MAX_SLOTS) {
+            return false;
+        }
+        char *end = NULL;
+        unsigned long node = strtoul(p, &end, 16);
+        if (end == p || (*end != ';' && *end != '\0')) {
+            return false;
+        }
+        b->owner[b->nslots++] = (uint32_t)node;
+        p = *end ? end + 1 : end;
+    }
+
+    // A node relies on this to find its slot: reject what it can't trust
+    return b->slot_ms > 0 &&
+           b->period_ms == rmds_tdma_period_ms(b->nslots, b->slot_ms);
+}
+
+int rmds_tdma_slot_of(const rmds_tdma_beacon_t *b, uint32_t node)
+{
+    for (int i = 0; node != 0 && i < b->nslots; i++) {
+        if (b->owner[i] == node) {
+            return i;
+        }
+    }
+    return RMDS_TDMA_JOIN_SLOT;
+}
+
+uint32_t rmds_tdma_slot_start_ms(const rmds_tdma_beacon_t *b, int slot)
+{
+    // The join slot comes first, right after the beacon
+    return RMDS_TDMA_BEACON_SLOT_MS + (uint32_t)(slot + 1) * b->slot_ms;
+}
+
+uint32_t rmds_tdma_period_ms(int nslots, uint32_t slot_ms)
+{
+    return RMDS_TDMA_BEACON_SLOT_MS + (uint32_t)(nslots + 1) * slot_ms;
+}
+
+uint32_t rmds_tdma_join_skip(uint32_t rnd, int failures)
+{
+    if (failures > RMDS_TDMA_JOIN_MAX_EXP) {
+        failures = RMDS_TDMA_JOIN_MAX_EXP;
+    }
+    return failures > 0 ? rnd % (1u << failures) : 0;
+}
+
+uint32_t rmds_tdma_airtime_us(size_t len, int sf, long bw_hz, int cr, int preamble)
+{
+    // Low data rate optimisation is on for symbols of 16 ms and longer
+    const uint64_t symbol_us = (1000000ULL << sf) / (uint64_t)bw_hz;
+    const int de = symbol_us >= 16000 ? 1 : 0;
+
+    int num = 8 * (int)len - 4 * sf + 28 + 16;
+    int den = 4 * (sf - 2 * de);
+    int symbols = 8 + (num > 0 ? (num + den - 1) / den * cr : 0);
+    return (uint32_t)((preamble * 4 + 17) * symbol_us / 4 + symbols * symbol_us);
+}
+
+// ---- Gateway schedule ----
+
+void rmds_tdma_sched_init(rmds_tdma_sched_t *s, uint32_t slot_ms, uint32_t expire_ms)
+{
+    memset(s, 0, sizeof(*s));
+    s->slot_ms = slot_ms;
+    s->expire_ms = expire_ms;
+}
+
+int rmds_tdma_sched_heard(rmds_tdma_sched_t *s, uint32_t node, uint32_t now_ms)
+{
+    int free_slot = RMDS_TDMA_JOIN_SLOT;
+
+    for (int i = 0; i < RMDS_TDMA_MAX_SLOTS; i++) {
+        if (s->owner[i].node == node) {
+            s->owner[i].heard_ms = now_ms;
+            return i;
+        }
+        if (s->owner[i].node == 0 && free_slot == RMDS_TDMA_JOIN_SLOT) {
+            free_slot = i;
+        }
+    }
+
+    if (node == 0 || free_slot == RMDS_TDMA_JOIN_SLOT) {
+        s->refused++;
+        return RMDS_TDMA_JOIN_SLOT;
+    }
+    // Lowest free slot, so the superframe stays as short as it can
+    s->owner[free_slot].node = node;
+    s->owner[free_slot].heard_ms = now_ms;
+    s->joins++;
+    return free_slot;
+}
+
+void rmds_tdma_sched_beacon(rmds_tdma_sched_t *s, uint32_t now_ms, rmds_tdma_beacon_t *b)
+{
+    int nslots = 0;
+
+    for (int i = 0; i < RMDS_TDMA_MAX_SLOTS; i++) {
+        rmds_tdma_owner_t *o = &s->owner[i];
+        if (o->node != 0 && now_ms - o->heard_ms > s->expire_ms) {
+            o->node = 0;
+            s->leaves++;
+        }
+        b->owner[i] = o->node;
+        if (o->node != 0) {
+            nslots = i + 1;
+        }
+    }
+
+    // Owners keep their slot; only trailing free slots are dropped
+    b->time_ms = now_ms;
+    b->slot_ms = s->slot_ms;
+    b->nslots = (uint8_t)nslots;
+    b->period_ms = rmds_tdma_period_ms(nslots, s->slot_ms);
+}
+
+int rmds_tdma_sched_owned(const rmds_tdma_sched_t *s)
+{
+    int owned = 0;
+    for (int i = 0; i < RMDS_TDMA_MAX_SLOTS; i++) {
+        owned += s->owner[i].node != 0;
+    }
+    return owned;
+}
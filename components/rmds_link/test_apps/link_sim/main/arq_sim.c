@@ -0,0 +1,166 @@
+// arq_sim.c
+//
+// Acknowledged delivery (rmds_arq.h) over a lossy channel. One node sends
+// a batch frame every wake; each frame and each ACK is lost independently
+// with the loss rate under test (s_loss_pct). The node side runs as the
+// TX task does with RMDS_LORA_ARQ: due resends first, then the new frame,
+// each followed by the ACK window, then it stays awake for resends due
+// soon and leaves the rest for the next wake. The gateway runs the frames
+// through its node table (rmds_nodes.h), drops duplicates and answers with
+// an ACK built from the table entry, formatted and parsed back as on the
+// radio.
+//
+//   plain: every frame sent once, as without ARQ
+//   arq:   distinct frames the gateway forwarded; retries are resends per
+//          frame; airtime counts resends and ACKs against plain sending
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rmds_arq.h"
+#include "rmds_nodes.h"
+#include "rmds_tdma.h"
+#include "link_sim.h"
+
+#define ARQ_SIM_FRAMES        20000
+#define ARQ_SIM_PAYLOAD       130     // one 6-reading batch
+#define ARQ_SIM_WAKE_MS       60000
+#define ARQ_SIM_NODE          0x3C6105u
+
+// Firmware timing (rmds_lora.h): ACK window after each frame, resends
+// waited for while awake, awake time given to resends per wake. The
+// gateway sees a frame at its next 10 ms poll.
+#define ARQ_SIM_ACK_WAIT_MS   250
+#define ARQ_SIM_LINGER_MS     2000
+#define ARQ_SIM_WAIT_MAX_MS   5000
+#define ARQ_SIM_POLL_MS       10
+
+static const int s_loss_pct[] = { 0, 10, 20, 30, 50 };
+
+typedef struct {
+    int      loss_pct;
+    uint32_t rng;
+    int64_t  now_ms;
+    int64_t  airtime_us;
+    uint32_t forwarded;
+    uint32_t dropped;       // duplicates the gateway did not forward
+    uint32_t mismatches;    // forwarded twice, or an ACK for a frame never received
+    uint8_t  received[ARQ_SIM_FRAMES];
+} arq_run_t;
+
+static rmds_arq_tx_t s_tx;
+static rmds_nodes_t  s_gateway;
+static arq_run_t     s_run;
+
+static int64_t arq_airtime_us(int len)
+{
+    return rmds_tdma_airtime_us(len, SIM_SF, SIM_BW_HZ, SIM_CR, SIM_PREAMBLE);
+}
+
+static bool arq_lost(arq_run_t *r)
+{
+    return (int)(sim_rand(&r->rng) % 100) < r->loss_pct;
+}
+
+// One frame on air, then the ACK window
+static void arq_send(arq_run_t *r, uint32_t seq, int len)
+{
+    r->airtime_us += arq_airtime_us(len);
+    r->now_ms += arq_airtime_us(len) / 1000;
+
+    if (arq_lost(r)) {
+        r->now_ms += ARQ_SIM_ACK_WAIT_MS;
+        return;
+    }
+
+    rmds_node_entry_t *e = NULL;
+    rmds_node_pkt_t verdict = rmds_nodes_update(&s_gateway, ARQ_SIM_NODE, seq, -100, 0.0f,
+                                                r->now_ms, &e);
+    if (verdict == RMDS_NODE_PKT_DUPLICATE) {
+        r->dropped++;
+    } else {
+        r->mismatches += r->received[seq];
+        r->received[seq] = 1;
+        r->forwarded++;
+    }
+
+    char ack[48];
+    int ack_len = rmds_arq_ack_format(ack, sizeof(ack), ARQ_SIM_NODE, e->last_seq, e->seq_seen);
+    r->airtime_us += arq_airtime_us(ack_len);
+    if (arq_lost(r)) {
+        r->now_ms += ARQ_SIM_ACK_WAIT_MS;
+        return;
+    }
+    r->now_ms += ARQ_SIM_POLL_MS + arq_airtime_us(ack_len) / 1000;
+
+    uint32_t node, ack_seq, bitmap;
+    if (!rmds_arq_ack_parse(ack, &node, &ack_seq, &bitmap) || node != ARQ_SIM_NODE) {
+        r->mismatches++;
+        return;
+    }
+    rmds_arq_ack(&s_tx, ack_seq, bitmap);
+}
+
+static void arq_resend_due(arq_run_t *r)
+{
+    rmds_arq_frame_t *f;
+    while ((f = rmds_arq_due(&s_tx, r->now_ms)) != NULL) {
+        uint32_t seq = f->seq;
+        rmds_arq_resent(&s_tx, f, r->now_ms, sim_rand(&r->rng));
+        arq_send(r, seq, f->len);
+    }
+}
+
+static void arq_run(int loss_pct, uint32_t *plain)
+{
+    arq_run_t *r = &s_run;
+    memset(r, 0, sizeof(*r));
+    r->loss_pct = loss_pct;
+    r->rng = 0x2545F491u + loss_pct;
+    rmds_arq_init(&s_tx);
+    rmds_nodes_init(&s_gateway);
+
+    uint8_t frame[ARQ_SIM_PAYLOAD];
+    memset(frame, 'x', sizeof(frame));
+
+    *plain = 0;
+    for (uint32_t seq = 0; seq < ARQ_SIM_FRAMES; seq++) {
+        int64_t wake_ms = (int64_t)seq * ARQ_SIM_WAKE_MS;
+        r->now_ms = wake_ms;
+
+        // Plain sending over the same channel
+        *plain += !arq_lost(r);
+
+        arq_resend_due(r);
+        rmds_arq_sent(&s_tx, seq, frame, sizeof(frame), r->now_ms, sim_rand(&r->rng));
+        arq_send(r, seq, sizeof(frame));
+
+        int64_t next;
+        while ((next = rmds_arq_next_due(&s_tx)) - r->now_ms <= ARQ_SIM_LINGER_MS &&
+               r->now_ms - wake_ms < ARQ_SIM_WAIT_MAX_MS) {
+            if (next > r->now_ms) {
+                r->now_ms = next;
+            }
+            arq_resend_due(r);
+        }
+    }
+}
+
+void arq_sim(void)
+{
+    for (size_t i = 0; i < sizeof(s_loss_pct) / sizeof(s_loss_pct[0]); i++) {
+        uint32_t plain;
+        arq_run(s_loss_pct[i], &plain);
+
+        int64_t plain_airtime = (int64_t)ARQ_SIM_FRAMES * arq_airtime_us(ARQ_SIM_PAYLOAD);
+        printf("ARQ loss=%d%% delivered plain=%.2f%% arq=%.2f%% retries=%.3f per frame "
+               "(%lu gave up, %lu evicted, %lu duplicates dropped, %lu mismatches, airtime x%.2f)\n",
+               s_loss_pct[i], sim_percent(plain, ARQ_SIM_FRAMES),
+               sim_percent(s_run.forwarded, ARQ_SIM_FRAMES),
+               (double)s_tx.resent / ARQ_SIM_FRAMES,
+               (unsigned long)s_tx.gave_up, (unsigned long)s_tx.evicted,
+               (unsigned long)s_run.dropped, (unsigned long)s_run.mismatches,
+               (double)s_run.airtime_us / plain_airtime);
+    }
+}
@@ -0,0 +1,143 @@
+// fec_sim.c
+//
+// Packet-level erasure code (rmds_fec.h) over a channel that loses each
+// packet independently at the rate under test. One node sends text frames
+// of varying length, with a telemetry packet (not coded) now and then
+// taking a sequence number between group members. After every k data
+// frames it sends m repair packets. The gateway caches what it gets and
+// rebuilds the rest from the repairs; every rebuilt frame is compared with
+// the one sent.
+//
+//   plain:   data frames received
+//   fec:     data frames received or rebuilt
+//   airtime: repair packets on air, against the data frames alone
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rmds_fec.h"
+#include "rmds_tdma.h"
+#include "link_sim.h"
+
+#define FEC_SIM_FRAMES      20000
+#define FEC_SIM_NODE        0x3C6105u
+#define FEC_SIM_TLM_EVERY   10      // every 10th sequence number is telemetry
+#define FEC_SIM_LEN_MIN     90
+#define FEC_SIM_LEN_MAX     190
+
+typedef struct {
+    int k, m;
+} fec_code_t;
+
+static const fec_code_t s_codes[] = { { 4, 1 }, { 4, 2 }, { 8, 2 }, { 8, 4 } };
+static const int        s_loss_pct[] = { 10, 20, 30 };
+
+typedef struct {
+    uint32_t recovered;
+    uint32_t mismatches;
+    uint8_t  delivered[FEC_SIM_FRAMES + FEC_SIM_FRAMES / (FEC_SIM_TLM_EVERY - 1) + 2];
+} fec_run_t;
+
+static rmds_fec_tx_t s_tx;
+static rmds_fec_rx_t s_rx;
+static fec_run_t     s_run;
+
+// The frame with sequence number seq, the same every time
+static size_t fec_frame(uint32_t seq, char *buf)
+{
+    uint32_t rng = seq * 2654435761u + 1;
+    size_t len = FEC_SIM_LEN_MIN + sim_rand(&rng) % (FEC_SIM_LEN_MAX - FEC_SIM_LEN_MIN + 1);
+    size_t n = (size_t)snprintf(buf, len + 1, "SEQ=%lu,NODE=%06lx,S0=%lu,BAT=3900,R=",
+                                (unsigned long)seq, (unsigned long)FEC_SIM_NODE,
+                                (unsigned long)seq * 6);
+    while (n < len) {
+        buf[n++] = (char)(sim_rand(&rng) % 5 == 0 ? ',' : '0' + sim_rand(&rng) % 10);
+    }
+    return len;
+}
+
+static int64_t fec_airtime_us(size_t len)
+{
+    return rmds_tdma_airtime_us((int)len, SIM_SF, SIM_BW_HZ, SIM_CR, SIM_PREAMBLE);
+}
+
+static void fec_rebuilt(uint32_t node, uint32_t seq, const uint8_t *frame, size_t len, void *arg)
+{
+    fec_run_t *r = arg;
+    char want[FEC_SIM_LEN_MAX + 1];
+    size_t want_len = fec_frame(seq, want);
+
+    if (node != FEC_SIM_NODE || seq >= sizeof(r->delivered) || r->delivered[seq] ||
+        len != want_len || memcmp(frame, want, len) != 0) {
+        r->mismatches++;
+        return;
+    }
+    r->delivered[seq] = 1;
+    r->recovered++;
+}
+
+static void fec_run(const fec_code_t *code, int loss_pct, uint32_t *plain, double *overhead)
+{
+    fec_run_t *r = &s_run;
+    memset(r, 0, sizeof(*r));
+    rmds_fec_tx_init(&s_tx, code->k, code->m);
+    rmds_fec_rx_init(&s_rx);
+
+    uint32_t rng = 0x6A09E667u + loss_pct * 31 + code->k * 7 + code->m;
+    int64_t data_us = 0, repair_us = 0;
+    uint32_t frames = 0, seq = 0;
+    *plain = 0;
+
+    for (; frames < FEC_SIM_FRAMES; seq++) {
+        if (seq % FEC_SIM_TLM_EVERY == FEC_SIM_TLM_EVERY - 1) {
+            continue;   // telemetry: takes a sequence number, isn't coded
+        }
+        char frame[FEC_SIM_LEN_MAX + 1];
+        size_t len = fec_frame(seq, frame);
+        frames++;
+        data_us += fec_airtime_us(len);
+
+        if ((int)(sim_rand(&rng) % 100) >= loss_pct) {
+            (*plain)++;
+            r->delivered[seq] = 1;
+            rmds_fec_rx_data(&s_rx, FEC_SIM_NODE, seq, frame, len);
+        }
+
+        if (!rmds_fec_tx_add(&s_tx, seq, frame, len)) {
+            continue;
+        }
+        for (int j = 0; j < code->m; j++) {
+            uint8_t pkt[RMDS_FEC_PACKET_MAX];
+            int pkt_len = rmds_fec_tx_repair(&s_tx, j, FEC_SIM_NODE, pkt, sizeof(pkt));
+            if (pkt_len < 0) {
+                r->mismatches++;
+                continue;
+            }
+            repair_us += fec_airtime_us(pkt_len);
+            if ((int)(sim_rand(&rng) % 100) >= loss_pct) {
+                rmds_fec_rx_repair(&s_rx, pkt, pkt_len, fec_rebuilt, r);
+            }
+        }
+        rmds_fec_tx_next(&s_tx);
+    }
+
+    *overhead = 100.0 * repair_us / data_us;
+}
+
+void fec_sim(void)
+{
+    for (size_t c = 0; c < sizeof(s_codes) / sizeof(s_codes[0]); c++) {
+        for (size_t l = 0; l < sizeof(s_loss_pct) / sizeof(s_loss_pct[0]); l++) {
+            uint32_t plain;
+            double overhead;
+            fec_run(&s_codes[c], s_loss_pct[l], &plain, &overhead);
+            printf("FEC k=%d m=%d loss=%d%% delivered plain=%.2f%% fec=%.2f%% recovered=%lu "
+                   "mismatches=%lu airtime +%.1f%%\n",
+                   s_codes[c].k, s_codes[c].m, s_loss_pct[l],
+                   sim_percent(plain, FEC_SIM_FRAMES),
+                   sim_percent(plain + s_run.recovered, FEC_SIM_FRAMES),
+                   (unsigned long)s_run.recovered, (unsigned long)s_run.mismatches, overhead);
+        }
+    }
+}
@@ -0,0 +1,32 @@
+// link_sim.c
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "link_sim.h"
+
+uint32_t sim_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+double sim_percent(uint64_t part, uint64_t whole)
+{
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+void app_main(void)
+{
+    tdma_sim();
+    nodes_sim();
+    arq_sim();
+    fec_sim();
+
+    printf("Link sim done\n");
+    fflush(stdout);
+    exit(0);
+}
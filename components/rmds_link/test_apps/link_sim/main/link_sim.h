@@ -0,0 +1,23 @@
+// link_sim.h
+//
+// Host simulations of the LoRa link options in rmds_link, one file each,
+// run in turn by link_sim.c. pytest_link_sim.py checks their result lines.
+#pragma once
+
+#include <stdint.h>
+
+// SF7, 125 kHz, CR 4/5, 8-symbol preamble, as rmds_lora.c sets the radio
+#define SIM_SF          7
+#define SIM_BW_HZ       125000L
+#define SIM_CR          5
+#define SIM_PREAMBLE    8
+
+// xorshift32; state must not be zero
+uint32_t sim_rand(uint32_t *state);
+
+double sim_percent(uint64_t part, uint64_t whole);
+
+void tdma_sim(void);
+void nodes_sim(void);
+void arq_sim(void);
+void fec_sim(void);
@@ -0,0 +1,163 @@
+// nodes_sim.c
+//
+// Gateway node table (rmds_nodes.h) under a full load of sensors. Every
+// node sends a run of packets through a channel that loses some, repeats
+// some and delays some past later ones; the table's per-node counters are
+// compared with what was actually delivered. Then one node restarts, the
+// silent half of the table expires, and nodes beyond the load limit are
+// refused while every remaining one is still found. Last, the cost of an
+// update on the full table.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "rmds_nodes.h"
+#include "link_sim.h"
+
+#define NODES_SIM_PACKETS     200     // per node
+#define NODES_SIM_LOSS_PCT    10
+#define NODES_SIM_DUP_PCT     5
+#define NODES_SIM_LATE_PCT    5       // held back and delivered a few packets later
+#define NODES_SIM_LATE_MAX    8
+#define NODES_SIM_BENCH       1000000
+
+typedef struct {
+    uint32_t id;
+    uint32_t delivered;     // distinct
+    uint32_t duplicates;
+    uint32_t first, last;   // sequence range delivered
+    uint32_t held_seq;      // late packet waiting, valid if held > 0
+    int      held;          // packets until it is delivered
+} nodes_truth_t;
+
+static rmds_nodes_t  s_table;
+static nodes_truth_t s_truth[RMDS_NODES_MAX_LOAD];
+
+static void nodes_deliver(nodes_truth_t *n, uint32_t seq, int64_t now_ms, uint32_t *rng, int *mismatches)
+{
+    rmds_node_pkt_t verdict = rmds_nodes_update(&s_table, n->id, seq, -90 - (int)(seq % 20),
+                                                 5.0f, now_ms, NULL);
+    bool first = n->delivered == 0;
+    if (first) {
+        n->first = n->last = seq;
+    }
+    n->delivered++;
+    if (seq > n->last) {
+        n->last = seq;
+    }
+    if (seq < n->first) {
+        n->first = seq;
+    }
+    if (verdict != (first ? RMDS_NODE_PKT_FIRST : seq == n->last ? RMDS_NODE_PKT_NEW : RMDS_NODE_PKT_LATE)) {
+        (*mismatches)++;
+    }
+
+    if (sim_rand(rng) % 100 < NODES_SIM_DUP_PCT) {
+        n->duplicates++;
+        if (rmds_nodes_update(&s_table, n->id, seq, -90, 5.0f, now_ms, NULL) != RMDS_NODE_PKT_DUPLICATE) {
+            (*mismatches)++;
+        }
+    }
+}
+
+static int nodes_check(const nodes_truth_t *n)
+{
+    rmds_node_entry_t *e = rmds_nodes_find(&s_table, n->id);
+    if (e == NULL) {
+        return 1;
+    }
+    uint32_t lost = n->last - n->first + 1 - n->delivered;
+    return (e->packets != n->delivered) + (e->duplicates != n->duplicates) +
+           (e->lost != lost) + (e->last_seq != n->last) +
+           (e->rssi_q4 > -90 * 16 || e->rssi_q4 < -110 * 16);
+}
+
+void nodes_sim(void)
+{
+    uint32_t rng = 0x9E3779B9u;
+    int mismatches = 0;
+    int64_t now_ms = 0;
+
+    rmds_nodes_init(&s_table);
+
+    // Node IDs as rmds_lora.c makes them: 24 bits of MAC, often close together
+    for (int i = 0; i < RMDS_NODES_MAX_LOAD; i++) {
+        s_truth[i] = (nodes_truth_t){ .id = (i % 2 ? 0x3C6105u + i : sim_rand(&rng) & 0xFFFFFF) | 1 };
+        for (int j = 0; j < i; j++) {
+            if (s_truth[j].id == s_truth[i].id) {
+                s_truth[i].id += 2;
+                j = -1;
+            }
+        }
+    }
+
+    uint64_t sent = 0;
+    for (uint32_t seq = 0; seq < NODES_SIM_PACKETS; seq++, now_ms += 1000) {
+        for (int i = 0; i < RMDS_NODES_MAX_LOAD; i++) {
+            nodes_truth_t *n = &s_truth[i];
+            sent++;
+            if (n->held > 0 && --n->held == 0) {
+                nodes_deliver(n, n->held_seq, now_ms, &rng, &mismatches);
+            }
+            uint32_t r = sim_rand(&rng) % 100;
+            if (r < NODES_SIM_LOSS_PCT) {
+                continue;
+            }
+            if (r < NODES_SIM_LOSS_PCT + NODES_SIM_LATE_PCT && n->held == 0 && seq > 0) {
+                n->held_seq = seq;
+                n->held = 1 + (int)(sim_rand(&rng) % NODES_SIM_LATE_MAX);
+                continue;
+            }
+            nodes_deliver(n, seq, now_ms, &rng, &mismatches);
+        }
+    }
+    for (int i = 0; i < RMDS_NODES_MAX_LOAD; i++) {
+        mismatches += nodes_check(&s_truth[i]);
+    }
+
+    // A cold boot sets the node's counter back to 0
+    if (rmds_nodes_update(&s_table, s_truth[0].id, 0, -90, 5.0f, now_ms, NULL) != RMDS_NODE_PKT_RESTART ||
+        rmds_nodes_update(&s_table, s_truth[0].id, 1, -90, 5.0f, now_ms, NULL) != RMDS_NODE_PKT_NEW) {
+        mismatches++;
+    }
+
+    // Full: a newcomer is turned away, the known ones still get through
+    uint32_t refused = 0;
+    for (uint32_t id = 0xF00001; id < 0xF00001 + 2 * 8; id += 2) {
+        refused += rmds_nodes_update(&s_table, id, 0, -90, 5.0f, now_ms, NULL) == RMDS_NODE_PKT_FULL;
+    }
+
+    // Odd nodes keep talking, the even ones go quiet and expire
+    now_ms += 60000;
+    for (int i = 1; i < RMDS_NODES_MAX_LOAD; i += 2) {
+        rmds_nodes_update(&s_table, s_truth[i].id, NODES_SIM_PACKETS + 1, -90, 5.0f, now_ms, NULL);
+    }
+    uint32_t expired = rmds_nodes_expire(&s_table, now_ms, 30000);
+    for (int i = 0; i < RMDS_NODES_MAX_LOAD; i++) {
+        bool found = rmds_nodes_find(&s_table, s_truth[i].id) != NULL;
+        mismatches += found != (i % 2 == 1);
+    }
+    if (s_table.count != RMDS_NODES_MAX_LOAD - expired) {
+        mismatches++;
+    }
+
+    // Update cost with the table full again
+    for (int i = 0; i < RMDS_NODES_MAX_LOAD; i += 2) {
+        rmds_nodes_update(&s_table, s_truth[i].id, 0, -90, 5.0f, now_ms, NULL);
+    }
+    int64_t start = esp_timer_get_time();
+    for (uint32_t k = 0; k < NODES_SIM_BENCH; k++) {
+        const nodes_truth_t *n = &s_truth[sim_rand(&rng) % RMDS_NODES_MAX_LOAD];
+        rmds_nodes_update(&s_table, n->id, k, -90, 5.0f, now_ms, NULL);
+    }
+    int64_t us = esp_timer_get_time() - start;
+
+    printf("NODES nodes=%d capacity=%d packets=%llu mismatches=%d refused=%lu expired=%lu "
+           "(%.0f ns per update, %u bytes)\n",
+           RMDS_NODES_MAX_LOAD, RMDS_NODES_CAPACITY, (unsigned long long)sent, mismatches,
+           (unsigned long)refused, (unsigned long)expired,
+           us * 1000.0 / NODES_SIM_BENCH, (unsigned)sizeof(s_table));
+}
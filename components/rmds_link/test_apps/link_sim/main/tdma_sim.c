@@ -0,0 +1,339 @@
+// tdma_sim.c
+//
+// Channel capacity of gateway-coordinated TDMA (rmds_tdma.h) against the
+// current free-running senders. N nodes in one collision domain (no
+// capture), each producing a batch packet every SIM_REPORT_MS from its own
+// timer with a random phase and a few ppm of drift. The packet is ready up
+// to SIM_WAKE_JITTER_MS after the timer fires (boot, then waiting for the
+// next sensor frame on the UART).
+//
+//   blind: the packet goes out the moment it is produced, as the TX task
+//          does today
+//   tdma:  the node waits for the next beacon and sends in its slot; the
+//          beacon, the schedule and slot assignment are rmds_tdma.c, with
+//          every node starting unassigned and joining through the
+//          contention slot. Beacons are formatted and parsed back as on
+//          the radio. A node sees the beacon up to one RX poll late
+//          and wakes up to one tick late for its slot.
+//
+// A packet is delivered if no other transmission overlaps it; there are no
+// retries. Only packets produced after a warm-up are counted.
+//
+// A last run replaces a quarter of a full schedule halfway through to show
+// slots moving from the nodes that left to the ones that joined.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rmds_tdma.h"
+#include "link_sim.h"
+
+#define SIM_PAYLOAD_BYTES   130     // one 6-reading batch
+#define SIM_REPORT_MS       8000
+#define SIM_DURATION_MS     4000000
+#define SIM_WARMUP_MS       300000  // every node joined
+#define SIM_WAKE_JITTER_MS  500
+#define SIM_TAIL_MS         (2 * SIM_REPORT_MS)     // still in flight at the end
+#define SIM_DRIFT_PPM       20
+#define SIM_QUEUE_MAX       4
+
+// Firmware timing: beacon seen at the next 10 ms poll, slot start rounded
+// up to the next tick, so a node is 0..20 ms late
+#define SIM_LATE_MS         20
+#define SIM_EXPIRE_MS       (4 * SIM_REPORT_MS)
+
+#define SIM_MAX_NODES       40
+#define SIM_MAX_PACKETS     (SIM_MAX_NODES * (SIM_DURATION_MS / SIM_REPORT_MS + 2))
+
+static const int s_node_counts[] = { 1, 2, 4, 8, 16, 24, 32 };
+
+typedef struct {
+    int64_t start_us;
+    int64_t end_us;
+    int64_t gen_us;
+    int     node;
+    bool    hit;
+} sim_tx_t;
+
+typedef struct {
+    uint64_t generated;
+    uint64_t sent;
+    uint64_t delivered;
+    uint64_t collided;
+    int64_t  latency_us;    // produced to end of transmission, delivered ones
+} sim_result_t;
+
+typedef struct {
+    int64_t  next_gen_us;   // timer
+    int64_t  ready_us;      // packet of that timer ready to send
+    int64_t  period_us;
+    int64_t  stop_us;       // stops producing (leaves) here
+    int64_t  queue[SIM_QUEUE_MAX];
+    int      head;
+    int      queued;
+    int      failures;      // join attempts that got no slot
+    uint32_t skip;          // superframes to sit out before the next one
+    bool     joining;       // sent in the join slot last superframe
+} sim_node_t;
+
+static sim_tx_t   s_tx[SIM_MAX_PACKETS];
+static sim_node_t s_nodes[SIM_MAX_NODES];
+
+static bool sim_counted(int64_t gen_us)
+{
+    return gen_us >= SIM_WARMUP_MS * 1000LL &&
+           gen_us < (SIM_DURATION_MS - SIM_TAIL_MS) * 1000LL;
+}
+
+// Node ID as the firmware uses it: non-zero, arbitrary
+static uint32_t sim_node_id(int n)
+{
+    return 0xA00000u + (uint32_t)n * 0x1F3u + 1;
+}
+
+// Packet ready time for the timer firing at timer_us
+static int64_t sim_ready_us(int64_t timer_us, uint32_t *rng)
+{
+    return timer_us + sim_rand(rng) % (SIM_WAKE_JITTER_MS * 1000);
+}
+
+static void sim_node_init(sim_node_t *node, int64_t start_us, uint32_t *rng)
+{
+    memset(node, 0, sizeof(*node));
+    int ppm = (int)(sim_rand(rng) % (2 * SIM_DRIFT_PPM + 1)) - SIM_DRIFT_PPM;
+    node->period_us = SIM_REPORT_MS * 1000LL + SIM_REPORT_MS * 1000LL * ppm / 1000000;
+    node->next_gen_us = start_us + sim_rand(rng) % (SIM_REPORT_MS * 1000u);
+    node->stop_us = INT64_MAX;
+}
+
+// Mark every transmission that overlaps another one
+static void sim_collide(sim_tx_t *tx, int count)
+{
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count && tx[j].start_us < tx[i].end_us; j++) {
+            if (tx[j].end_us > tx[i].start_us) {
+                tx[i].hit = tx[j].hit = true;
+            }
+        }
+    }
+}
+
+static int sim_tx_cmp(const void *a, const void *b)
+{
+    const sim_tx_t *x = a, *y = b;
+    return x->start_us < y->start_us ? -1 : x->start_us > y->start_us;
+}
+
+static void sim_account(const sim_tx_t *tx, sim_result_t *r)
+{
+    if (!sim_counted(tx->gen_us)) {
+        return;
+    }
+    r->sent++;
+    if (tx->hit) {
+        r->collided++;
+    } else {
+        r->delivered++;
+        r->latency_us += tx->end_us - tx->gen_us;
+    }
+}
+
+// Every packet on air as soon as it is produced
+static void sim_blind(int nodes, sim_result_t *r)
+{
+    const int64_t airtime = rmds_tdma_airtime_us(SIM_PAYLOAD_BYTES, SIM_SF, SIM_BW_HZ,
+                                                 SIM_CR, SIM_PREAMBLE);
+    uint32_t rng = 0x2545F491u;
+    int count = 0;
+
+    memset(r, 0, sizeof(*r));
+    for (int n = 0; n < nodes; n++) {
+        sim_node_t *node = &s_nodes[n];
+        sim_node_init(node, 0, &rng);
+        for (; node->next_gen_us < SIM_DURATION_MS * 1000LL; node->next_gen_us += node->period_us) {
+            int64_t ready = sim_ready_us(node->next_gen_us, &rng);
+            r->generated += sim_counted(ready);
+            s_tx[count++] = (sim_tx_t){
+                .start_us = ready,
+                .end_us   = ready + airtime,
+                .gen_us   = ready,
+                .node     = n,
+            };
+        }
+    }
+
+    qsort(s_tx, count, sizeof(s_tx[0]), sim_tx_cmp);
+    sim_collide(s_tx, count);
+    for (int i = 0; i < count; i++) {
+        sim_account(&s_tx[i], r);
+    }
+}
+
+/**
+ * Superframe by superframe. Nodes [0, nodes) start at 0; with churn > 0
+ * nodes [0, churn) stop producing halfway and nodes [nodes, nodes + churn)
+ * start then. Results of the late joiners go to *joiners if given.
+ */
+static void sim_tdma(int nodes, int churn, sim_result_t *r, sim_result_t *joiners,
+                     rmds_tdma_sched_t *sched)
+{
+    const int64_t airtime = rmds_tdma_airtime_us(SIM_PAYLOAD_BYTES, SIM_SF, SIM_BW_HZ,
+                                                 SIM_CR, SIM_PREAMBLE);
+    const int64_t half_us = SIM_DURATION_MS * 1000LL / 2;
+    const int total = nodes + churn;
+    uint32_t rng = 0x2545F491u;
+
+    memset(r, 0, sizeof(*r));
+    if (joiners) {
+        memset(joiners, 0, sizeof(*joiners));
+    }
+    for (int n = 0; n < total; n++) {
+        sim_node_init(&s_nodes[n], n < nodes ? 0 : half_us, &rng);
+        if (n < churn) {
+            s_nodes[n].stop_us = half_us;
+        }
+        s_nodes[n].ready_us = sim_ready_us(s_nodes[n].next_gen_us, &rng);
+    }
+    rmds_tdma_sched_init(sched, RMDS_TDMA_SLOT_MS, SIM_EXPIRE_MS);
+
+    int64_t t = 0;
+    while (t < SIM_DURATION_MS * 1000LL) {
+        // Nodes see the beacon as it goes over the air
+        rmds_tdma_beacon_t sent, b;
+        char text[RMDS_TDMA_BEACON_MAX_LEN];
+        rmds_tdma_sched_beacon(sched, (uint32_t)(t / 1000), &sent);
+        if (rmds_tdma_beacon_format(&sent, text, sizeof(text)) < 0 ||
+            !rmds_tdma_beacon_parse(text, &b) || b.period_ms != sent.period_ms) {
+            abort();
+        }
+        int count = 0;
+
+        for (int n = 0; n < total; n++) {
+            sim_node_t *node = &s_nodes[n];
+            sim_result_t *res = n >= nodes && joiners ? joiners : r;
+
+            // Whatever was ready before the beacon goes this superframe
+            while (node->ready_us < t) {
+                res->generated += sim_counted(node->ready_us);
+                if (node->queued == SIM_QUEUE_MAX) {
+                    node->head = (node->head + 1) % SIM_QUEUE_MAX;  // oldest lost
+                    node->queued--;
+                }
+                node->queue[(node->head + node->queued++) % SIM_QUEUE_MAX] = node->ready_us;
+
+                node->next_gen_us += node->period_us;
+                node->ready_us = node->next_gen_us < node->stop_us ?
+                                 sim_ready_us(node->next_gen_us, &rng) : INT64_MAX;
+            }
+
+            int slot = rmds_tdma_slot_of(&b, sim_node_id(n));
+            if (slot == RMDS_TDMA_JOIN_SLOT && node->joining) {
+                // Last join went unheard or found no free slot
+                node->failures++;
+                node->skip = rmds_tdma_join_skip(sim_rand(&rng), node->failures);
+            } else if (slot != RMDS_TDMA_JOIN_SLOT) {
+                node->failures = 0;
+            }
+            node->joining = false;
+
+            if (node->queued == 0) {
+                continue;
+            }
+
+            int64_t start = t + rmds_tdma_slot_start_ms(&b, slot) * 1000LL +
+                            sim_rand(&rng) % (SIM_LATE_MS * 1000);
+            if (slot == RMDS_TDMA_JOIN_SLOT) {
+                if (node->skip > 0) {
+                    node->skip--;
+                    continue;
+                }
+                // Random offset in the join slot, still ending inside it
+                int64_t spread = b.slot_ms * 1000LL - airtime - SIM_LATE_MS * 1000;
+                start += sim_rand(&rng) % (uint32_t)spread;
+                node->joining = true;
+            }
+
+            s_tx[count++] = (sim_tx_t){
+                .start_us = start,
+                .end_us   = start + airtime,
+                .gen_us   = node->queue[node->head],
+                .node     = n,
+            };
+            node->head = (node->head + 1) % SIM_QUEUE_MAX;
+            node->queued--;
+        }
+
+        qsort(s_tx, count, sizeof(s_tx[0]), sim_tx_cmp);
+        sim_collide(s_tx, count);
+        for (int i = 0; i < count; i++) {
+            const sim_tx_t *tx = &s_tx[i];
+            if (tx->end_us > t + b.period_ms * 1000LL) {
+                abort();    // ran into the next beacon
+            }
+            sim_account(tx, tx->node >= nodes && joiners ? joiners : r);
+            if (!tx->hit) {
+                rmds_tdma_sched_heard(sched, sim_node_id(tx->node), (uint32_t)(tx->end_us / 1000));
+            }
+        }
+
+        t += b.period_ms * 1000LL;
+    }
+}
+
+static void tdma_sim_print(int nodes, const sim_result_t *blind, const sim_result_t *tdma,
+                           const rmds_tdma_sched_t *sched)
+{
+    const int64_t airtime = rmds_tdma_airtime_us(SIM_PAYLOAD_BYTES, SIM_SF, SIM_BW_HZ,
+                                                 SIM_CR, SIM_PREAMBLE);
+    const double window_us = (SIM_DURATION_MS - SIM_TAIL_MS - SIM_WARMUP_MS) * 1000.0;
+
+    printf("TDMA nodes=%d delivered blind=%.1f%% tdma=%.1f%% "
+           "collided blind=%.1f%% tdma=%.1f%% "
+           "goodput blind=%.1f%% tdma=%.1f%% "
+           "(tdma: %.0f ms avg latency, %d slots owned, %lu refused)\n",
+           nodes,
+           sim_percent(blind->delivered, blind->generated),
+           sim_percent(tdma->delivered, tdma->generated),
+           sim_percent(blind->collided, blind->sent),
+           sim_percent(tdma->collided, tdma->sent),
+           100.0 * blind->delivered * airtime / window_us,
+           100.0 * tdma->delivered * airtime / window_us,
+           tdma->delivered ? (double)tdma->latency_us / tdma->delivered / 1000 : 0.0,
+           rmds_tdma_sched_owned(sched),
+           (unsigned long)sched->refused);
+}
+
+void tdma_sim(void)
+{
+    const int64_t airtime = rmds_tdma_airtime_us(SIM_PAYLOAD_BYTES, SIM_SF, SIM_BW_HZ,
+                                                 SIM_CR, SIM_PREAMBLE);
+    rmds_tdma_sched_t sched;
+    sim_result_t blind, tdma, joiners;
+
+    printf("TDMA sim: %d B packets (%lld ms on air) every %d ms per node, "
+           "%d slots of %d ms, superframe up to %lu ms\n",
+           SIM_PAYLOAD_BYTES, (long long)(airtime / 1000), SIM_REPORT_MS,
+           RMDS_TDMA_MAX_SLOTS, RMDS_TDMA_SLOT_MS,
+           (unsigned long)rmds_tdma_period_ms(RMDS_TDMA_MAX_SLOTS, RMDS_TDMA_SLOT_MS));
+
+    for (size_t i = 0; i < sizeof(s_node_counts) / sizeof(s_node_counts[0]); i++) {
+        int nodes = s_node_counts[i];
+        sim_blind(nodes, &blind);
+        sim_tdma(nodes, 0, &tdma, NULL, &sched);
+        tdma_sim_print(nodes, &blind, &tdma, &sched);
+    }
+
+    // A quarter of a full schedule leaves, as many new nodes arrive
+    const int churn = RMDS_TDMA_MAX_SLOTS / 4;
+    sim_tdma(RMDS_TDMA_MAX_SLOTS, churn, &tdma, &joiners, &sched);
+    printf("TDMA churn left=%d joined=%d delivered stayed=%.1f%% joined=%.1f%% "
+           "(%lu slots handed out, %lu expired, %d owned)\n",
+           churn, churn,
+           sim_percent(tdma.delivered, tdma.generated),
+           sim_percent(joiners.delivered, joiners.generated),
+           (unsigned long)sched.joins,
+           (unsigned long)sched.leaves,
+           rmds_tdma_sched_owned(&sched));
+}
@@ -0,0 +1,99 @@
+# SPDX-License-Identifier: CC0-1.0
+import logging
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+
+TDMA_NODE_COUNTS = [1, 2, 4, 8, 16, 24, 32]
+TDMA_MAX_SLOTS = 16
+ARQ_LOSS_PCTS = [0, 10, 20, 30, 50]
+FEC_CODES = [(4, 1), (4, 2), (8, 2), (8, 4)]
+FEC_LOSS_PCTS = [10, 20, 30]
+
+
+def check_tdma(dut: IdfDut) -> None:
+    runs = {}
+    for nodes in TDMA_NODE_COUNTS:
+        m = dut.expect(rf'TDMA nodes={nodes} delivered blind=([0-9.]+)% tdma=([0-9.]+)% '
+                       r'collided blind=([0-9.]+)% tdma=([0-9.]+)% '
+                       r'goodput blind=([0-9.]+)% tdma=([0-9.]+)%')
+        runs[nodes] = [float(g) for g in m.groups()]
+        logging.info(f'{nodes} nodes: delivered blind {runs[nodes][0]:.1f}% tdma {runs[nodes][1]:.1f}%, '
+                     f'goodput blind {runs[nodes][4]:.1f}% tdma {runs[nodes][5]:.1f}%')
+    m = dut.expect(r'TDMA churn left=(\d+) joined=(\d+) delivered stayed=([0-9.]+)% joined=([0-9.]+)% '
+                   r'\((\d+) slots handed out, (\d+) expired, (\d+) owned\)')
+    left, stayed, joined = int(m.group(1)), float(m.group(3)), float(m.group(4))
+    expired, owned = int(m.group(6)), int(m.group(7))
+
+    for nodes, (blind, tdma, _, tdma_hit, blind_put, tdma_put) in runs.items():
+        if nodes <= TDMA_MAX_SLOTS:
+            # Everyone has a slot: nothing may collide once the joins are done
+            assert tdma == 100.0 and tdma_hit == 0.0, f'{nodes} nodes: tdma {tdma:.1f}% delivered'
+        assert tdma >= blind, f'{nodes} nodes: tdma {tdma:.1f}% is worse than blind {blind:.1f}%'
+    blind_put, tdma_put = runs[TDMA_MAX_SLOTS][4], runs[TDMA_MAX_SLOTS][5]
+    assert tdma_put >= 2 * blind_put, f'full schedule: goodput {tdma_put:.1f}% vs blind {blind_put:.1f}%'
+
+    # The nodes that left give their slots to the ones that came
+    assert expired == left and owned == TDMA_MAX_SLOTS
+    assert stayed == 100.0 and joined >= 95.0, f'churn: stayed {stayed:.1f}%, joined {joined:.1f}%'
+
+
+def check_nodes(dut: IdfDut) -> None:
+    m = dut.expect(r'NODES nodes=(\d+) capacity=(\d+) packets=(\d+) mismatches=(\d+) refused=(\d+) expired=(\d+) '
+                   r'\(([0-9.]+) ns per update')
+    nodes, mismatches, refused, expired = int(m.group(1)), int(m.group(4)), int(m.group(5)), int(m.group(6))
+    logging.info(f'node table: {nodes} nodes, {m.group(7)} ns per update')
+
+    # Counters match the channel exactly; the half that went quiet is gone
+    assert mismatches == 0, f'{mismatches} node table mismatches'
+    assert refused > 0 and expired == nodes // 2
+
+
+def check_arq(dut: IdfDut) -> None:
+    for loss in ARQ_LOSS_PCTS:
+        m = dut.expect(rf'ARQ loss={loss}% delivered plain=([0-9.]+)% arq=([0-9.]+)% retries=([0-9.]+) per frame '
+                       r'\((\d+) gave up, (\d+) evicted, (\d+) duplicates dropped, (\d+) mismatches, '
+                       r'airtime x([0-9.]+)\)')
+        plain, arq, retries = float(m.group(1)), float(m.group(2)), float(m.group(3))
+        mismatches = int(m.group(7))
+        logging.info(f'{loss}% loss: delivered plain {plain:.2f}% arq {arq:.2f}%, '
+                     f'{retries:.3f} retries per frame, airtime x{m.group(8)}')
+
+        # Nothing forwarded twice however often it was resent
+        assert mismatches == 0, f'{loss}% loss: {mismatches} mismatches'
+        assert arq >= plain
+        if loss == 0:
+            assert arq == 100.0 and retries == 0.0
+        elif loss <= 30:
+            assert arq >= 99.5, f'{loss}% loss: arq delivered {arq:.2f}%'
+
+
+
+def check_fec(dut: IdfDut) -> None:
+    for k, m in FEC_CODES:
+        for loss in FEC_LOSS_PCTS:
+            r = dut.expect(rf'FEC k={k} m={m} loss={loss}% delivered plain=([0-9.]+)% fec=([0-9.]+)% '
+                           r'recovered=(\d+) mismatches=(\d+) airtime \+([0-9.]+)%')
+            plain, fec, recovered = float(r.group(1)), float(r.group(2)), int(r.group(3))
+            mismatches, overhead = int(r.group(4)), float(r.group(5))
+            logging.info(f'k={k} m={m}, {loss}% loss: delivered plain {plain:.2f}% fec {fec:.2f}%, '
+                         f'{recovered} rebuilt, airtime +{overhead:.1f}%')
+
+            # Rebuilt frames are exactly the ones sent
+            assert mismatches == 0, f'k={k} m={m} {loss}% loss: {mismatches} mismatches'
+            assert recovered > 0 and fec > plain
+            # Repairs are as long as the longest frame of their group, plus a header
+            assert overhead < 100 * m / k * 1.6, f'k={k} m={m}: airtime +{overhead:.1f}%'
+            if loss == 10 and 2 * m >= k:
+                assert fec >= 99.0, f'k={k} m={m} {loss}% loss: fec delivered {fec:.2f}%'
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_rmds_link_sim(dut: IdfDut) -> None:
+    check_tdma(dut)
+    check_nodes(dut)
+    check_arq(dut)
+    check_fec(dut)
+    dut.expect('Link sim done')
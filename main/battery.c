@@ -0,0 +1,192 @@
+// battery.c
+//
+// Battery voltage on ADC1 and the reporting policy derived from it. As the
+// cell runs down the node samples less often, batches more readings per
+// transmission and lowers its TX power, so it fades out gradually instead
+// of stopping dead. Alarm readings bypass all of this (see main.c).
+
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+
+#include "battery.h"
+#include "rmds_samples.h"
+
+#define BATTERY_TAG            "BATTERY"
+
+// Battery sense: GPIO35 (ADC1_CH7, input only) behind two equal
+// resistors, so the pin sees half the cell voltage
+#define BATTERY_ADC_UNIT       ADC_UNIT_1
+#define BATTERY_ADC_CHANNEL    ADC_CHANNEL_7
+#define BATTERY_ADC_ATTEN      ADC_ATTEN_DB_12
+#define BATTERY_DIVIDER        2
+#define BATTERY_ADC_SAMPLES    16      // averaged per reading
+
+// Band thresholds for a single Li-ion cell (mV). A band is entered when the
+// voltage drops below its threshold and left only once it climbs
+// BATTERY_HYSTERESIS_MV above it, so load/temperature noise can't make the
+// node flip between schedules.
+#define BATTERY_SAVE_MV        3700
+#define BATTERY_LOW_MV         3550
+#define BATTERY_CRITICAL_MV    3400
+#define BATTERY_HYSTERESIS_MV  50
+
+// Below this nothing is on the divider (bench supply / USB): run at full rate
+#define BATTERY_ABSENT_MV      2500
+
+static const uint32_t s_band_mv[BATTERY_LEVEL_COUNT] = {
+    [BATTERY_NORMAL]   = 0,
+    [BATTERY_SAVE]     = BATTERY_SAVE_MV,
+    [BATTERY_LOW]      = BATTERY_LOW_MV,
+    [BATTERY_CRITICAL] = BATTERY_CRITICAL_MV,
+};
+
+static const battery_policy_t s_policy[BATTERY_LEVEL_COUNT] = {
+    [BATTERY_NORMAL]   = { .interval_mult = 1, .tx_every_n = RMDS_SAMPLES_TX_EVERY_N,     .tx_power_dbm = 17 },
+    [BATTERY_SAVE]     = { .interval_mult = 2, .tx_every_n = RMDS_SAMPLES_TX_EVERY_N * 2, .tx_power_dbm = 14 },
+    [BATTERY_LOW]      = { .interval_mult = 4, .tx_every_n = RMDS_SAMPLES_TX_EVERY_N * 3, .tx_power_dbm = 11 },
+    [BATTERY_CRITICAL] = { .interval_mult = 8, .tx_every_n = RMDS_SAMPLES_RING_LEN,       .tx_power_dbm = 8 },
+};
+
+static const char *s_level_name[BATTERY_LEVEL_COUNT] = {
+    [BATTERY_NORMAL]   = "normal",
+    [BATTERY_SAVE]     = "save",
+    [BATTERY_LOW]      = "low",
+    [BATTERY_CRITICAL] = "critical",
+};
+
+// Kept across deep sleep so the hysteresis has something to compare against
+RTC_DATA_ATTR static uint32_t s_mv = 0;
+RTC_DATA_ATTR static uint32_t s_level = BATTERY_NORMAL;
+
+// Average BATTERY_ADC_SAMPLES conversions; the unit is torn down again
+// afterwards so the ADC draws nothing between wakes
+static esp_err_t battery_read_pin_mv(uint32_t *out_mv)
+{
+    adc_oneshot_unit_handle_t adc = NULL;
+    adc_cali_handle_t cali = NULL;
+
+    adc_oneshot_unit_init_cfg_t unit_cfg = {
+        .unit_id = BATTERY_ADC_UNIT,
+    };
+    esp_err_t err = adc_oneshot_new_unit(&unit_cfg, &adc);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    adc_oneshot_chan_cfg_t chan_cfg = {
+        .atten    = BATTERY_ADC_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    err = adc_oneshot_config_channel(adc, BATTERY_ADC_CHANNEL, &chan_cfg);
+
+    // eFuse Vref calibration; without it fall back to the nominal 12 dB range
+    adc_cali_line_fitting_config_t cali_cfg = {
+        .unit_id  = BATTERY_ADC_UNIT,
+        .atten    = BATTERY_ADC_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    if (adc_cali_create_scheme_line_fitting(&cali_cfg, &cali) != ESP_OK) {
+        cali = NULL;
+    }
+
+    int64_t sum_mv = 0;
+    for (int i = 0; err == ESP_OK && i < BATTERY_ADC_SAMPLES; i++) {
+        int raw = 0;
+        int mv = 0;
+        err = adc_oneshot_read(adc, BATTERY_ADC_CHANNEL, &raw);
+        if (err != ESP_OK) {
+            break;
+        }
+        if (cali == NULL || adc_cali_raw_to_voltage(cali, raw, &mv) != ESP_OK) {
+            mv = raw * 3100 / 4095;
+        }
+        sum_mv += mv;
+    }
+
+    if (cali) {
+        adc_cali_delete_scheme_line_fitting(cali);
+    }
+    adc_oneshot_del_unit(adc);
+
+    if (err == ESP_OK) {
+        *out_mv = (uint32_t)(sum_mv / BATTERY_ADC_SAMPLES);
+    }
+    return err;
+}
+
+static battery_level_t battery_band_for(uint32_t mv, battery_level_t current)
+{
+    // Fresh band from the raw thresholds
+    battery_level_t level = BATTERY_NORMAL;
+    for (int l = BATTERY_SAVE; l < BATTERY_LEVEL_COUNT; l++) {
+        if (mv < s_band_mv[l]) {
+            level = (battery_level_t)l;
+        }
+    }
+
+    // Recovering: only climb out of a band once clear of its margin
+    while (level < current && mv < s_band_mv[level + 1] + BATTERY_HYSTERESIS_MV) {
+        level = (battery_level_t)(level + 1);
+    }
+    return level;
+}
+
+uint32_t battery_update(void)
+{
+    uint32_t pin_mv = 0;
+    esp_err_t err = battery_read_pin_mv(&pin_mv);
+    if (err != ESP_OK) {
+        ESP_LOGW(BATTERY_TAG, "ADC read failed (%s), keeping %lu mV",
+                 esp_err_to_name(err), (unsigned long)s_mv);
+        return s_mv;
+    }
+
+    // Garbage after a brown-out
+    if (s_level >= BATTERY_LEVEL_COUNT) {
+        s_level = BATTERY_NORMAL;
+    }
+
+    uint32_t mv = pin_mv * BATTERY_DIVIDER;
+    battery_level_t old = (battery_level_t)s_level;
+    battery_level_t level = mv < BATTERY_ABSENT_MV ? BATTERY_NORMAL
+                                                   : battery_band_for(mv, old);
+
+    s_mv = mv;
+    s_level = level;
+
+    if (level != old) {
+        ESP_LOGW(BATTERY_TAG, "Battery %lu mV: %s -> %s (interval x%lu, TX every %lu, %d dBm)",
+                 (unsigned long)mv, s_level_name[old], s_level_name[level],
+                 (unsigned long)s_policy[level].interval_mult,
+                 (unsigned long)s_policy[level].tx_every_n,
+                 s_policy[level].tx_power_dbm);
+    } else {
+        ESP_LOGI(BATTERY_TAG, "Battery %lu mV (%s)", (unsigned long)mv, s_level_name[level]);
+    }
+    return mv;
+}
+
+uint32_t battery_mv(void)
+{
+    return s_mv;
+}
+
+battery_level_t battery_level(void)
+{
+    return s_level < BATTERY_LEVEL_COUNT ? (battery_level_t)s_level : BATTERY_NORMAL;
+}
+
+const char *battery_level_name(battery_level_t level)
+{
+    return level < BATTERY_LEVEL_COUNT ? s_level_name[level] : "?";
+}
+
+const battery_policy_t *battery_policy(void)
+{
+    return &s_policy[battery_level()];
+}
@@ -0,0 +1,48 @@
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Battery monitor and reporting policy (TX node)
+// ================================================================
+
+// Charge bands, highest first. Each band has its own reporting policy.
+typedef enum {
+    BATTERY_NORMAL,
+    BATTERY_SAVE,
+    BATTERY_LOW,
+    BATTERY_CRITICAL,
+    BATTERY_LEVEL_COUNT
+} battery_level_t;
+
+typedef struct {
+    uint32_t interval_mult;   // stretch the time between samples by this factor
+    uint32_t tx_every_n;      // readings to collect before powering the radio
+    int      tx_power_dbm;    // LoRa output power for routine batches
+} battery_policy_t;
+
+// Measure the battery and update the band (with hysteresis, kept across
+// deep sleep). Call once per wake before the radio is used; the reading is
+// taken with the radio asleep so it isn't pulled down by TX current.
+// Returns the voltage in mV, or the last good reading if the ADC failed.
+uint32_t battery_update(void);
+
+// Last measured voltage (mV), 0 if never measured
+uint32_t battery_mv(void);
+
+battery_level_t battery_level(void);
+const char *battery_level_name(battery_level_t level);
+
+// Policy for the current band
+const battery_policy_t *battery_policy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_app_desc.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+
+#include "lora.h"
+#include "energy.h"
+
+static const char *TAG = "ENERGY";
+
+// ================================================================
+// Current table (µA per state). Datasheet ballparks for an ESP32 +
+// SX1276 (PA_BOOST, +17 dBm) + SSD1306; replace with bench measurements.
+// ================================================================
+#define ENERGY_UA_CPU_ACTIVE       40000
+#define ENERGY_UA_CPU_LIGHT_SLEEP  800
+#define ENERGY_UA_CPU_DEEP_SLEEP   10
+#define ENERGY_UA_RADIO_SLEEP      1
+#define ENERGY_UA_RADIO_STANDBY    1600
+#define ENERGY_UA_RADIO_TX         120000
+#define ENERGY_UA_RADIO_RX         11500
+#define ENERGY_UA_RADIO_CAD        11000
+#define ENERGY_UA_WIFI_OFF         0
+#define ENERGY_UA_WIFI_ON          80000
+#define ENERGY_UA_OLED_OFF         10
+#define ENERGY_UA_OLED_ON          10000
+
+// How often the TX node sends a TLM record
+#define ENERGY_TLM_PERIOD_S        3600
+
+static const uint32_t s_current_ua[ENERGY_STATE_COUNT] = {
+    [ENERGY_CPU_ACTIVE]      = ENERGY_UA_CPU_ACTIVE,
+    [ENERGY_CPU_LIGHT_SLEEP] = ENERGY_UA_CPU_LIGHT_SLEEP,
+    [ENERGY_CPU_DEEP_SLEEP]  = ENERGY_UA_CPU_DEEP_SLEEP,
+    [ENERGY_RADIO_SLEEP]     = ENERGY_UA_RADIO_SLEEP,
+    [ENERGY_RADIO_STANDBY]   = ENERGY_UA_RADIO_STANDBY,
+    [ENERGY_RADIO_TX]        = ENERGY_UA_RADIO_TX,
+    [ENERGY_RADIO_RX]        = ENERGY_UA_RADIO_RX,
+    [ENERGY_RADIO_CAD]       = ENERGY_UA_RADIO_CAD,
+    [ENERGY_WIFI_OFF]        = ENERGY_UA_WIFI_OFF,
+    [ENERGY_WIFI_ON]         = ENERGY_UA_WIFI_ON,
+    [ENERGY_OLED_OFF]        = ENERGY_UA_OLED_OFF,
+    [ENERGY_OLED_ON]         = ENERGY_UA_OLED_ON,
+};
+
+static const energy_subsys_t s_state_subsys[ENERGY_STATE_COUNT] = {
+    [ENERGY_CPU_ACTIVE]      = ENERGY_CPU,
+    [ENERGY_CPU_LIGHT_SLEEP] = ENERGY_CPU,
+    [ENERGY_CPU_DEEP_SLEEP]  = ENERGY_CPU,
+    [ENERGY_RADIO_SLEEP]     = ENERGY_RADIO,
+    [ENERGY_RADIO_STANDBY]   = ENERGY_RADIO,
+    [ENERGY_RADIO_TX]        = ENERGY_RADIO,
+    [ENERGY_RADIO_RX]        = ENERGY_RADIO,
+    [ENERGY_RADIO_CAD]       = ENERGY_RADIO,
+    [ENERGY_WIFI_OFF]        = ENERGY_WIFI,
+    [ENERGY_WIFI_ON]         = ENERGY_WIFI,
+    [ENERGY_OLED_OFF]        = ENERGY_OLED,
+    [ENERGY_OLED_ON]         = ENERGY_OLED,
+};
+
+// Totals since power-on, kept across deep sleep
+RTC_DATA_ATTR static uint64_t s_state_us[ENERGY_STATE_COUNT];
+RTC_DATA_ATTR static int64_t  s_sleep_start_us = 0;   // wall clock at deep sleep, 0 = none
+RTC_DATA_ATTR static int64_t  s_last_tlm_us = 0;      // wall clock of the last TLM record
+
+// This wake: current state and the esp_timer time it was last folded
+static energy_state_t s_cur[ENERGY_SUBSYS_COUNT] = {
+    ENERGY_CPU_ACTIVE, ENERGY_RADIO_SLEEP, ENERGY_WIFI_OFF, ENERGY_OLED_OFF
+};
+static int64_t s_since[ENERGY_SUBSYS_COUNT];
+
+// Light sleep reported by the PM exit callback, not yet folded
+static int64_t s_light_sleep_us = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Driver mode totals already folded in
+static lora_mode_times_t s_radio_seen;
+
+// Wall clock survives deep sleep (RTC timer), esp_timer does not
+static int64_t energy_wall_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+static esp_err_t IRAM_ATTR energy_light_sleep_exit(int64_t slept_us, void *arg)
+{
+    (void)arg;
+    portENTER_CRITICAL_SAFE(&s_lock);
+    s_light_sleep_us += slept_us;
+    portEXIT_CRITICAL_SAFE(&s_lock);
+    return ESP_OK;
+}
+#endif
+
+// Move everything since the last fold into s_state_us
+static void energy_fold(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    int64_t light = s_light_sleep_us;
+    s_light_sleep_us = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    // CPU: wall time minus what the PM callback says we slept
+    int64_t cpu = now - s_since[ENERGY_CPU];
+    if (light > cpu) {
+        light = cpu;
+    }
+    s_state_us[ENERGY_CPU_ACTIVE] += cpu - light;
+    s_state_us[ENERGY_CPU_LIGHT_SLEEP] += light;
+
+    // Radio: driver mode times; anything it didn't see (not initialised
+    // this wake) the radio spent asleep from the previous wake
+    lora_mode_times_t t;
+    lora_get_mode_times(&t);
+    uint64_t d_sleep = t.sleep_us - s_radio_seen.sleep_us;
+    uint64_t d_stby  = t.standby_us - s_radio_seen.standby_us;
+    uint64_t d_tx    = t.tx_us - s_radio_seen.tx_us;
+    uint64_t d_rx    = t.rx_us - s_radio_seen.rx_us;
+    uint64_t d_cad   = t.cad_us - s_radio_seen.cad_us;
+    uint64_t seen    = d_sleep + d_stby + d_tx + d_rx + d_cad;
+    uint64_t elapsed = (uint64_t)(now - s_since[ENERGY_RADIO]);
+    s_radio_seen = t;
+
+    s_state_us[ENERGY_RADIO_SLEEP]   += d_sleep + (elapsed > seen ? elapsed - seen : 0);
+    s_state_us[ENERGY_RADIO_STANDBY] += d_stby;
+    s_state_us[ENERGY_RADIO_TX]      += d_tx;
+    s_state_us[ENERGY_RADIO_RX]      += d_rx;
+    s_state_us[ENERGY_RADIO_CAD]     += d_cad;
+
+    // Wi-Fi / OLED: plain state machines
+    for (int sub = ENERGY_WIFI; sub < ENERGY_SUBSYS_COUNT; sub++) {
+        s_state_us[s_cur[sub]] += now - s_since[sub];
+    }
+
+    for (int sub = 0; sub < ENERGY_SUBSYS_COUNT; sub++) {
+        s_since[sub] = now;
+    }
+}
+
+void energy_init(void)
+{
+    // esp_timer starts near zero at boot, so s_since = 0 already covers
+    // the app start-up as CPU active time
+    if (s_sleep_start_us && esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED) {
+        // Bootloader time lands here too; it is small next to the sleep
+        int64_t span = energy_wall_us() - s_sleep_start_us - esp_timer_get_time();
+        if (span > 0) {
+            s_state_us[ENERGY_CPU_DEEP_SLEEP] += span;
+            s_state_us[ENERGY_RADIO_SLEEP]    += span;
+            s_state_us[ENERGY_WIFI_OFF]       += span;
+            s_state_us[ENERGY_OLED_OFF]       += span;
+        }
+    }
+    s_sleep_start_us = 0;
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {
+        .exit_cb = energy_light_sleep_exit,
+    };
+    if (esp_pm_light_sleep_register_cbs(&cbs) != ESP_OK) {
+        ESP_LOGW(TAG, "Light-sleep callback not registered, light sleep counts as active");
+    }
+#endif
+}
+
+void energy_set_state(energy_subsys_t sub, energy_state_t state)
+{
+    if (sub < ENERGY_WIFI || sub >= ENERGY_SUBSYS_COUNT ||
+        state >= ENERGY_STATE_COUNT || s_state_subsys[state] != sub) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    s_state_us[s_cur[sub]] += now - s_since[sub];
+    s_since[sub] = now;
+    s_cur[sub] = state;
+}
+
+void energy_before_deep_sleep(void)
+{
+    energy_fold();
+    energy_log_report();
+    s_sleep_start_us = energy_wall_us();
+}
+
+// µs * µA -> µAh
+static uint32_t energy_state_uah(energy_state_t state)
+{
+    return (uint32_t)(s_state_us[state] * s_current_ua[state] / 3600000000ULL);
+}
+
+uint32_t energy_subsys_uah(energy_subsys_t sub)
+{
+    uint32_t uah = 0;
+    for (int st = 0; st < ENERGY_STATE_COUNT; st++) {
+        if (s_state_subsys[st] == sub) {
+            uah += energy_state_uah((energy_state_t)st);
+        }
+    }
+    return uah;
+}
+
+void energy_log_report(void)
+{
+    uint64_t up_s = (s_state_us[ENERGY_CPU_ACTIVE] +
+                     s_state_us[ENERGY_CPU_LIGHT_SLEEP] +
+                     s_state_us[ENERGY_CPU_DEEP_SLEEP]) / 1000000;
+
+    ESP_LOGI(TAG, "Estimated since power-on (%llu s): cpu=%lu radio=%lu wifi=%lu oled=%lu uAh",
+             (unsigned long long)up_s,
+             (unsigned long)energy_subsys_uah(ENERGY_CPU),
+             (unsigned long)energy_subsys_uah(ENERGY_RADIO),
+             (unsigned long)energy_subsys_uah(ENERGY_WIFI),
+             (unsigned long)energy_subsys_uah(ENERGY_OLED));
+}
+
+bool energy_tlm_due(void)
+{
+    return s_last_tlm_us == 0 ||
+           energy_wall_us() - s_last_tlm_us >= (int64_t)ENERGY_TLM_PERIOD_S * 1000000;
+}
+
+int energy_format_tlm(char *buf, size_t size)
+{
+    energy_fold();
+
+    // First 8 hex digits of the ELF SHA-256 tell builds apart
+    char build[9];
+    esp_app_get_elf_sha256(build, sizeof(build));
+
+    uint64_t up_s = (s_state_us[ENERGY_CPU_ACTIVE] +
+                     s_state_us[ENERGY_CPU_LIGHT_SLEEP] +
+                     s_state_us[ENERGY_CPU_DEEP_SLEEP]) / 1000000;
+
+    // µAh per state: CPU active/light/deep, radio tx/rx/cad/standby/sleep
+    int n = snprintf(buf, size,
+                     "TLM,B=%s,UP=%lu,CPU=%lu/%lu/%lu,RAD=%lu/%lu/%lu/%lu/%lu,WIFI=%lu,OLED=%lu",
+                     build,
+                     (unsigned long)up_s,
+                     (unsigned long)energy_state_uah(ENERGY_CPU_ACTIVE),
+                     (unsigned long)energy_state_uah(ENERGY_CPU_LIGHT_SLEEP),
+                     (unsigned long)energy_state_uah(ENERGY_CPU_DEEP_SLEEP),
+                     (unsigned long)energy_state_uah(ENERGY_RADIO_TX),
+                     (unsigned long)energy_state_uah(ENERGY_RADIO_RX),
+                     (unsigned long)energy_state_uah(ENERGY_RADIO_CAD),
+                     (unsigned long)energy_state_uah(ENERGY_RADIO_STANDBY),
+                     (unsigned long)energy_state_uah(ENERGY_RADIO_SLEEP),
+                     (unsigned long)energy_subsys_uah(ENERGY_WIFI),
+                     (unsigned long)energy_subsys_uah(ENERGY_OLED));
+    if (n < 0) {
+        n = 0;
+    } else if ((size_t)n >= size) {
+        n = (int)size - 1;
+    }
+    return n;
+}
+
+void energy_tlm_sent(void)
+{
+    s_last_tlm_us = energy_wall_us();
+}
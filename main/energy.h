@@ -0,0 +1,66 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ================================================================
+// Per-state energy accounting
+// ================================================================
+
+typedef enum {
+    ENERGY_CPU,
+    ENERGY_RADIO,
+    ENERGY_WIFI,
+    ENERGY_OLED,
+    ENERGY_SUBSYS_COUNT
+} energy_subsys_t;
+
+typedef enum {
+    ENERGY_CPU_ACTIVE,
+    ENERGY_CPU_LIGHT_SLEEP,
+    ENERGY_CPU_DEEP_SLEEP,
+    ENERGY_RADIO_SLEEP,
+    ENERGY_RADIO_STANDBY,
+    ENERGY_RADIO_TX,
+    ENERGY_RADIO_RX,
+    ENERGY_RADIO_CAD,
+    ENERGY_WIFI_OFF,
+    ENERGY_WIFI_ON,
+    ENERGY_OLED_OFF,
+    ENERGY_OLED_ON,
+    ENERGY_STATE_COUNT
+} energy_state_t;
+
+// Call once at boot, right after check_wake_reason(): charges the
+// deep-sleep span that just ended and starts timing this wake.
+void energy_init(void);
+
+// Wi-Fi and OLED report their own transitions. CPU states come from the
+// PM light-sleep callback and deep sleep; radio states from the LoRa driver.
+void energy_set_state(energy_subsys_t sub, energy_state_t state);
+
+// Fold the current wake into the totals and stamp the start of deep sleep
+void energy_before_deep_sleep(void);
+
+// Estimated charge since power-on, in µAh
+uint32_t energy_subsys_uah(energy_subsys_t sub);
+
+void energy_log_report(void);
+
+// Telemetry record for the LoRa link ("TLM,B=<build>,UP=...,CPU=..."),
+// sent every ENERGY_TLM_PERIOD_S. Returns the length written.
+bool energy_tlm_due(void);
+int energy_format_tlm(char *buf, size_t size);
+void energy_tlm_sent(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,300 +8,86 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
 
-#include "driver/i2c_master.h"
 #include "driver/gpio.h"
 #include "driver/uart.h"
 
-#include "esp_lcd_panel_ops.h"
-#include "esp_lcd_panel_vendor.h"
-#include "esp_lcd_io_i2c.h"
-
+#include "display.h"
+#include "display_backend.h"
+#include "display_scenes.h"
 #include "power.h"
+#include "energy.h"
+#include "battery.h"
+#include "esp_pm.h"
 #include "esp_sleep.h"
 
 #include "rmds_lora.h"   // LoRa task interface
+#include "rmds_samples.h" // RTC sample ring (TX node)
 #include "rmds_wifi.h"   // WiFi/cloud interface (used on RX node)
+#include "rmds_uplink.h" // cloud uplink backends (used on RX node)
+#include "rmds_metrics.h" // gateway metrics endpoint (used on RX node)
+#include "rmds_status.h" // OLED status dashboard
 
 #define TAG        "RMDS_OLED"
 #define TAG_UART   "UART_RX"
 
-//  OLED + I2C configuration
-#define I2C_MASTER_SCL_IO      22
-#define I2C_MASTER_SDA_IO      21
-#define I2C_MASTER_PORT        I2C_NUM_0
-
-#define I2C_MASTER_CLK_SOURCE  I2C_CLK_SRC_DEFAULT
-#define I2C_MASTER_FREQ_HZ     400000
+// The panel flush runs below every other task
+#define OLED_FLUSH_TASK_PRIO   1
 
-// SSD1306 I2C address
-#define OLED_I2C_ADDR          0x3C
-#define OLED_WIDTH             128
-#define OLED_HEIGHT            64
-
-// Animation timing (ms)
+// Splash timing (ms), played once before the status dashboard
 #define STEP_DELAY_MS          300
 #define HOLD_FULL_COUNT        4
 #define HOLD_FULL_DELAY_MS     400
 
+// Duty cycle (TX node): one sample per timer wake, and the longest a wake
+// may last (plus waiting for a TDMA slot, if enabled)
+#define SLEEP_INTERVAL_S       10
+#define AWAKE_DEADLINE_MS      (5000 + RMDS_LORA_TDMA_WAIT_MAX_MS + RMDS_LORA_ARQ_WAIT_MAX_MS)
+
 //  UART configuration (UART1 on GPIO 14/25) TX node
 #define SENSOR_UART_NUM   UART_NUM_1
 #define SENSOR_TX_PIN     GPIO_NUM_14
 #define SENSOR_RX_PIN     GPIO_NUM_25
 #define SENSOR_BAUD_RATE  38400
 #define SENSOR_RX_BUF_SZ  2048
+#define SENSOR_WAKE_EDGES 3      // RX edges that wake the chip from light sleep
+#define SENSOR_FRAME_GAP_MS 50   // silence that ends a partial frame
 
-//  Global handles / framebuffer
-static i2c_master_bus_handle_t  i2c_bus_handle = NULL;
-static i2c_master_dev_handle_t  i2c_dev_handle = NULL;
-static esp_lcd_panel_io_handle_t io_handle    = NULL;
-static esp_lcd_panel_handle_t    panel_handle = NULL;
+// Readings that are sent straight away at full rate and power, whatever the
+// battery policy says: any sensor fault, or methane at 10% of its LEL
+#define SENSOR_ALARM_PPM  5000
 
-// 1-bpp framebuffer: 8 vertical pixels per byte
-static uint8_t frame_buffer[OLED_WIDTH * OLED_HEIGHT / 8];
+//  Global handles
+// Keeps the chip out of light sleep while a sensor frame is arriving
+static esp_pm_lock_handle_t      uart_pm_lock = NULL;
 
-//  Framebuffer helper implementations
-static inline void fb_clear(void)
-{
-    memset(frame_buffer, 0x00, sizeof(frame_buffer));
-}
+// Last reading was an alarm; kept across deep sleep so the next wake
+// comes at full rate too
+RTC_DATA_ATTR static bool alarm_active = false;
 
-static inline void fb_set_pixel(int x, int y, bool on)
-{
-    if (x < 0 || x >= OLED_WIDTH || y < 0 || y >= OLED_HEIGHT) {
-        return;
-    }
-
-    // Rotate 180: physical (WIDTH-1, HEIGHT-1)
-    int hw_x = (OLED_WIDTH  - 1) - x;
-    int hw_y = (OLED_HEIGHT - 1) - y;
+// Deep sleep after this wake: SLEEP_INTERVAL_S, stretched by the battery policy
+static uint32_t sleep_interval_s = SLEEP_INTERVAL_S;
 
-    int byte_index = (hw_y / 8) * OLED_WIDTH + hw_x;
-    uint8_t bit_mask = 1 << (hw_y & 7);
-
-    if (on) {
-        frame_buffer[byte_index] |= bit_mask;
-    } else {
-        frame_buffer[byte_index] &= ~bit_mask;
-    }
-}
-
-static void fb_fill_rect(int x0, int y0, int w, int h, bool on)
-{
-    for (int y = y0; y < y0 + h; y++) {
-        for (int x = x0; x < x0 + w; x++) {
-            fb_set_pixel(x, y, on);
-        }
-    }
-}
-
-// 1-pixel border around the whole screen
-static void fb_draw_border(void)
+//  OLED initialization: the panel on the shared I2C bus, through the
+//  backend picked in menuconfig
+static display_backend_t *init_oled(void)
 {
-    for (int x = 0; x < OLED_WIDTH; x++) {
-        fb_set_pixel(x, 0, true);
-        fb_set_pixel(x, OLED_HEIGHT - 1, true);
-    }
-    for (int y = 0; y < OLED_HEIGHT; y++) {
-        fb_set_pixel(0, y, true);
-        fb_set_pixel(OLED_WIDTH - 1, y, true);
-    }
+    display_backend_t *backend = NULL;
+    ESP_ERROR_CHECK(display_backend_default(&backend));
+    energy_set_state(ENERGY_OLED, ENERGY_OLED_ON);
+    return backend;
 }
 
-// Push framebuffer to the panel
-static void fb_flush_to_panel(void)
+// Render one frame into the back buffer and hand it to the flush task, then
+// sleep until delay_ms after the previous frame (drawing time included)
+static void oled_show(int letters, TickType_t *last_wake, uint32_t delay_ms)
 {
-    esp_lcd_panel_draw_bitmap(panel_handle,
-                              0, 0,
-                              OLED_WIDTH, OLED_HEIGHT,
-                              frame_buffer);
-}
-
-//  I2C & OLED initialization
-static void init_i2c_and_oled(void)
-{
-    // --- I2C bus config ---
-    i2c_master_bus_config_t bus_cfg = {
-        .i2c_port = I2C_MASTER_PORT,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .clk_source = I2C_MASTER_CLK_SOURCE,
-        .glitch_ignore_cnt = 7,
-        .flags = {
-            .enable_internal_pullup = true,
-        },
-    };
-    ESP_ERROR_CHECK(i2c_new_master_bus(&bus_cfg, &i2c_bus_handle));
-
-    // --- Attach SSD1306 as a device ---
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address  = OLED_I2C_ADDR,
-        .scl_speed_hz    = I2C_MASTER_FREQ_HZ,
-    };
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus_handle, &dev_cfg, &i2c_dev_handle));
-
-    // --- Create panel I/O over I2C ---
-    esp_lcd_panel_io_i2c_config_t io_cfg = {
-        .dev_addr            = OLED_I2C_ADDR,
-        .control_phase_bytes = 1,
-        .lcd_cmd_bits        = 8,
-        .lcd_param_bits      = 8,
-        .dc_bit_offset       = 6,
-        .scl_speed_hz        = I2C_MASTER_FREQ_HZ,
-    };
-    ESP_ERROR_CHECK(esp_lcd_new_panel_io_i2c(i2c_bus_handle, &io_cfg, &io_handle));
-
-    // --- Create SSD1306 panel (no color_space in v6.1) ---
-    esp_lcd_panel_dev_config_t panel_cfg = {
-        .reset_gpio_num = -1,
-        .bits_per_pixel = 1,
-    };
-    ESP_ERROR_CHECK(esp_lcd_new_panel_ssd1306(io_handle, &panel_cfg, &panel_handle));
-    ESP_ERROR_CHECK(esp_lcd_panel_reset(panel_handle));
-    ESP_ERROR_CHECK(esp_lcd_panel_init(panel_handle));
-
-    // No mirroring: draw exactly as we put it in the framebuffer
-    ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel_handle, false, false));
-
-    ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
-}
-
-// Block-style R
-static void draw_letter_R(int x0, int y0, int w, int h)
-{
-    int stroke = w / 4;
-    if (stroke < 2) stroke = 2;
-
-    int right = x0 + w - 1;
-    int mid_y = y0 + h / 2;
-
-    // Left vertical bar
-    fb_fill_rect(x0, y0, stroke, h, true);
-
-    // Top horizontal bar
-    fb_fill_rect(x0, y0, w - stroke, stroke, true);
-
-    // Middle bar
-    fb_fill_rect(x0, mid_y - stroke / 2, w - stroke, stroke, true);
-
-    // Right vertical of the upper loop
-    fb_fill_rect(right - stroke + 1, y0 + stroke,
-                 stroke, mid_y - y0 - stroke, true);
-
-    // Diagonal leg
-    for (int i = 0; i < h / 2; i++) {
-        int y = mid_y + i;
-        int x = x0 + stroke + (w - 2 * stroke) * i / (h / 2);
-        fb_fill_rect(x, y, stroke, 2, true);
-    }
-}
-
-// Block-style M
-static void draw_letter_M(int x0, int y0, int w, int h)
-{
-    int stroke = w / 5;
-    if (stroke < 2) stroke = 2;
-
-    int right = x0 + w - 1;
-    int mid_x = x0 + w / 2;
-
-    // Two vertical bars
-    fb_fill_rect(x0, y0, stroke, h, true);
-    fb_fill_rect(right - stroke + 1, y0, stroke, h, true);
-
-    // Diagonals to the center
-    for (int i = 0; i < h / 2; i++) {
-        int y = y0 + i;
-        int x_left  = x0 + stroke + (mid_x - x0 - stroke) * i / (h / 2);
-        int x_right = right - stroke - (right - stroke - mid_x) * i / (h / 2);
-
-        fb_fill_rect(x_left,  y, stroke, 1, true);
-        fb_fill_rect(x_right, y, stroke, 1, true);
-    }
-}
-
-// Block-style D
-static void draw_letter_D(int x0, int y0, int w, int h)
-{
-    int stroke = w / 4;
-    if (stroke < 2) stroke = 2;
-
-    int right  = x0 + w - 1;
-    int bottom = y0 + h - 1;
-
-    // Left vertical bar
-    fb_fill_rect(x0, y0, stroke, h, true);
-    // Top bar
-    fb_fill_rect(x0, y0, w - stroke, stroke, true);
-    // Bottom bar
-    fb_fill_rect(x0, bottom - stroke + 1, w - stroke, stroke, true);
-    // Right vertical bar
-    fb_fill_rect(right - stroke + 1, y0 + stroke,
-                 stroke, h - 2 * stroke, true);
-}
-
-// Block-style S
-static void draw_letter_S(int x0, int y0, int w, int h)
-{
-    int stroke = w / 4;
-    if (stroke < 2) stroke = 2;
-
-    int right  = x0 + w - 1;
-    int bottom = y0 + h - 1;
-    int mid_y  = y0 + h / 2;
-
-    // Top bar
-    fb_fill_rect(x0 + stroke / 2, y0, w - stroke, stroke, true);
-    // Upper left vertical
-    fb_fill_rect(x0, y0, stroke, mid_y - y0, true);
-
-    // Middle bar
-    fb_fill_rect(x0 + stroke / 2, mid_y - stroke / 2,
-                 w - stroke, stroke, true);
-
-    // Lower right vertical
-    fb_fill_rect(right - stroke + 1, mid_y,
-                 stroke, bottom - mid_y + 1, true);
-    // Bottom bar
-    fb_fill_rect(x0 + stroke / 2, bottom - stroke + 1,
-                 w - stroke, stroke, true);
-}
-
-static void draw_rmds_partial(int letters_to_show)
-{
-    fb_clear();
-    fb_draw_border();
-
-    int total_w  = 100;
-    int base_x   = (OLED_WIDTH - total_w) / 2;
-    int base_y   = 10;
-    int letter_w = 22;
-    int letter_h = 40;
-    int gap      = 3;
-
-    int x = base_x;
-
-    if (letters_to_show >= 1) {
-        draw_letter_R(x, base_y, letter_w, letter_h);
-    }
-    x += letter_w + gap;
-
-    if (letters_to_show >= 2) {
-        draw_letter_M(x, base_y, letter_w, letter_h);
-    }
-    x += letter_w + gap;
-
-    if (letters_to_show >= 3) {
-        draw_letter_D(x, base_y, letter_w, letter_h);
-    }
-    x += letter_w + gap;
-
-    if (letters_to_show >= 4) {
-        draw_letter_S(x, base_y, letter_w, letter_h);
-    }
+    display_scene_rmds(display_begin_frame(), letters);
+    display_submit();
+    vTaskDelayUntil(last_wake, pdMS_TO_TICKS(delay_ms));
 }
 
 static void rmds_oled_task(void *pvParameters)
@@ -309,29 +95,23 @@ static void rmds_oled_task(void *pvParameters)
     (void)pvParameters;
 
     ESP_LOGI(TAG, "RMDS OLED task started");
+    ESP_ERROR_CHECK(display_start(init_oled(), OLED_FLUSH_TASK_PRIO));
 
-    while (1) {
-        // Step through R -> RM -> RMD -> RMDS
-        for (int letters = 1; letters <= 4; ++letters) {
-            draw_rmds_partial(letters);
-            fb_flush_to_panel();
-            vTaskDelay(pdMS_TO_TICKS(STEP_DELAY_MS));
-        }
+    TickType_t last_wake = xTaskGetTickCount();
 
-        // Hold / flash "RMDS" a few times
-        for (int i = 0; i < HOLD_FULL_COUNT; ++i) {
-            // Full RMDS ON
-            draw_rmds_partial(4);
-            fb_flush_to_panel();
-            vTaskDelay(pdMS_TO_TICKS(HOLD_FULL_DELAY_MS));
-
-            // Blink-off effect
-            fb_clear();
-            fb_draw_border();
-            fb_flush_to_panel();
-            vTaskDelay(pdMS_TO_TICKS(HOLD_FULL_DELAY_MS));
-        }
+    // Step through R -> RM -> RMD -> RMDS
+    for (int letters = 1; letters <= 4; ++letters) {
+        oled_show(letters, &last_wake, STEP_DELAY_MS);
     }
+
+    // Hold / flash "RMDS" a few times: full RMDS, then blink off
+    for (int i = 0; i < HOLD_FULL_COUNT; ++i) {
+        oled_show(4, &last_wake, HOLD_FULL_DELAY_MS);
+        oled_show(0, &last_wake, HOLD_FULL_DELAY_MS);
+    }
+
+    // Live readings, link and uplink state from here on
+    rmds_status_run();
 }
 
 //  typedef struct to hold UART frame
@@ -394,28 +174,42 @@ static void dump_frame(const sensor_frame_t *f)
              f->crc_inv);
 }
 
-static void build_lora_payload_from_frame(const sensor_frame_t *f, char *out, size_t out_sz)
+static bool frame_is_alarm(const sensor_frame_t *f)
 {
-    if (!out || out_sz == 0) return;
+    return f->faults != 0 || f->conc_ppm >= SENSOR_ALARM_PPM;
+}
 
-    float temp_K = f->temp_raw / 10.0f;
+// Sampling interval, batch size and TX power for the rest of this wake:
+// from the battery policy, or full rate while an alarm is active
+static void apply_report_policy(void)
+{
+    const battery_policy_t *policy = battery_policy();
 
-    int n = snprintf(out, out_sz,
-                     "Concentration=%" PRIu32 "ppm, "
-                     "Faults=%" PRIu32 ", "
-                     "Sensor Temp=%.1fK, "
-                     "CRC=%08" PRIx32 ", "
-                     "CRC_1C=%08" PRIx32,
-                     f->conc_ppm,
-                     f->faults,
-                     temp_K,
-                     f->crc,
-                     f->crc_inv);
-
-    if (n < 0 || (size_t)n >= out_sz) {
-        ESP_LOGW(TAG_UART, "LoRa payload truncated (size=%zu)", out_sz);
+    if (alarm_active) {
+        sleep_interval_s = SLEEP_INTERVAL_S;
+        rmds_samples_set_tx_every(1);
+        rmds_lora_set_tx_power(RMDS_LORA_TX_POWER_MAX);
+    } else {
+        sleep_interval_s = SLEEP_INTERVAL_S * policy->interval_mult;
+        rmds_samples_set_tx_every(policy->tx_every_n);
+        rmds_lora_set_tx_power(policy->tx_power_dbm);
+    }
+}
+
+// Light sleep stops the UART, so hold the PM lock from the first byte of a
+// frame until it has been handled
+static void uart_frame_lock(bool hold)
+{
+    if (uart_pm_lock == NULL) {
+        return;
+    }
+    if (hold) {
+        esp_pm_lock_acquire(uart_pm_lock);
+    } else {
+        esp_pm_lock_release(uart_pm_lock);
     }
 }
+
 //  UART RX FreeRTOS task (TX node)
 static void uart_rx_task(void *pvParameters)
 {
@@ -429,18 +223,34 @@ static void uart_rx_task(void *pvParameters)
 
     uint32_t fields[7];
     int field_count = 0;
+    bool in_frame = false;
 
     while (1) {
+        // Between frames wait for a single byte so the lock is taken as soon
+        // as one starts; inside a frame read in bulk, and a quiet gap means
+        // the rest of it was lost
         int len = uart_read_bytes(SENSOR_UART_NUM, rx_buf,
-                                  sizeof(rx_buf),
-                                  pdMS_TO_TICKS(1000));
+                                  in_frame ? sizeof(rx_buf) : 1,
+                                  pdMS_TO_TICKS(in_frame ? SENSOR_FRAME_GAP_MS : 1000));
         if (len <= 0) {
+            if (in_frame) {
+                ESP_LOGW(TAG_UART, "Frame gap after %d fields, resyncing", field_count);
+                field_count = 0;
+                line_len = 0;
+                in_frame = false;
+                uart_frame_lock(false);
+            }
             continue;
         }
 
         for (int i = 0; i < len; ++i) {
             char c = (char)rx_buf[i];
 
+            if (!in_frame) {
+                in_frame = true;
+                uart_frame_lock(true);
+            }
+
             if (c == '\r') {
                 continue;  // ignore CR, handle LF only
             }
@@ -469,10 +279,25 @@ static void uart_rx_task(void *pvParameters)
                         if (frame_is_valid(&f)) {
                             dump_frame(&f);
 
-                            char payload[RMDS_LORA_PAYLOAD_MAX_LEN];
-                            build_lora_payload_from_frame(&f, payload, sizeof(payload));
-                            rmds_lora_set_payload(payload);
-                            ESP_LOGI(TAG_UART, "Updated LoRa payload: %s", payload);
+                            bool alarm = frame_is_alarm(&f);
+                            if (alarm != alarm_active) {
+                                ESP_LOGW(TAG_UART, "Alarm %s", alarm ? "raised" : "cleared");
+                                alarm_active = alarm;
+                                apply_report_policy();
+                            }
+
+                            // Keep the reading in RTC memory; only wake the
+                            // radio once a full batch is waiting (alarms: now)
+                            rmds_samples_append(f.conc_ppm, f.faults, f.temp_raw);
+                            rmds_status_reading(f.conc_ppm, f.faults, f.temp_raw);
+                            if (rmds_samples_tx_due()) {
+                                // Take the TX hold before dropping ours so we can't sleep in between
+                                power_hold_acquire(POWER_HOLD_LORA_TX);
+                                rmds_lora_send_samples();
+                            }
+
+                            // Got what this wake was waiting for
+                            power_hold_release(POWER_HOLD_UART_FRAME);
                         } else {
                             ESP_LOGW(TAG_UART,
                                      "Invalid frame: start=0x%08" PRIx32
@@ -481,6 +306,8 @@ static void uart_rx_task(void *pvParameters)
                         }
 
                         field_count = 0;
+                        in_frame = false;
+                        uart_frame_lock(false);
                     }
                 }
 
@@ -508,7 +335,7 @@ static void init_uart_sensor(void)
         .parity    = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_2,     // 2 stop bits
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
+        .source_clk = UART_SCLK_REF_TICK,  // APB moves with DFS, REF_TICK stays at 1 MHz
     };
 
     ESP_ERROR_CHECK(uart_param_config(SENSOR_UART_NUM, &uart_config));
@@ -524,6 +351,18 @@ static void init_uart_sensor(void)
                                         NULL,
                                         0));
 
+    // Wake from light sleep on RX activity. The characters spent on the wake
+    // edges are not received; they land in the start line, which
+    // frame_is_valid() does not check, so the frame itself survives.
+    ESP_ERROR_CHECK(uart_set_wakeup_threshold(SENSOR_UART_NUM, SENSOR_WAKE_EDGES));
+    ESP_ERROR_CHECK(esp_sleep_enable_uart_wakeup(SENSOR_UART_NUM));
+
+    // Hand every byte to the task right away so it can take the PM lock
+    ESP_ERROR_CHECK(uart_set_rx_full_threshold(SENSOR_UART_NUM, 1));
+    if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "sensor_uart", &uart_pm_lock) != ESP_OK) {
+        uart_pm_lock = NULL;   // PM disabled: nothing to hold
+    }
+
     ESP_LOGI(TAG_UART,
              "UART%d configured: baud=%d, 8N2, TX=%d, RX=%d",
              SENSOR_UART_NUM,
@@ -535,8 +374,16 @@ static void init_uart_sensor(void)
 void app_main(void)
 {
     check_wake_reason();
+    energy_init();
     
-    //USE FOR TX NODE
+    // Stretch the schedule as the battery runs down (radio still asleep)
+    battery_update();
+    apply_report_policy();
+
+    // Stay awake until one sensor frame has been read (and sent, if a batch is due)
+    power_coordinator_init();
+    power_hold_acquire(POWER_HOLD_UART_FRAME);
+
     init_uart_sensor();
     xTaskCreate(uart_rx_task,
                 "uart_rx_task",
@@ -545,15 +392,20 @@ void app_main(void)
                 5,
                 NULL);
 
-    ESP_LOGI("APP", "Starting TX-only node firmware");
-    rmds_lora_start_tx_only();
+    // The radio is only started on wakes where a batch is due (see uart_rx_task)
+    ESP_LOGI("APP", "Starting TX-only node firmware, %u samples pending",
+             (unsigned int)rmds_samples_pending());
 
-    enter_modem_sleep();
-    enter_deep_sleep(10); 
+    enter_auto_light_sleep();
+    power_sleep_when_idle(sleep_interval_s, AWAKE_DEADLINE_MS);
 
     // USE FOR RX NODE
     //
     // rmds_wifi_init();          // connect to Wi-Fi, only uncomment this line if master node
+    // enter_auto_light_sleep();  // DFS + light sleep between packets and uploads
+    // rmds_uplink_start();       // cloud uplink (HTTP or MQTT backend, see rmds_uplink.c)
+    // rmds_metrics_start_server(); // Prometheus metrics on :9100/metrics
+    // xTaskCreate(rmds_oled_task, "rmds_oled", 4096, NULL, 2, NULL); // splash, then the status dashboard
     // ESP_LOGI("APP", "Starting RX-only node firmware");
     // rmds_lora_start_rx_only(); // LoRa RX + cloud forwarding is in rmds_lora.c
 }
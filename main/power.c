@@ -1,13 +1,39 @@
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+#include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_sleep.h"
 #include "esp_pm.h"
 
+#include "energy.h"
+#include "power.h"
+
 static const char *TAG = "POWER";
 
 // Save data across sleep
 RTC_DATA_ATTR uint32_t boot_count = 0;
 
+// Awake-time accounting across sleep cycles
+RTC_DATA_ATTR static uint64_t awake_us_total = 0;
+RTC_DATA_ATTR static uint32_t useful_tx_total = 0;
+
+// Bits are SET while a hold is released, so "all idle" is a plain wait
+static EventGroupHandle_t hold_group = NULL;
+static uint32_t useful_tx_this_wake = 0;
+
+// Auto light sleep: DFS range and how often to print time spent per PM state
+#define POWER_PM_MIN_MHZ       40
+#define POWER_PM_MAX_MHZ       160
+#define POWER_PM_REPORT_S      3600
+
+static esp_timer_handle_t pm_report_timer = NULL;
+static bool auto_light_sleep = false;
+
 // Your LoRa pins
 #define LORA_DIO0_PIN  GPIO_NUM_26  // Wake pin (must be RTC-capable)
 
@@ -34,16 +60,19 @@ void enter_modem_sleep(void)
 // ================================================================
 // 2. DEEP SLEEP - Everything off (~10 µA)
 // ================================================================
+
 void enter_deep_sleep(uint64_t seconds)
 {
     boot_count++;
-    
+
+    energy_before_deep_sleep();
+
     // Wake on timer
     esp_sleep_enable_timer_wakeup(seconds * 1000000);
-    
+
     // Wake on LoRa interrupt (DIO0)
     esp_sleep_enable_ext0_wakeup(LORA_DIO0_PIN, 1);
-    
+
     ESP_LOGI(TAG, "Deep sleep: ~10 µA for %llu seconds", seconds);
     esp_deep_sleep_start();
 }
@@ -58,11 +87,118 @@ void enter_hibernation(uint64_t seconds)
     
     // Power down everything except RTC memory
     esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_OFF);
+
+    energy_before_deep_sleep();
     
     ESP_LOGI(TAG, "Hibernation: 10 µA for %llu seconds", seconds);
     esp_deep_sleep_start();
 }
 
+// ================================================================
+// 3b. AUTO LIGHT SLEEP - DFS between bursts, light sleep when idle
+// ================================================================
+
+// Time in each PM state since boot (needs CONFIG_PM_PROFILING); the
+// percentages are the average-current proxy
+static void power_pm_report(void *arg)
+{
+    (void)arg;
+    ESP_LOGI(TAG, "PM state times after %llu s:",
+             (unsigned long long)(esp_timer_get_time() / 1000000));
+    esp_pm_dump_locks(stdout);
+}
+
+void enter_auto_light_sleep(void)
+{
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = POWER_PM_MAX_MHZ,
+        .min_freq_mhz = POWER_PM_MIN_MHZ,
+        .light_sleep_enable = true
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Auto light sleep not available: %s", esp_err_to_name(err));
+        return;
+    }
+    auto_light_sleep = true;
+
+    if (pm_report_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = power_pm_report,
+            .name = "pm_report",
+        };
+        if (esp_timer_create(&args, &pm_report_timer) == ESP_OK) {
+            esp_timer_start_periodic(pm_report_timer, (uint64_t)POWER_PM_REPORT_S * 1000000);
+        }
+    }
+
+    ESP_LOGI(TAG, "Auto light sleep: %d-%d MHz, tickless idle",
+             POWER_PM_MIN_MHZ, POWER_PM_MAX_MHZ);
+}
+
+// ================================================================
+// 4. SLEEP COORDINATOR - sleep only once pending work drains
+// ================================================================
+void power_coordinator_init(void)
+{
+    if (hold_group == NULL) {
+        hold_group = xEventGroupCreate();
+        xEventGroupSetBits(hold_group, POWER_HOLD_ALL);
+    }
+}
+
+void power_hold_acquire(uint32_t holds)
+{
+    if (hold_group) {
+        xEventGroupClearBits(hold_group, holds & POWER_HOLD_ALL);
+    }
+}
+
+void power_hold_release(uint32_t holds)
+{
+    if (hold_group) {
+        xEventGroupSetBits(hold_group, holds & POWER_HOLD_ALL);
+    }
+}
+
+void power_note_useful_tx(void)
+{
+    useful_tx_this_wake++;
+}
+
+void power_sleep_when_idle(uint64_t seconds, uint32_t deadline_ms)
+{
+    power_coordinator_init();
+
+    EventBits_t bits = xEventGroupWaitBits(hold_group,
+                                           POWER_HOLD_ALL,
+                                           pdFALSE,
+                                           pdTRUE,      // wait for every hold
+                                           pdMS_TO_TICKS(deadline_ms));
+
+    uint32_t pending = POWER_HOLD_ALL & ~bits;
+    if (pending) {
+        ESP_LOGW(TAG, "Awake deadline (%lu ms) hit, holds still taken: 0x%02lx",
+                 (unsigned long)deadline_ms, (unsigned long)pending);
+    }
+
+    // Time since the app started; boot ROM/bootloader time is not included
+    uint64_t awake_us = (uint64_t)esp_timer_get_time();
+    awake_us_total += awake_us;
+    useful_tx_total += useful_tx_this_wake;
+
+    ESP_LOGI(TAG, "Awake %llu ms this wake (%lu useful TX), %llu ms per useful TX overall",
+             (unsigned long long)(awake_us / 1000),
+             (unsigned long)useful_tx_this_wake,
+             (unsigned long long)(useful_tx_total ? awake_us_total / useful_tx_total / 1000 : 0));
+
+    if (auto_light_sleep) {
+        power_pm_report(NULL);
+    }
+
+    enter_deep_sleep(seconds);
+}
+
 // ================================================================
 // Check why we woke up
 // ================================================================
@@ -78,6 +214,8 @@ void check_wake_reason(void)
         default:
             ESP_LOGI(TAG, "Wake: Power on");
             boot_count = 0;
+            awake_us_total = 0;
+            useful_tx_total = 0;
             break;
     }
 }
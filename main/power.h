@@ -9,12 +9,41 @@ extern "C" {
 
 void enter_modem_sleep(void);
 
+// DFS (40-160 MHz) plus automatic light sleep whenever no PM lock is held.
+// Drivers/tasks keep the chip up with esp_pm_lock handles while busy.
+void enter_auto_light_sleep(void);
+
 void enter_deep_sleep(uint64_t seconds);
 
 void enter_hibernation(uint64_t seconds);
 
 void check_wake_reason(void);
 
+// ================================================================
+// Sleep coordinator
+// ================================================================
+
+// Busy holds. While any hold is taken the node stays awake.
+typedef enum {
+    POWER_HOLD_UART_FRAME = (1 << 0),   // waiting for a sensor frame
+    POWER_HOLD_LORA_TX    = (1 << 1),   // packet pending or in flight
+    POWER_HOLD_UPLINK     = (1 << 2),   // cloud upload pending
+} power_hold_t;
+
+#define POWER_HOLD_ALL (POWER_HOLD_UART_FRAME | POWER_HOLD_LORA_TX | POWER_HOLD_UPLINK)
+
+void power_coordinator_init(void);
+
+// Holds can be combined with |. No-ops before power_coordinator_init().
+void power_hold_acquire(uint32_t holds);
+void power_hold_release(uint32_t holds);
+
+// Count a transmission that carried fresh data (for awake-time stats)
+void power_note_useful_tx(void);
+
+// Block until every hold is released or deadline_ms passes, then deep sleep
+void power_sleep_when_idle(uint64_t seconds, uint32_t deadline_ms);
+
 #ifdef __cplusplus
 }
 #endif
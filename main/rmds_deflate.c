@@ -0,0 +1,280 @@
+// rmds_deflate.c
+//
+// Minimal gzip encoder for upload bodies. Greedy LZ77 over a small window
+// with hash chains, emitted as one fixed-Huffman deflate block. Batches of
+// JSON documents repeat the same keys and names over and over, which is
+// exactly what a 1 KB window catches; dynamic Huffman tables are not worth
+// the RAM here.
+
+#include <string.h>
+
+#include "esp_rom_crc.h"
+
+#include "rmds_deflate.h"
+
+#define MIN_MATCH   3
+#define MAX_MATCH   258
+#define NIL         0xFFFF
+#define HASH_SIZE   (1 << RMDS_DEFLATE_HBITS)
+#define WMASK       (RMDS_DEFLATE_WSIZE - 1)
+
+static const uint16_t len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* -------- Bit output -------- */
+
+static void z_flush_out(rmds_deflate_t *z)
+{
+    if (z->err || z->out_len == 0) {
+        return;
+    }
+    if (z->sink(z->ctx, z->out, z->out_len) != 0) {
+        z->err = 1;
+    }
+    z->out_total += z->out_len;
+    z->out_len = 0;
+}
+
+static void z_put_byte(rmds_deflate_t *z, uint8_t b)
+{
+    if (z->out_len == sizeof(z->out)) {
+        z_flush_out(z);
+    }
+    z->out[z->out_len++] = b;
+}
+
+// Deflate packs bits LSB first
+static void z_put_bits(rmds_deflate_t *z, uint32_t value, int count)
+{
+    z->bitbuf |= value << z->bitcnt;
+    z->bitcnt += count;
+    while (z->bitcnt >= 8) {
+        z_put_byte(z, (uint8_t)z->bitbuf);
+        z->bitbuf >>= 8;
+        z->bitcnt -= 8;
+    }
+}
+
+// Huffman codes are defined MSB first, so reverse before packing
+static void z_put_code(rmds_deflate_t *z, uint32_t code, int len)
+{
+    uint32_t rev = 0;
+    for (int i = 0; i < len; ++i) {
+        rev = (rev << 1) | (code & 1);
+        code >>= 1;
+    }
+    z_put_bits(z, rev, len);
+}
+
+static void z_put_litlen(rmds_deflate_t *z, int sym)
+{
+    if (sym < 144) {
+        z_put_code(z, 0x30 + sym, 8);
+    } else if (sym < 256) {
+        z_put_code(z, 0x190 + (sym - 144), 9);
+    } else if (sym < 280) {
+        z_put_code(z, sym - 256, 7);
+    } else {
+        z_put_code(z, 0xC0 + (sym - 280), 8);
+    }
+}
+
+static void z_put_match(rmds_deflate_t *z, int len, int dist)
+{
+    int lc = 28;
+    while (len_base[lc] > len) {
+        lc--;
+    }
+    z_put_litlen(z, 257 + lc);
+    z_put_bits(z, len - len_base[lc], len_extra[lc]);
+
+    int dc = 29;
+    while (dist_base[dc] > dist) {
+        dc--;
+    }
+    z_put_code(z, dc, 5);
+    z_put_bits(z, dist - dist_base[dc], dist_extra[dc]);
+}
+
+/* -------- LZ77 -------- */
+
+static inline uint32_t z_hash(const uint8_t *p)
+{
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - RMDS_DEFLATE_HBITS);
+}
+
+static void z_insert(rmds_deflate_t *z, size_t p)
+{
+    uint32_t h = z_hash(&z->win[p]);
+    z->prev[p & WMASK] = z->head[h];
+    z->head[h] = (uint16_t)p;
+}
+
+static int z_longest_match(rmds_deflate_t *z, size_t pos, int *dist_out)
+{
+    size_t avail = z->fill - pos;
+    int max_len = avail < MAX_MATCH ? (int)avail : MAX_MATCH;
+    if (max_len < MIN_MATCH) {
+        return 0;
+    }
+
+    int best = 0;
+    uint16_t cand = z->head[z_hash(&z->win[pos])];
+
+    for (int chain = 0; cand != NIL && chain < RMDS_DEFLATE_MAX_CHAIN; ++chain) {
+        if (cand >= pos || pos - cand > RMDS_DEFLATE_WSIZE) {
+            break;
+        }
+        const uint8_t *a = &z->win[pos];
+        const uint8_t *b = &z->win[cand];
+        if (b[best] == a[best] && b[0] == a[0]) {
+            int n = 0;
+            while (n < max_len && a[n] == b[n]) {
+                n++;
+            }
+            if (n > best) {
+                best = n;
+                *dist_out = (int)(pos - cand);
+                if (n == max_len) {
+                    break;
+                }
+            }
+        }
+        cand = z->prev[cand & WMASK];
+    }
+    return best >= MIN_MATCH ? best : 0;
+}
+
+// Encode up to 'limit' (exclusive); matches may run past it up to fill
+static void z_compress_until(rmds_deflate_t *z, size_t limit)
+{
+    while (z->pos < limit) {
+        int dist = 0;
+        int len = z_longest_match(z, z->pos, &dist);
+
+        if (len) {
+            z_put_match(z, len, dist);
+            for (int i = 0; i < len; ++i, ++z->pos) {
+                if (z->pos + MIN_MATCH <= z->fill) {
+                    z_insert(z, z->pos);
+                }
+            }
+        } else {
+            z_put_litlen(z, z->win[z->pos]);
+            if (z->pos + MIN_MATCH <= z->fill) {
+                z_insert(z, z->pos);
+            }
+            z->pos++;
+        }
+    }
+}
+
+// Drop the oldest window half and rebase hash positions
+static void z_slide(rmds_deflate_t *z)
+{
+    memmove(z->win, &z->win[RMDS_DEFLATE_WSIZE], z->fill - RMDS_DEFLATE_WSIZE);
+    z->fill -= RMDS_DEFLATE_WSIZE;
+    z->pos  -= RMDS_DEFLATE_WSIZE;
+
+    for (int i = 0; i < HASH_SIZE; ++i) {
+        z->head[i] = (z->head[i] != NIL && z->head[i] >= RMDS_DEFLATE_WSIZE)
+                         ? (uint16_t)(z->head[i] - RMDS_DEFLATE_WSIZE) : NIL;
+    }
+    for (int i = 0; i < RMDS_DEFLATE_WSIZE; ++i) {
+        z->prev[i] = (z->prev[i] != NIL && z->prev[i] >= RMDS_DEFLATE_WSIZE)
+                         ? (uint16_t)(z->prev[i] - RMDS_DEFLATE_WSIZE) : NIL;
+    }
+}
+
+/* -------- Public API -------- */
+
+void rmds_deflate_begin(rmds_deflate_t *z, rmds_deflate_sink_t sink, void *ctx)
+{
+    static const uint8_t gzip_header[10] = {
+        0x1F, 0x8B, 0x08, 0x00,     // magic, deflate, no flags
+        0x00, 0x00, 0x00, 0x00,     // no mtime
+        0x00, 0xFF                  // no extra flags, unknown OS
+    };
+
+    z->sink = sink;
+    z->ctx = ctx;
+    z->fill = 0;
+    z->pos = 0;
+    z->bitbuf = 0;
+    z->bitcnt = 0;
+    z->out_len = 0;
+    z->crc = 0;
+    z->in_total = 0;
+    z->out_total = 0;
+    z->err = 0;
+    memset(z->head, 0xFF, sizeof(z->head));
+    memset(z->prev, 0xFF, sizeof(z->prev));
+
+    for (size_t i = 0; i < sizeof(gzip_header); ++i) {
+        z_put_byte(z, gzip_header[i]);
+    }
+
+    // Single final block with fixed Huffman codes: BFINAL=1, BTYPE=01
+    z_put_bits(z, 1, 1);
+    z_put_bits(z, 1, 2);
+}
+
+int rmds_deflate_write(rmds_deflate_t *z, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    z->crc = esp_rom_crc32_le(z->crc, p, len);
+    z->in_total += len;
+
+    while (len > 0 && !z->err) {
+        size_t room = sizeof(z->win) - z->fill;
+        size_t take = len < room ? len : room;
+        memcpy(&z->win[z->fill], p, take);
+        z->fill += take;
+        p += take;
+        len -= take;
+
+        if (z->fill == sizeof(z->win)) {
+            // Keep MAX_MATCH of lookahead so matches are not cut short
+            z_compress_until(z, z->fill - MAX_MATCH);
+            z_slide(z);
+        }
+    }
+    return z->err ? -1 : 0;
+}
+
+int rmds_deflate_finish(rmds_deflate_t *z)
+{
+    z_compress_until(z, z->fill);
+    z_put_litlen(z, 256);   // end of block
+
+    if (z->bitcnt > 0) {
+        z_put_bits(z, 0, 8 - z->bitcnt);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        z_put_byte(z, (uint8_t)(z->crc >> (8 * i)));
+    }
+    for (int i = 0; i < 4; ++i) {
+        z_put_byte(z, (uint8_t)(z->in_total >> (8 * i)));
+    }
+    z_flush_out(z);
+
+    return z->err ? -1 : 0;
+}
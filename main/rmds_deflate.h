@@ -0,0 +1,68 @@
+// rmds_deflate.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Memory budget: history window + lookahead, hash heads and chains.
+// With the defaults the whole state is ~5.3 KB and never grows.
+#define RMDS_DEFLATE_WBITS      10                          // 1 KB history
+#define RMDS_DEFLATE_WSIZE      (1 << RMDS_DEFLATE_WBITS)
+#define RMDS_DEFLATE_HBITS      9
+#define RMDS_DEFLATE_MAX_CHAIN  16                          // match effort
+#define RMDS_DEFLATE_OUT_LEN    128
+
+/**
+ * Compressed output callback. Returns 0 on success, non-zero to abort.
+ */
+typedef int (*rmds_deflate_sink_t)(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * Streaming gzip compressor (LZ77 + fixed Huffman codes) with a fixed
+ * memory footprint. Keep it static or in a task's context, it is too big
+ * for most stacks.
+ */
+typedef struct {
+    rmds_deflate_sink_t sink;
+    void     *ctx;
+
+    uint8_t  win[2 * RMDS_DEFLATE_WSIZE];        // history + lookahead
+    uint16_t head[1 << RMDS_DEFLATE_HBITS];
+    uint16_t prev[RMDS_DEFLATE_WSIZE];
+    size_t   fill;                               // bytes in win
+    size_t   pos;                                // next byte to encode
+
+    uint32_t bitbuf;
+    int      bitcnt;
+    uint8_t  out[RMDS_DEFLATE_OUT_LEN];
+    size_t   out_len;
+
+    uint32_t crc;
+    uint32_t in_total;
+    uint32_t out_total;
+    int      err;
+} rmds_deflate_t;
+
+/**
+ * Start a new gzip member. Writes the gzip header to the sink.
+ */
+void rmds_deflate_begin(rmds_deflate_t *z, rmds_deflate_sink_t sink, void *ctx);
+
+/**
+ * Feed uncompressed bytes. Returns 0 on success.
+ */
+int rmds_deflate_write(rmds_deflate_t *z, const void *data, size_t len);
+
+/**
+ * Compress what is left, emit the gzip trailer and flush.
+ * Returns 0 if the whole stream reached the sink.
+ */
+int rmds_deflate_finish(rmds_deflate_t *z);
+
+#ifdef __cplusplus
+}
+#endif
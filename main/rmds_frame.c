@@ -0,0 +1,141 @@
+// rmds_frame.c
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rmds_frame.h"
+
+// Find "key" in text and return a pointer just past it, or NULL
+static const char *frame_field(const char *text, const char *key)
+{
+    const char *p = strstr(text, key);
+    return p ? p + strlen(key) : NULL;
+}
+
+static bool frame_u32(const char *text, const char *key, int base, uint32_t *out)
+{
+    const char *p = frame_field(text, key);
+    if (!p) {
+        return false;
+    }
+    char *end = NULL;
+    unsigned long v = strtoul(p, &end, base);
+    if (end == p) {
+        return false;
+    }
+    *out = (uint32_t)v;
+    return true;
+}
+
+bool rmds_frame_parse(const char *text, rmds_reading_t *out)
+{
+    if (!text || !out) {
+        return false;
+    }
+
+    uint32_t node = 0;
+    frame_u32(text, "NODE=", 16, &node);   // optional
+    out->node = node;
+    out->age_s = 0;
+    out->battery_mv = 0;
+
+    if (!frame_u32(text, "SEQ=", 10, &out->seq) ||
+        !frame_u32(text, "Concentration=", 10, &out->ppm) ||
+        !frame_u32(text, "Faults=", 10, &out->faults)) {
+        return false;
+    }
+
+    // Temperature is sent as "Sensor Temp=298.1K"; keep it as K*10
+    const char *t = frame_field(text, "Sensor Temp=");
+    if (!t) {
+        return false;
+    }
+    char *end = NULL;
+    unsigned long whole = strtoul(t, &end, 10);
+    if (end == t) {
+        return false;
+    }
+    uint32_t tenths = 0;
+    if (*end == '.' && end[1] >= '0' && end[1] <= '9') {
+        tenths = (uint32_t)(end[1] - '0');
+    }
+    out->temp_dK = (uint32_t)whole * 10 + tenths;
+
+    return true;
+}
+
+bool rmds_frame_header(const char *text, uint32_t *node, uint32_t *seq)
+{
+    if (!text || !node || !seq) {
+        return false;
+    }
+    *node = 0;
+    frame_u32(text, "NODE=", 16, node);   // optional
+    return frame_u32(text, "SEQ=", 10, seq);
+}
+
+// Read one "a:b:c:d" entry; *pp is left on the ';' or NUL after it
+static bool frame_batch_entry(const char **pp, uint32_t v[4])
+{
+    const char *p = *pp;
+    for (int i = 0; i < 4; i++) {
+        char *end = NULL;
+        unsigned long x = strtoul(p, &end, 10);
+        if (end == p) {
+            return false;
+        }
+        v[i] = (uint32_t)x;
+        p = end;
+        if (i < 3) {
+            if (*p != ':') {
+                return false;
+            }
+            p++;
+        }
+    }
+    *pp = p;
+    return true;
+}
+
+size_t rmds_frame_parse_batch(const char *text, rmds_reading_t *out, size_t max)
+{
+    if (!text || !out || max == 0) {
+        return 0;
+    }
+
+    const char *p = frame_field(text, ",R=");
+    if (!p) {
+        // Single-reading frame from older node firmware
+        return rmds_frame_parse(text, &out[0]) ? 1 : 0;
+    }
+
+    uint32_t node = 0, first = 0, battery_mv = 0;
+    frame_u32(text, "NODE=", 16, &node);   // optional
+    frame_u32(text, "BAT=", 10, &battery_mv);   // optional
+    if (!frame_u32(text, "S0=", 10, &first)) {
+        return 0;
+    }
+
+    size_t n = 0;
+    while (n < max && *p) {
+        uint32_t v[4];
+        if (!frame_batch_entry(&p, v)) {
+            break;
+        }
+        out[n].node    = node;
+        out[n].seq     = first + (uint32_t)n;
+        out[n].ppm     = v[0];
+        out[n].faults  = v[1];
+        out[n].temp_dK = v[2];
+        out[n].age_s   = v[3];
+        out[n].battery_mv = battery_mv;
+        n++;
+
+        if (*p != ';') {
+            break;
+        }
+        p++;
+    }
+
+    return n;
+}
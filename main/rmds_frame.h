@@ -0,0 +1,54 @@
+// rmds_frame.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Most readings a single batched LoRa packet can carry
+#define RMDS_FRAME_BATCH_MAX 16
+
+/**
+ * One methane reading as seen by the gateway, with typed fields so the
+ * cloud side can index and query them directly.
+ */
+typedef struct {
+    uint32_t node;       // sensor node ID (0 if the frame carries none)
+    uint32_t seq;        // LoRa sequence number
+    uint32_t ppm;        // concentration
+    uint32_t faults;     // sensor fault bits
+    uint32_t temp_dK;    // sensor temperature, Kelvin * 10
+    uint32_t age_s;      // seconds the node held the reading before sending it
+    uint32_t battery_mv; // node battery voltage when sent (0 if not reported)
+    int      rssi;       // packet RSSI at the gateway (dBm)
+    float    snr;        // packet SNR at the gateway (dB)
+    int64_t  gw_time_ms; // gateway receive time
+} rmds_reading_t;
+
+/**
+ * Parse a LoRa text frame ("SEQ=N,Concentration=...ppm, Faults=..., Sensor Temp=...K, ...")
+ * into a reading. Radio metadata (rssi/snr/gw_time_ms) is left untouched.
+ * Returns false if the mandatory fields are missing.
+ */
+bool rmds_frame_parse(const char *text, rmds_reading_t *out);
+
+/**
+ * Sender and packet sequence number of any frame ("SEQ=N[,NODE=hex],...").
+ * *node is 0 if the frame carries no ID. Returns false without SEQ.
+ */
+bool rmds_frame_header(const char *text, uint32_t *node, uint32_t *seq);
+
+/**
+ * Parse a batched frame ("SEQ=N,S0=first[,BAT=mV],R=ppm:faults:temp_dK:age_s;...")
+ * into up to max readings numbered first, first+1, ... Frames without "R="
+ * are handed to rmds_frame_parse(). Returns the number of readings decoded.
+ */
+size_t rmds_frame_parse_batch(const char *text, rmds_reading_t *out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
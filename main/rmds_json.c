@@ -0,0 +1,242 @@
+// rmds_json.c
+//
+// Small streaming JSON writer used for cloud uploads. No heap, no
+// intermediate document buffer: bytes go to the sink as they are produced.
+
+#include <string.h>
+
+#include "rmds_json.h"
+
+static void json_flush(rmds_json_writer_t *w)
+{
+    if (w->err || w->len == 0) {
+        return;
+    }
+    if (w->sink(w->ctx, w->buf, w->len) != 0) {
+        w->err = 1;
+    }
+    w->len = 0;
+}
+
+static void json_putc(rmds_json_writer_t *w, char c)
+{
+    if (w->len == sizeof(w->buf)) {
+        json_flush(w);
+    }
+    w->buf[w->len++] = c;
+    w->total++;
+}
+
+static void json_write(rmds_json_writer_t *w, const char *s, size_t n)
+{
+    while (n > 0) {
+        if (w->len == sizeof(w->buf)) {
+            json_flush(w);
+        }
+        size_t room = sizeof(w->buf) - w->len;
+        size_t take = n < room ? n : room;
+        memcpy(&w->buf[w->len], s, take);
+        w->len   += take;
+        w->total += take;
+        s += take;
+        n -= take;
+    }
+}
+
+// Emit a separator if this is not the first item at the current level
+static void json_separator(rmds_json_writer_t *w)
+{
+    uint32_t bit = 1u << w->depth;
+    if (w->need_comma & bit) {
+        json_putc(w, ',');
+    }
+    w->need_comma |= bit;
+}
+
+// Values that follow a key must not get their own separator
+static void json_value_prefix(rmds_json_writer_t *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    json_separator(w);
+}
+
+static void json_utoa(rmds_json_writer_t *w, uint64_t v)
+{
+    char tmp[20];
+    int i = sizeof(tmp);
+    do {
+        tmp[--i] = (char)('0' + (v % 10));
+        v /= 10;
+    } while (v != 0);
+    json_write(w, &tmp[i], sizeof(tmp) - i);
+}
+
+void rmds_json_init(rmds_json_writer_t *w, rmds_json_sink_t sink, void *ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->sink = sink;
+    w->ctx  = ctx;
+}
+
+static void json_open(rmds_json_writer_t *w, char c)
+{
+    json_value_prefix(w);
+    json_putc(w, c);
+    if (w->depth + 1 >= RMDS_JSON_MAX_DEPTH) {
+        w->err = 1;
+        return;
+    }
+    w->depth++;
+    w->need_comma &= ~(1u << w->depth);
+}
+
+static void json_close(rmds_json_writer_t *w, char c)
+{
+    if (w->depth == 0) {
+        w->err = 1;
+        return;
+    }
+    w->depth--;
+    json_putc(w, c);
+}
+
+void rmds_json_begin_object(rmds_json_writer_t *w) { json_open(w, '{'); }
+void rmds_json_end_object(rmds_json_writer_t *w)   { json_close(w, '}'); }
+void rmds_json_begin_array(rmds_json_writer_t *w)  { json_open(w, '['); }
+void rmds_json_end_array(rmds_json_writer_t *w)    { json_close(w, ']'); }
+
+static void json_escaped(rmds_json_writer_t *w, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    json_putc(w, '"');
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        switch (c) {
+        case '"':  json_write(w, "\\\"", 2); break;
+        case '\\': json_write(w, "\\\\", 2); break;
+        case '\n': json_write(w, "\\n", 2);  break;
+        case '\r': json_write(w, "\\r", 2);  break;
+        case '\t': json_write(w, "\\t", 2);  break;
+        default:
+            if (c < 0x20) {
+                char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F] };
+                json_write(w, esc, sizeof(esc));
+            } else {
+                json_putc(w, (char)c);
+            }
+            break;
+        }
+    }
+    json_putc(w, '"');
+}
+
+void rmds_json_key(rmds_json_writer_t *w, const char *key)
+{
+    json_separator(w);
+    json_escaped(w, key);
+    json_putc(w, ':');
+    w->after_key = true;
+}
+
+void rmds_json_string(rmds_json_writer_t *w, const char *s)
+{
+    json_value_prefix(w);
+    json_escaped(w, s ? s : "");
+}
+
+void rmds_json_uint(rmds_json_writer_t *w, uint32_t v)
+{
+    json_value_prefix(w);
+    json_utoa(w, v);
+}
+
+void rmds_json_uint64(rmds_json_writer_t *w, uint64_t v)
+{
+    json_value_prefix(w);
+    json_utoa(w, v);
+}
+
+void rmds_json_int(rmds_json_writer_t *w, int32_t v)
+{
+    json_value_prefix(w);
+    if (v < 0) {
+        json_putc(w, '-');
+        json_utoa(w, (uint64_t)(-(int64_t)v));
+    } else {
+        json_utoa(w, (uint64_t)v);
+    }
+}
+
+void rmds_json_bool(rmds_json_writer_t *w, bool v)
+{
+    json_value_prefix(w);
+    if (v) {
+        json_write(w, "true", 4);
+    } else {
+        json_write(w, "false", 5);
+    }
+}
+
+void rmds_json_fixed(rmds_json_writer_t *w, int32_t value, int decimals)
+{
+    json_value_prefix(w);
+
+    uint64_t mag = value < 0 ? (uint64_t)(-(int64_t)value) : (uint64_t)value;
+    if (value < 0) {
+        json_putc(w, '-');
+    }
+
+    uint64_t scale = 1;
+    for (int i = 0; i < decimals; ++i) {
+        scale *= 10;
+    }
+
+    json_utoa(w, mag / scale);
+    if (decimals > 0) {
+        uint64_t frac = mag % scale;
+        json_putc(w, '.');
+        for (uint64_t d = scale / 10; d > 0; d /= 10) {
+            json_putc(w, (char)('0' + (frac / d) % 10));
+        }
+    }
+}
+
+void rmds_json_kv_string(rmds_json_writer_t *w, const char *key, const char *s)
+{
+    rmds_json_key(w, key);
+    rmds_json_string(w, s);
+}
+
+void rmds_json_kv_uint(rmds_json_writer_t *w, const char *key, uint32_t v)
+{
+    rmds_json_key(w, key);
+    rmds_json_uint(w, v);
+}
+
+void rmds_json_kv_int(rmds_json_writer_t *w, const char *key, int32_t v)
+{
+    rmds_json_key(w, key);
+    rmds_json_int(w, v);
+}
+
+void rmds_json_kv_uint64(rmds_json_writer_t *w, const char *key, uint64_t v)
+{
+    rmds_json_key(w, key);
+    rmds_json_uint64(w, v);
+}
+
+void rmds_json_kv_fixed(rmds_json_writer_t *w, const char *key, int32_t value, int decimals)
+{
+    rmds_json_key(w, key);
+    rmds_json_fixed(w, value, decimals);
+}
+
+int rmds_json_finish(rmds_json_writer_t *w)
+{
+    json_flush(w);
+    return (w->err || w->depth != 0) ? -1 : 0;
+}
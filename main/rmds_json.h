@@ -0,0 +1,80 @@
+// rmds_json.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bytes buffered before the sink is called. One sink call per full buffer.
+#define RMDS_JSON_BUF_LEN   192
+
+// Max object/array nesting
+#define RMDS_JSON_MAX_DEPTH 8
+
+/**
+ * Output callback. Returns 0 on success, non-zero to abort the document.
+ */
+typedef int (*rmds_json_sink_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * Allocation-free streaming JSON writer. Lives on the caller's stack;
+ * output is pushed to the sink in RMDS_JSON_BUF_LEN pieces.
+ */
+typedef struct {
+    rmds_json_sink_t sink;
+    void    *ctx;
+    char     buf[RMDS_JSON_BUF_LEN];
+    size_t   len;
+    size_t   total;        // bytes emitted so far (including buffered)
+    uint32_t need_comma;   // one bit per nesting level
+    int      depth;
+    bool     after_key;
+    int      err;
+} rmds_json_writer_t;
+
+void rmds_json_init(rmds_json_writer_t *w, rmds_json_sink_t sink, void *ctx);
+
+void rmds_json_begin_object(rmds_json_writer_t *w);
+void rmds_json_end_object(rmds_json_writer_t *w);
+void rmds_json_begin_array(rmds_json_writer_t *w);
+void rmds_json_end_array(rmds_json_writer_t *w);
+
+/**
+ * Start a member inside an object. Follow with exactly one value
+ * (or a nested begin_object / begin_array).
+ */
+void rmds_json_key(rmds_json_writer_t *w, const char *key);
+
+// Values. Strings are escaped.
+void rmds_json_string(rmds_json_writer_t *w, const char *s);
+void rmds_json_uint(rmds_json_writer_t *w, uint32_t v);
+void rmds_json_int(rmds_json_writer_t *w, int32_t v);
+void rmds_json_uint64(rmds_json_writer_t *w, uint64_t v);
+void rmds_json_bool(rmds_json_writer_t *w, bool v);
+
+/**
+ * Fixed-point number: value / 10^decimals, e.g. (2981, 1) -> 298.1.
+ * Avoids pulling float formatting into the hot path.
+ */
+void rmds_json_fixed(rmds_json_writer_t *w, int32_t value, int decimals);
+
+// Key + value shorthands
+void rmds_json_kv_string(rmds_json_writer_t *w, const char *key, const char *s);
+void rmds_json_kv_uint(rmds_json_writer_t *w, const char *key, uint32_t v);
+void rmds_json_kv_int(rmds_json_writer_t *w, const char *key, int32_t v);
+void rmds_json_kv_uint64(rmds_json_writer_t *w, const char *key, uint64_t v);
+void rmds_json_kv_fixed(rmds_json_writer_t *w, const char *key, int32_t value, int decimals);
+
+/**
+ * Flush whatever is buffered to the sink.
+ * Returns 0 if the whole document went out, non-zero otherwise.
+ */
+int rmds_json_finish(rmds_json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,15 +1,35 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <sys/time.h>
+#include <time.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_pm.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "nvs_flash.h"
 
+#include "battery.h"
+#include "energy.h"
 #include "lora.h"
+#include "power.h"
+#include "rmds_arq.h"
+#include "rmds_fec.h"
+#include "rmds_frame.h"
 #include "rmds_lora.h"
+#include "rmds_metrics.h"
+#include "rmds_nodes.h"
+#include "rmds_samples.h"
+#include "rmds_status.h"
+#include "rmds_uplink.h"
 
 //  LoRa configuration
 #define LORA_TAG               "RMDS_LORA"
@@ -18,22 +38,207 @@
 #define RMDS_LORA_BW_HZ        125000L      // 125 kHz bandwidth
 #define RMDS_LORA_SF           7            // spreading factor
 #define RMDS_LORA_CR           5            // coding rate 4/5
-#define RMDS_LORA_PREAMBLE_LEN 8
 #define RMDS_LORA_SYNC_WORD    0x34
 
-// Transmission interval: 400 ms
-#define RMDS_LORA_TX_PERIOD_MS 400
+// Low-power listening: the receiver sleeps and runs CAD once per period,
+// so senders stretch the preamble to span a whole period. Both ends must
+// be built with the same setting.
+#define RMDS_LORA_LPL              0
+#define RMDS_LORA_CAD_PERIOD_MS    100
+#define RMDS_LORA_CAD_RX_WINDOW_MS 600   // long preamble + largest packet
+#define RMDS_LORA_SYMBOL_US        ((1000000L << RMDS_LORA_SF) / RMDS_LORA_BW_HZ)
+
+#if RMDS_LORA_LPL
+#define RMDS_LORA_PREAMBLE_LEN (RMDS_LORA_CAD_PERIOD_MS * 1000L / RMDS_LORA_SYMBOL_US + 8)
+#else
+#define RMDS_LORA_PREAMBLE_LEN 8
+#endif
+
+#if RMDS_LORA_TDMA && RMDS_LORA_LPL
+#error "TDMA needs the RX node listening all the time, turn RMDS_LORA_LPL off"
+#endif
+
+#if RMDS_LORA_TDMA && RMDS_LORA_ARQ
+#error "TDMA slots leave no room for ACKs, turn RMDS_LORA_ARQ off"
+#endif
+
+#if RMDS_LORA_TDMA && RMDS_LORA_FEC
+#error "TDMA slots leave no room for repair packets, turn RMDS_LORA_FEC off"
+#endif
+
+// TDMA (RMDS_LORA_TDMA in rmds_lora.h). The TX node opens its receiver
+// this long before the predicted beacon, plus the RTC clock's drift since
+// the last one; past half a superframe it just listens for a whole one.
+#define RMDS_LORA_TDMA_GUARD_MS      30
+#define RMDS_LORA_TDMA_DRIFT_PPM     500
+#define RMDS_LORA_TDMA_LISTEN_MS     (RMDS_TDMA_BEACON_SLOT_MS + \
+                                      rmds_tdma_period_ms(RMDS_TDMA_MAX_SLOTS, RMDS_TDMA_SLOT_MS))
+// RX node frees the slot of a TX node it hasn't heard from for this long.
+// Longer than a battery-saving node's batch interval; one that is slower
+// still just joins again.
+#define RMDS_LORA_TDMA_EXPIRE_MS     (30 * 60 * 1000)
+
+// ARQ (RMDS_LORA_ARQ in rmds_lora.h). The TX node listens this long for
+// the ACK after each frame: one RX poll on the gateway plus the ACK on air,
+// whose preamble is stretched like any other under LPL. Resends due within
+// the linger time are waited for, later ones go out on the next wake.
+#define RMDS_LORA_ARQ_ACK_WAIT_MS  (250 + (RMDS_LORA_PREAMBLE_LEN - 8) * RMDS_LORA_SYMBOL_US / 1000)
+#define RMDS_LORA_ARQ_LINGER_MS    2000
+
+// Sensor node ID: a 24-bit one provisioned in NVS wins over the MAC
+#define RMDS_LORA_NODE_NVS_NS      "rmds"
+#define RMDS_LORA_NODE_NVS_KEY     "node_id"
+#define RMDS_LORA_NODE_ID_MAX      0xFFFFFF
+
+// RX node forgets a sensor it hasn't heard from for this long
+#define RMDS_LORA_NODE_EXPIRE_MS   (24LL * 60 * 60 * 1000)
+
+// Print radio mode times this often on the always-on RX node
+#define RMDS_LORA_MODE_LOG_S   60
+
+// Packet sequence counter (increments for each LoRa packet sent).
+// Lives in RTC memory so it keeps counting across deep sleep.
+RTC_DATA_ATTR static uint32_t g_lora_seq = 0;
+
+// Radio-on time and readings delivered, also kept across deep sleep
+RTC_DATA_ATTR static uint64_t g_radio_us_total = 0;
+RTC_DATA_ATTR static uint32_t g_readings_sent_total = 0;
+
+#if RMDS_LORA_TDMA
+// Start of the last beacon heard on the RTC wall clock, and its period,
+// to predict the next one after deep sleep (period 0: nothing to go by)
+RTC_DATA_ATTR static int64_t  g_tdma_beacon_wall_ms = 0;
+RTC_DATA_ATTR static uint32_t g_tdma_period_ms = 0;
+
+// Join attempts without getting a slot, and batches still to sit out
+RTC_DATA_ATTR static uint32_t g_tdma_join_failures = 0;
+RTC_DATA_ATTR static uint32_t g_tdma_join_skip = 0;
+#endif
+
+#if RMDS_LORA_ARQ
+// Frames sent but not yet acknowledged. Zeroed on a cold boot, which is an
+// empty buffer (rmds_arq_init).
+RTC_DATA_ATTR static rmds_arq_tx_t g_arq;
+#endif
+
+#if RMDS_LORA_FEC
+// Repair sums of the group being sent, which spans several wakes. Zeroed on
+// a cold boot (k == 0): set up on first use.
+RTC_DATA_ATTR static rmds_fec_tx_t g_fec_tx;
+#endif
+
+// This node's ID, looked up once per cold boot (0: not yet)
+RTC_DATA_ATTR static uint32_t g_node_id = 0;
+
+static TaskHandle_t g_lora_tx_task = NULL;
+
+// RX node: link state per sensor, allocated when the RX task starts
+static rmds_nodes_t *g_nodes = NULL;
+
+#if RMDS_LORA_TDMA
+// RX node: slot owners, and the beacons that announce them
+static rmds_tdma_sched_t g_tdma_sched;
+#endif
+
+#if RMDS_LORA_FEC
+// RX node: recent frames and repair packets, to rebuild lost frames from
+static rmds_fec_rx_t *g_fec_rx = NULL;
+#endif
+
+// Set by the UART task (battery policy, or full power for alarms)
+static volatile int g_tx_power_dbm = RMDS_LORA_TX_POWER_MAX;
+
+// Held across each burst of radio register traffic. Without it every SPI
+// transaction raises and drops the APB clock on its own under DFS.
+static esp_pm_lock_handle_t g_lora_pm_lock = NULL;
+
+static void rmds_lora_pm_lock(bool hold)
+{
+    if (g_lora_pm_lock == NULL) {
+        return;
+    }
+    if (hold) {
+        esp_pm_lock_acquire(g_lora_pm_lock);
+    } else {
+        esp_pm_lock_release(g_lora_pm_lock);
+    }
+}
+
+static void rmds_lora_log_mode_times(const char *tag)
+{
+    lora_mode_times_t t;
+    lora_get_mode_times(&t);
+    ESP_LOGI(tag,
+             "Radio mode ms: sleep=%llu standby=%llu tx=%llu rx=%llu cad=%llu (restores=%lu)",
+             (unsigned long long)(t.sleep_us / 1000),
+             (unsigned long long)(t.standby_us / 1000),
+             (unsigned long long)(t.tx_us / 1000),
+             (unsigned long long)(t.rx_us / 1000),
+             (unsigned long long)(t.cad_us / 1000),
+             (unsigned long)t.restores);
+
+    // Listen before talk (CONFIG_LORA_LBT); nothing to say without sends
+    lora_lbt_stats_t lbt;
+    lora_get_lbt_stats(&lbt);
+    if (lbt.packets) {
+        ESP_LOGI(tag,
+                 "LBT: %lu packets, %lu clear at once, busy %lu rssi / %lu cad, "
+                 "%lu forced, avg wait %llu ms",
+                 (unsigned long)lbt.packets,
+                 (unsigned long)lbt.clear_first,
+                 (unsigned long)lbt.busy_rssi,
+                 (unsigned long)lbt.busy_cad,
+                 (unsigned long)lbt.forced,
+                 (unsigned long long)(lbt.wait_us / 1000 / lbt.packets));
+    }
+}
 
-// Shared payload buffer (set by UART RX task, used by TX task)
-static char g_lora_payload[RMDS_LORA_PAYLOAD_MAX_LEN];
-static SemaphoreHandle_t g_lora_payload_mutex = NULL;
+// Sensor node ID sent as NODE=<hex>: the one provisioned in NVS
+// (u32 "node_id" in namespace "rmds") or the low three bytes of the
+// factory MAC in efuse
+static uint32_t rmds_lora_node_id(void)
+{
+    if (g_node_id != 0) {
+        return g_node_id;
+    }
 
-// Packet sequence counter (increments for each LoRa packet sent)
-static uint32_t g_lora_seq = 0;
+    uint32_t id = 0;
+    nvs_handle_t nvs;
+    if (nvs_flash_init() == ESP_OK &&
+        nvs_open(RMDS_LORA_NODE_NVS_NS, NVS_READONLY, &nvs) == ESP_OK) {
+        if (nvs_get_u32(nvs, RMDS_LORA_NODE_NVS_KEY, &id) != ESP_OK) {
+            id = 0;
+        } else if (id == 0 || id > RMDS_LORA_NODE_ID_MAX) {
+            ESP_LOGW(LORA_TAG, "NVS node_id %lx out of range, using the MAC", (unsigned long)id);
+            id = 0;
+        }
+        nvs_close(nvs);
+    }
+
+    const char *source = "NVS";
+    if (id == 0) {
+        uint8_t mac[6] = { 0 };
+        esp_efuse_mac_get_default(mac);
+        id = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+        source = "MAC";
+    }
+    if (id == 0) {
+        id = 1;   // 0 means "no ID" to the gateway
+    }
+
+    ESP_LOGI(LORA_TAG, "Node ID %06lx (%s)", (unsigned long)id, source);
+    g_node_id = id;
+    return id;
+}
 
 //  Common init helper
 static bool rmds_lora_common_init(const char *tag)
 {
+    if (g_lora_pm_lock == NULL &&
+        esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "lora_spi", &g_lora_pm_lock) != ESP_OK) {
+        g_lora_pm_lock = NULL;   // PM disabled: nothing to hold
+    }
+
     ESP_LOGI(tag, "LoRa init: calling lora_init()");
     if (!lora_init()) {
         ESP_LOGE(tag, "lora_init() failed");
@@ -57,6 +262,288 @@ static bool rmds_lora_common_init(const char *tag)
     return true;
 }
 
+// Format as many samples as fit into one packet:
+// "SEQ=<packet>,NODE=<id>,S0=<first sample>,BAT=<mV>,R=ppm:faults:temp_dK:age_s;..."
+// Returns the packet length; *used is how many samples went in.
+static int rmds_lora_build_batch(char *buf, size_t size,
+                                 const rmds_sample_t *samples, size_t n,
+                                 uint32_t first_seq, size_t *used)
+{
+    uint32_t now = (uint32_t)time(NULL);
+    int len = snprintf(buf, size, "SEQ=%lu,NODE=%06lx,S0=%lu,BAT=%lu,R=",
+                       (unsigned long)g_lora_seq,
+                       (unsigned long)rmds_lora_node_id(),
+                       (unsigned long)first_seq,
+                       (unsigned long)battery_mv());
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        const rmds_sample_t *s = &samples[i];
+        uint32_t age = now >= s->time_s ? now - s->time_s : 0;
+        int w = snprintf(buf + len, size - len, "%s%lu:%u:%u:%lu",
+                         i ? ";" : "",
+                         (unsigned long)s->ppm,
+                         (unsigned int)s->faults,
+                         (unsigned int)s->temp_dK,
+                         (unsigned long)age);
+        if (w < 0 || w >= (int)(size - len)) {
+            buf[len] = '\0';   // doesn't fit, leave it for the next packet
+            break;
+        }
+        len += w;
+    }
+
+    *used = i;
+    return len;
+}
+
+#if RMDS_LORA_TDMA || RMDS_LORA_ARQ
+// RTC wall clock, which keeps running through deep sleep
+static int64_t rmds_lora_wall_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+#endif
+
+#if RMDS_LORA_TDMA
+static uint32_t rmds_lora_airtime_us(int len)
+{
+    return rmds_tdma_airtime_us(len, RMDS_LORA_SF, RMDS_LORA_BW_HZ, RMDS_LORA_CR,
+                                RMDS_LORA_PREAMBLE_LEN);
+}
+
+// Sleep until the esp_timer time t_us, rounded up to the next tick
+static void rmds_lora_sleep_until(int64_t t_us)
+{
+    int64_t wait_us = t_us - esp_timer_get_time();
+    if (wait_us > 0) {
+        const int64_t tick_us = portTICK_PERIOD_MS * 1000LL;
+        vTaskDelay((TickType_t)((wait_us + tick_us - 1) / tick_us));
+    }
+}
+
+// Listen until a beacon arrives or until_us. On success the radio is put
+// back to sleep and *start_us is when the beacon began on air.
+static bool rmds_lora_tdma_listen(int64_t until_us, rmds_tdma_beacon_t *b, int64_t *start_us)
+{
+    char buf[RMDS_LORA_PACKET_MAX_LEN + 1];
+
+    lora_receive();
+    while (esp_timer_get_time() < until_us) {
+        int len = lora_receive_packet((uint8_t *)buf, sizeof(buf) - 1);
+        if (len > 0) {
+            int64_t now = esp_timer_get_time();
+            buf[len] = '\0';
+            if (rmds_tdma_beacon_parse(buf, b)) {
+                lora_sleep();
+                *start_us = now - rmds_lora_airtime_us(len);
+                return true;
+            }
+            lora_receive();   // another node's packet, keep listening
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    lora_sleep();
+    return false;
+}
+
+// Next beacon: in a short window where the last one predicts it, else by
+// listening for up to a whole superframe
+static bool rmds_lora_tdma_hear_beacon(const char *tag, rmds_tdma_beacon_t *b, int64_t *start_us)
+{
+    if (g_tdma_period_ms) {
+        int64_t elapsed = rmds_lora_wall_ms() - g_tdma_beacon_wall_ms;
+        int64_t guard = RMDS_LORA_TDMA_GUARD_MS + elapsed * RMDS_LORA_TDMA_DRIFT_PPM / 1000000;
+
+        if (elapsed >= 0 && guard < g_tdma_period_ms / 2) {
+            int64_t due_us = esp_timer_get_time() +
+                             (g_tdma_period_ms - elapsed % g_tdma_period_ms) * 1000LL;
+            rmds_lora_sleep_until(due_us - guard * 1000);
+            if (rmds_lora_tdma_listen(due_us + (guard + RMDS_TDMA_BEACON_SLOT_MS) * 1000LL,
+                                      b, start_us)) {
+                return true;
+            }
+            ESP_LOGW(tag, "TDMA: beacon not where expected (guard %lld ms)", (long long)guard);
+        }
+    }
+    return rmds_lora_tdma_listen(esp_timer_get_time() + RMDS_LORA_TDMA_LISTEN_MS * 1000LL,
+                                 b, start_us);
+}
+
+/**
+ * Wait for this node's slot. Returns the esp_timer time the slot ends, 0
+ * if no beacon was heard (the batch goes out unscheduled), or -1 if the
+ * node is backing off from the join slot and should send nothing now.
+ */
+static int64_t rmds_lora_tdma_wait_slot(const char *tag)
+{
+    rmds_tdma_beacon_t b;
+    int64_t beacon_us = 0;
+
+    if (!rmds_lora_tdma_hear_beacon(tag, &b, &beacon_us)) {
+        ESP_LOGW(tag, "TDMA: no beacon, sending unscheduled");
+        g_tdma_period_ms = 0;
+        return 0;
+    }
+    g_tdma_beacon_wall_ms = rmds_lora_wall_ms() - (esp_timer_get_time() - beacon_us) / 1000;
+    g_tdma_period_ms = b.period_ms;
+
+    int slot = rmds_tdma_slot_of(&b, rmds_lora_node_id());
+    int64_t start_us = beacon_us + rmds_tdma_slot_start_ms(&b, slot) * 1000LL;
+    int64_t end_us = start_us + b.slot_ms * 1000LL;
+
+    if (slot != RMDS_TDMA_JOIN_SLOT) {
+        ESP_LOGI(tag, "TDMA: slot %d of %d, gateway T=%lu", slot, b.nslots,
+                 (unsigned long)b.time_ms);
+        g_tdma_join_failures = 0;
+        g_tdma_join_skip = 0;
+    } else {
+        // Contention: back off over batches after joins that got no slot
+        if (g_tdma_join_skip > 0) {
+            g_tdma_join_skip--;
+            ESP_LOGI(tag, "TDMA: no slot, backing off (%lu more)", (unsigned long)g_tdma_join_skip);
+            return -1;
+        }
+        int64_t spread = b.slot_ms * 1000LL - rmds_lora_airtime_us(RMDS_LORA_PACKET_MAX_LEN);
+        if (spread > 0) {
+            start_us += esp_random() % (uint32_t)spread;
+        }
+        g_tdma_join_failures++;
+        g_tdma_join_skip = rmds_tdma_join_skip(esp_random(), g_tdma_join_failures);
+        ESP_LOGI(tag, "TDMA: joining (%d slots taken)", b.nslots);
+    }
+
+    rmds_lora_sleep_until(start_us);
+    return end_us;
+}
+
+// Room left in the slot for a packet of len bytes (unscheduled: always)
+static bool rmds_lora_tdma_fits(int64_t slot_end_us, int len)
+{
+    if (slot_end_us <= 0) {
+        return slot_end_us == 0;
+    }
+    return esp_timer_get_time() + rmds_lora_airtime_us(len) <= slot_end_us;
+}
+
+// RX node: beacon for the next superframe. Returns its period.
+static uint32_t rmds_lora_send_beacon(const char *tag, rmds_tdma_sched_t *sched)
+{
+    static int owned_logged = -1;
+    rmds_tdma_beacon_t b;
+    char buf[RMDS_LORA_PACKET_MAX_LEN];
+
+    rmds_tdma_sched_beacon(sched, (uint32_t)(esp_timer_get_time() / 1000), &b);
+    int len = rmds_tdma_beacon_format(&b, buf, sizeof(buf));
+    if (len > 0) {
+        lora_send_packet((uint8_t *)buf, len);
+    }
+
+    int owned = rmds_tdma_sched_owned(sched);
+    if (owned != owned_logged) {
+        ESP_LOGI(tag, "TDMA: %d nodes, %d slots, superframe %lu ms (%lu joins, %lu expired)",
+                 owned, b.nslots, (unsigned long)b.period_ms,
+                 (unsigned long)sched->joins, (unsigned long)sched->leaves);
+        owned_logged = owned;
+    }
+    return b.period_ms;
+}
+#endif
+
+#if RMDS_LORA_ARQ
+// ACK window after a frame. One ACK releases every buffered frame it covers.
+static void rmds_lora_arq_wait_ack(const char *tag)
+{
+    char buf[RMDS_LORA_PACKET_MAX_LEN + 1];
+    int64_t until_us = esp_timer_get_time() + RMDS_LORA_ARQ_ACK_WAIT_MS * 1000LL;
+
+    lora_receive();
+    while (esp_timer_get_time() < until_us) {
+        int len = lora_receive_packet((uint8_t *)buf, sizeof(buf) - 1);
+        if (len > 0) {
+            uint32_t node, seq, bitmap;
+            buf[len] = '\0';
+            if (rmds_arq_ack_parse(buf, &node, &seq, &bitmap) && node == rmds_lora_node_id()) {
+                int released = rmds_arq_ack(&g_arq, seq, bitmap);
+                ESP_LOGI(tag, "ARQ: ACK seq=%lu bitmap=%08lx, %d frames released",
+                         (unsigned long)seq, (unsigned long)bitmap, released);
+                break;
+            }
+            lora_receive();   // another node's ACK or frame, keep listening
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    lora_sleep();
+}
+
+// Send a new frame and keep it until an ACK covers it
+static void rmds_lora_arq_send(const char *tag, const char *buf, int len, uint32_t seq)
+{
+    lora_send_packet((uint8_t *)buf, len);
+    rmds_arq_sent(&g_arq, seq, buf, len, rmds_lora_wall_ms(), esp_random());
+    rmds_lora_arq_wait_ack(tag);
+}
+
+// Resend the frames that are due. With linger, stay awake for the ones
+// due within RMDS_LORA_ARQ_LINGER_MS, up to RMDS_LORA_ARQ_WAIT_MAX_MS in
+// all; the rest wait in RTC memory for the next wake.
+static void rmds_lora_arq_resend(const char *tag, bool linger)
+{
+    int64_t start_ms = rmds_lora_wall_ms();
+
+    while (1) {
+        int64_t now_ms = rmds_lora_wall_ms();
+        rmds_arq_frame_t *f = rmds_arq_due(&g_arq, now_ms);
+        if (f != NULL) {
+            ESP_LOGI(tag, "ARQ: resending seq=%lu (try %d)", (unsigned long)f->seq, f->tries + 1);
+            lora_send_packet(f->data, f->len);
+            rmds_arq_resent(&g_arq, f, now_ms, esp_random());
+            rmds_lora_arq_wait_ack(tag);
+            continue;
+        }
+
+        int64_t next_ms = rmds_arq_next_due(&g_arq);
+        if (!linger || next_ms - now_ms > RMDS_LORA_ARQ_LINGER_MS ||
+            next_ms - start_ms > RMDS_LORA_ARQ_WAIT_MAX_MS) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(next_ms - now_ms) + 1);
+    }
+
+    ESP_LOGI(tag, "ARQ: %d waiting; %lu frames, %lu resent, %lu acked, %lu gave up, %lu evicted",
+             rmds_arq_pending(&g_arq), (unsigned long)g_arq.sent, (unsigned long)g_arq.resent,
+             (unsigned long)g_arq.acked, (unsigned long)g_arq.gave_up, (unsigned long)g_arq.evicted);
+}
+#endif
+
+#if RMDS_LORA_FEC
+// Add a data frame just sent to the current group; once the group is
+// complete, send its repair packets
+static void rmds_lora_fec_sent(const char *tag, const char *buf, int len, uint32_t seq)
+{
+    if (g_fec_tx.k == 0) {
+        rmds_fec_tx_init(&g_fec_tx, RMDS_LORA_FEC_K, RMDS_LORA_FEC_M);
+    }
+    if (!rmds_fec_tx_add(&g_fec_tx, seq, buf, len)) {
+        return;
+    }
+
+    for (int j = 0; j < g_fec_tx.m; j++) {
+        uint8_t pkt[RMDS_FEC_PACKET_MAX];
+        int pkt_len = rmds_fec_tx_repair(&g_fec_tx, j, rmds_lora_node_id(), pkt, sizeof(pkt));
+        if (pkt_len > 0) {
+            lora_send_packet(pkt, pkt_len);
+        }
+    }
+    ESP_LOGI(tag, "FEC: %d repair packets for seq %lu.. (%d frames), %lu groups, %lu cut short",
+             g_fec_tx.m, (unsigned long)g_fec_tx.base_seq, g_fec_tx.count,
+             (unsigned long)g_fec_tx.groups, (unsigned long)g_fec_tx.cut);
+    rmds_fec_tx_next(&g_fec_tx);
+}
+#endif
+
 //  TX-only task
 static void rmds_lora_tx_task(void *pvParameters)
 {
@@ -66,109 +553,372 @@ static void rmds_lora_tx_task(void *pvParameters)
     esp_log_level_set(TAG, ESP_LOG_INFO);
     ESP_LOGI(TAG, "TX task starting");
 
+    int64_t radio_on_us = esp_timer_get_time();
+
     if (!rmds_lora_common_init(TAG)) {
         ESP_LOGE(TAG, "TX task: init failed, deleting task");
+        g_lora_tx_task = NULL;
+        power_hold_release(POWER_HOLD_LORA_TX);
         vTaskDelete(NULL);
         return;
     }
 
-    // Create mutex for the shared payload buffer (if not already created)
-    if (g_lora_payload_mutex == NULL) {
-        g_lora_payload_mutex = xSemaphoreCreateMutex();
-        if (g_lora_payload_mutex == NULL) {
-            ESP_LOGE(TAG, "TX task: failed to create payload mutex");
-            vTaskDelete(NULL);
-            return;
-        }
-    }
-
-    g_lora_payload[0] = '\0';  // no payload yet
+    // Radio sleeps between sends; the driver wakes it and checks its config
+    lora_auto_sleep(1);
+    lora_sleep();
 
     while (1) {
-        // Copy the latest payload under mutex
-        char payload[RMDS_LORA_PAYLOAD_MAX_LEN];
-
-        if (g_lora_payload_mutex) {
-            xSemaphoreTake(g_lora_payload_mutex, portMAX_DELAY);
-            strncpy(payload, g_lora_payload, sizeof(payload) - 1);
-            payload[sizeof(payload) - 1] = '\0';
-            xSemaphoreGive(g_lora_payload_mutex);
-        } else {
-            payload[0] = '\0';
-        }
-
-        int base_len = (int)strlen(payload);
-        if (base_len == 0) {
-            ESP_LOGI(TAG, "TX: no sensor payload yet, skipping this period");
-            vTaskDelay(pdMS_TO_TICKS(RMDS_LORA_TX_PERIOD_MS));
-            continue;
+        size_t sent = 0;
+
+#if RMDS_LORA_TDMA
+        // Radio asleep until this node's slot; a backing-off joiner keeps
+        // its samples for the next batch
+        int64_t slot_end_us = rmds_lora_tdma_wait_slot(TAG);
+#endif
+
+        rmds_lora_pm_lock(true);
+        int tx_power = g_tx_power_dbm;
+        lora_set_tx_power(tx_power);
+        ESP_LOGI(TAG, "TX: %d dBm", tx_power);
+
+#if RMDS_LORA_ARQ
+        // Frames left unacknowledged last wake go first
+        rmds_lora_arq_resend(TAG, false);
+#endif
+
+        // Drain the ring, one packet per RMDS_FRAME_BATCH_MAX samples (or less if long)
+        while (1) {
+            rmds_sample_t batch[RMDS_FRAME_BATCH_MAX];
+            uint32_t first_seq = 0;
+            size_t n = rmds_samples_peek(batch, RMDS_FRAME_BATCH_MAX, &first_seq);
+            if (n == 0) {
+                break;
+            }
+
+            char tx_buf[RMDS_LORA_PACKET_MAX_LEN];
+            size_t used = 0;
+            int tx_len = rmds_lora_build_batch(tx_buf, sizeof(tx_buf),
+                                               batch, n, first_seq, &used);
+            if (used == 0) {
+                ESP_LOGE(TAG, "TX: sample does not fit in a packet, dropping it");
+                rmds_samples_consume(1);
+                continue;
+            }
+#if RMDS_LORA_TDMA
+            if (!rmds_lora_tdma_fits(slot_end_us, tx_len)) {
+                break;   // rest waits in the ring for the next slot
+            }
+#endif
+
+            ESP_LOGI(TAG,
+                     "TX: sending %u samples seq=%u len=%d: \"%.*s\"",
+                     (unsigned int)used,
+                     (unsigned int)g_lora_seq,
+                     tx_len,
+                     tx_len,
+                     tx_buf);
+
+            // This call blocks until the packet is transmitted
+#if RMDS_LORA_ARQ
+            rmds_lora_arq_send(TAG, tx_buf, tx_len, g_lora_seq);
+#else
+            lora_send_packet((uint8_t *)tx_buf, tx_len);
+#endif
+#if RMDS_LORA_FEC
+            rmds_lora_fec_sent(TAG, tx_buf, tx_len, g_lora_seq);
+#endif
+            ESP_LOGI(TAG, "TX: packet sent (SEQ=%u)", (unsigned int)g_lora_seq);
+            rmds_status_lora_seq(g_lora_seq);
+
+            rmds_samples_consume(used);
+            sent += used;
+
+            // Increment sequence for next packet
+            g_lora_seq++;
         }
 
-        // Build final TX packet with sequence prefix: "SEQ=N,<payload>"
-        char tx_buf[RMDS_LORA_PAYLOAD_MAX_LEN + 32];
-        int tx_len = snprintf(tx_buf, sizeof(tx_buf),
-                              "SEQ=%u,%s",
-                              (unsigned int)g_lora_seq,
-                              payload);
+        // Energy telemetry rides along with a data batch once per period
+        if (sent > 0 && energy_tlm_due()) {
+            char tlm[RMDS_LORA_PACKET_MAX_LEN];
+            int tlm_len = snprintf(tlm, sizeof(tlm), "SEQ=%u,NODE=%06lx,",
+                                   (unsigned int)g_lora_seq,
+                                   (unsigned long)rmds_lora_node_id());
+            tlm_len += energy_format_tlm(tlm + tlm_len, sizeof(tlm) - tlm_len);
+
+            // Channel contention this wake: sends / busy listens / forced
+            lora_lbt_stats_t lbt;
+            lora_get_lbt_stats(&lbt);
+            if (lbt.packets && tlm_len < (int)sizeof(tlm)) {
+                int w = snprintf(tlm + tlm_len, sizeof(tlm) - tlm_len, ",LBT=%lu/%lu/%lu",
+                                 (unsigned long)lbt.packets,
+                                 (unsigned long)(lbt.busy_rssi + lbt.busy_cad),
+                                 (unsigned long)lbt.forced);
+                if (w > 0 && w < (int)sizeof(tlm) - tlm_len) {
+                    tlm_len += w;
+                }
+            }
 
-        if (tx_len < 0) {
-            tx_len = 0;
-        } else if (tx_len >= (int)sizeof(tx_buf)) {
-            // Truncate safely if needed
-            tx_len = (int)sizeof(tx_buf) - 1;
-            tx_buf[tx_len] = '\0';
-            ESP_LOGW(TAG, "TX: payload truncated to %d bytes", tx_len);
+#if RMDS_LORA_TDMA
+            if (rmds_lora_tdma_fits(slot_end_us, tlm_len))
+#endif
+            {
+                ESP_LOGI(TAG, "TX: telemetry \"%.*s\"", tlm_len, tlm);
+                lora_send_packet((uint8_t *)tlm, tlm_len);
+                energy_tlm_sent();
+                g_lora_seq++;
+            }
         }
 
-        ESP_LOGI(TAG,
-                 "TX: sending sensor payload seq=%u len=%d: \"%.*s\"",
-                 (unsigned int)g_lora_seq,
-                 tx_len,
-                 tx_len,
-                 tx_buf);
+#if RMDS_LORA_ARQ
+        rmds_lora_arq_resend(TAG, true);
+#endif
 
-        // This call blocks until the packet is transmitted
-        lora_send_packet((uint8_t *)tx_buf, tx_len);
-        ESP_LOGI(TAG, "TX: packet sent (SEQ=%u)", (unsigned int)g_lora_seq);
+        rmds_lora_pm_lock(false);
+        rmds_lora_log_mode_times(TAG);
 
-        // Increment sequence for next packet
-        g_lora_seq++;
+        // Radio energy per reading: on-time (init included) over readings carried
+        int64_t now = esp_timer_get_time();
+        g_radio_us_total += (uint64_t)(now - radio_on_us);
+        g_readings_sent_total += sent;
+        if (g_readings_sent_total) {
+            ESP_LOGI(TAG,
+                     "TX: radio on %lld ms for %u readings, avg %llu ms/reading over %lu readings",
+                     (long long)((now - radio_on_us) / 1000),
+                     (unsigned int)sent,
+                     (unsigned long long)(g_radio_us_total / 1000 / g_readings_sent_total),
+                     (unsigned long)g_readings_sent_total);
+        }
 
-        vTaskDelay(pdMS_TO_TICKS(RMDS_LORA_TX_PERIOD_MS));
+        if (sent > 0) {
+            power_note_useful_tx();
+        }
+        power_hold_release(POWER_HOLD_LORA_TX);
+
+        // Wait for rmds_lora_send_samples() to say the next batch is due
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        radio_on_us = esp_timer_get_time();
     }
 }
 
 // Public API to start TX-only behavior
 void rmds_lora_start_tx_only(void)
 {
+    if (g_lora_tx_task != NULL) {
+        return;
+    }
+
     BaseType_t ok = xTaskCreate(
         rmds_lora_tx_task,
         "rmds_lora_tx_task",
         4096,
         NULL,
         5,
-        NULL
+        &g_lora_tx_task
     );
 
     if (ok != pdPASS) {
         ESP_LOGE(LORA_TAG, "Failed to create rmds_lora_tx_task");
+        g_lora_tx_task = NULL;
+        return;
     }
+    rmds_metrics_register_task(g_lora_tx_task);
 }
 
-// Public API called from UART RX task to update the payload
-void rmds_lora_set_payload(const char *payload)
+void rmds_lora_set_tx_power(int dbm)
 {
-    if (!payload || !g_lora_payload_mutex) {
-        // If mutex isn't ready yet, just drop this update.
+    if (dbm < RMDS_LORA_TX_POWER_MIN) {
+        dbm = RMDS_LORA_TX_POWER_MIN;
+    } else if (dbm > RMDS_LORA_TX_POWER_MAX) {
+        dbm = RMDS_LORA_TX_POWER_MAX;
+    }
+    g_tx_power_dbm = dbm;
+}
+
+// Public API called from UART RX task once enough samples are waiting
+void rmds_lora_send_samples(void)
+{
+    if (g_lora_tx_task == NULL) {
+        // The task sends everything pending as soon as the radio is up
+        rmds_lora_start_tx_only();
         return;
     }
+    xTaskNotifyGive(g_lora_tx_task);
+}
 
-    xSemaphoreTake(g_lora_payload_mutex, portMAX_DELAY);
-    strncpy(g_lora_payload, payload, RMDS_LORA_PAYLOAD_MAX_LEN - 1);
-    g_lora_payload[RMDS_LORA_PAYLOAD_MAX_LEN - 1] = '\0';
-    xSemaphoreGive(g_lora_payload_mutex);
+// RX node: sequence check of one packet in the sender's table entry.
+// Returns false for a duplicate, which isn't forwarded again.
+static bool rmds_lora_node_packet(const char *tag, const char *text, int rssi, float snr)
+{
+    uint32_t node = 0, seq = 0;
+    if (g_nodes == NULL || !rmds_frame_header(text, &node, &seq) || node == 0) {
+        return true;   // older node firmware without NODE=
+    }
+
+    rmds_node_entry_t *e = rmds_nodes_find(g_nodes, node);
+    uint32_t lost_before = e ? e->lost : 0;
+    rmds_node_pkt_t verdict = rmds_nodes_update(g_nodes, node, seq, rssi, snr,
+                                                esp_timer_get_time() / 1000, &e);
+    switch (verdict) {
+    case RMDS_NODE_PKT_FIRST:
+        ESP_LOGI(tag, "RX: new node %06lx (%lu tracked)",
+                 (unsigned long)node, (unsigned long)g_nodes->count);
+        break;
+    case RMDS_NODE_PKT_RESTART:
+        ESP_LOGI(tag, "RX: node %06lx restarted at seq %lu", (unsigned long)node, (unsigned long)seq);
+        break;
+    case RMDS_NODE_PKT_DUPLICATE:
+        ESP_LOGI(tag, "RX: duplicate seq %lu from node %06lx, dropped",
+                 (unsigned long)seq, (unsigned long)node);
+        break;
+    case RMDS_NODE_PKT_FULL:
+        ESP_LOGW(tag, "RX: node table full, not tracking %06lx", (unsigned long)node);
+        break;
+    default:
+        break;
+    }
+
+    uint32_t skipped = verdict == RMDS_NODE_PKT_NEW ? e->lost - lost_before : 0;
+    rmds_metrics_link_packet(skipped, verdict == RMDS_NODE_PKT_LATE,
+                             verdict == RMDS_NODE_PKT_DUPLICATE, g_nodes->count);
+
+#if RMDS_LORA_ARQ
+    // ACK straight away, duplicates too (the last ACK was lost): the node
+    // is listening only briefly. The entry's sequence window is the bitmap.
+    if (e != NULL) {
+        char ack[48];
+        int len = rmds_arq_ack_format(ack, sizeof(ack), node, e->last_seq, e->seq_seen);
+        if (len > 0) {
+            lora_send_packet((uint8_t *)ack, len);
+        }
+    }
+#endif
+    return verdict != RMDS_NODE_PKT_DUPLICATE;
 }
 
+// RX node: node table summary with the mode times (each node at debug
+// level), and dropping nodes gone quiet
+static void rmds_lora_log_nodes(const char *tag)
+{
+    if (g_nodes == NULL) {
+        return;
+    }
+    uint32_t expired = rmds_nodes_expire(g_nodes, esp_timer_get_time() / 1000,
+                                         RMDS_LORA_NODE_EXPIRE_MS);
+    for (uint32_t i = 0; i < RMDS_NODES_CAPACITY; i++) {
+        const rmds_node_entry_t *e = &g_nodes->entry[i];
+        if (e->node == 0) {
+            continue;
+        }
+        ESP_LOGD(tag, "Node %06lx: seq %lu, %lu rx, %lu lost, %lu dup, rssi %.1f snr %.1f, %lld s ago",
+                 (unsigned long)e->node, (unsigned long)e->last_seq,
+                 (unsigned long)e->packets, (unsigned long)e->lost, (unsigned long)e->duplicates,
+                 e->rssi_q4 / 16.0, e->snr_q4 / 16.0,
+                 (long long)((esp_timer_get_time() / 1000 - e->last_seen_ms) / 1000));
+    }
+    ESP_LOGI(tag, "Nodes: %lu tracked, %lu expired, %lu refused",
+             (unsigned long)g_nodes->count, (unsigned long)expired, (unsigned long)g_nodes->refused);
+}
+
+// RX node: one frame, received or rebuilt by the erasure code
+static void rmds_lora_rx_frame(const char *tag, const char *text, int rssi, float snr)
+{
+#if RMDS_LORA_FEC
+    // Kept for rebuilding the rest of its group
+    uint32_t node, seq;
+    if (g_fec_rx != NULL && rmds_frame_header(text, &node, &seq) && node != 0) {
+        rmds_fec_rx_data(g_fec_rx, node, seq, text, strlen(text));
+    }
+#endif
+
+    // Decode into typed fields and forward to the cloud.
+    // Sensor nodes batch several readings into one packet.
+    rmds_reading_t readings[RMDS_FRAME_BATCH_MAX];
+    size_t n = 0;
+    if (!rmds_lora_node_packet(tag, text, rssi, snr)) {
+        // Already forwarded
+    } else if (strstr(text, ",TLM,")) {
+        // Node energy telemetry: log it for build-to-build comparison
+        ESP_LOGI(tag, "RX: telemetry rssi=%d snr=%.1f %s", rssi, snr, text);
+    } else if ((n = rmds_frame_parse_batch(text, readings, RMDS_FRAME_BATCH_MAX)) > 0) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+
+        if (readings[0].battery_mv) {
+            ESP_LOGI(tag, "RX: node %lx battery %lu mV",
+                     (unsigned long)readings[0].node,
+                     (unsigned long)readings[0].battery_mv);
+        }
+#if RMDS_LORA_TDMA
+        if (readings[0].node) {
+            rmds_tdma_sched_heard(&g_tdma_sched, readings[0].node,
+                                  (uint32_t)(esp_timer_get_time() / 1000));
+        }
+#endif
+        const rmds_reading_t *last = &readings[n - 1];
+        rmds_status_reading(last->ppm, last->faults, last->temp_dK);
+        rmds_status_lora_seq(last->seq);
+
+        for (size_t i = 0; i < n; i++) {
+            readings[i].rssi = rssi;
+            readings[i].snr  = snr;
+            readings[i].gw_time_ms = (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+            send_frame_to_cloud(&readings[i]);
+        }
+    } else {
+        rmds_metrics_frame_rejected();
+        ESP_LOGW(tag, "RX: could not decode frame, not forwarding");
+    }
+}
+
+#if RMDS_LORA_FEC
+typedef struct {
+    const char *tag;
+    int         rssi;
+    float       snr;
+} rmds_lora_rebuilt_t;
+
+// A frame rebuilt from a repair packet, which lends it its RSSI/SNR
+static void rmds_lora_fec_rebuilt(uint32_t node, uint32_t seq, const uint8_t *frame,
+                                  size_t len, void *arg)
+{
+    const rmds_lora_rebuilt_t *rx = arg;
+    char text[RMDS_FEC_FRAME_MAX + 1];
+
+    memcpy(text, frame, len);
+    text[len] = '\0';
+    ESP_LOGI(rx->tag, "FEC: rebuilt seq %lu of node %06lx: \"%s\"",
+             (unsigned long)seq, (unsigned long)node, text);
+    rmds_lora_rx_frame(rx->tag, text, rx->rssi, rx->snr);
+}
+#endif
+
+#if RMDS_LORA_LPL
+// One low-power listening slot: CAD, and only on a detected preamble a full
+// receive window. Returns the packet length (radio left in standby) or 0
+// (radio back asleep).
+static int rmds_lora_cad_receive(uint8_t *buf, int size)
+{
+    if (!lora_cad()) {
+        lora_sleep();
+        return 0;
+    }
+
+    lora_receive();
+    int64_t deadline = esp_timer_get_time() + RMDS_LORA_CAD_RX_WINDOW_MS * 1000LL;
+    while (esp_timer_get_time() < deadline) {
+        int len = lora_receive_packet(buf, size);
+        if (len > 0) {
+            return len;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    // Preamble without a packet (collision, CRC error or another network)
+    lora_sleep();
+    return 0;
+}
+#endif
+
 //  RX-only task
 static void rmds_lora_rx_task(void *pvParameters)
 {
@@ -184,40 +934,115 @@ static void rmds_lora_rx_task(void *pvParameters)
         return;
     }
 
+    g_nodes = calloc(1, sizeof(*g_nodes));
+    if (g_nodes == NULL) {
+        ESP_LOGW(TAG, "RX: no memory for the node table, not tracking nodes");
+    } else {
+        rmds_nodes_init(g_nodes);
+    }
+
+#if RMDS_LORA_FEC
+    g_fec_rx = malloc(sizeof(*g_fec_rx));
+    if (g_fec_rx == NULL) {
+        ESP_LOGW(TAG, "RX: no memory for the FEC cache, not rebuilding frames");
+    } else {
+        rmds_fec_rx_init(g_fec_rx);
+    }
+#endif
+
     uint8_t buf[256];
+    int64_t next_mode_log = esp_timer_get_time() + RMDS_LORA_MODE_LOG_S * 1000000LL;
+
+#if RMDS_LORA_TDMA
+    rmds_tdma_sched_init(&g_tdma_sched, RMDS_TDMA_SLOT_MS, RMDS_LORA_TDMA_EXPIRE_MS);
+    int64_t next_beacon = esp_timer_get_time();
+#endif
 
+#if RMDS_LORA_LPL
+    ESP_LOGI(TAG, "RX: CAD listening every %d ms (preamble %ld symbols)",
+             RMDS_LORA_CAD_PERIOD_MS, (long)RMDS_LORA_PREAMBLE_LEN);
+    lora_sleep();
+#else
     // Put radio into continuous receive mode
     ESP_LOGI(TAG, "RX: entering continuous receive mode");
     lora_receive();
+#endif
 
     while (1) {
+        rmds_lora_pm_lock(true);
+#if RMDS_LORA_TDMA
+        // Beacons on a fixed cadence; each one sets the next superframe
+        if (esp_timer_get_time() >= next_beacon) {
+            next_beacon += rmds_lora_send_beacon(TAG, &g_tdma_sched) * 1000LL;
+            lora_receive();
+        }
+#endif
+#if RMDS_LORA_LPL
+        int len = rmds_lora_cad_receive(buf, sizeof(buf) - 1);
+#else
         int len = lora_receive_packet(buf, sizeof(buf) - 1);
+#endif
         if (len > 0) {
             buf[len] = '\0';
-            printf("[LoRa RX] %s\n", (char *)buf);
-            ESP_LOGI(TAG, "RX: got packet len=%d payload=\"%s\"", len, buf);
+            int rssi = lora_packet_rssi();
+            float snr = lora_packet_snr();
+            rmds_metrics_packet_received(rssi, snr);
+            rmds_status_link(rssi, snr);
+
+#if RMDS_LORA_FEC
+            if (rmds_fec_is_repair(buf, len)) {
+                // Binary after the header, so not printed
+                rmds_lora_rebuilt_t rx = { TAG, rssi, snr };
+                int rebuilt = g_fec_rx ? rmds_fec_rx_repair(g_fec_rx, buf, len,
+                                                            rmds_lora_fec_rebuilt, &rx) : 0;
+                ESP_LOGI(TAG, "RX: repair packet len=%d, %d frames rebuilt", len, rebuilt);
+            } else
+#endif
+            {
+                printf("[LoRa RX] %s\n", (char *)buf);
+                ESP_LOGI(TAG, "RX: got packet len=%d payload=\"%s\"", len, buf);
+                rmds_lora_rx_frame(TAG, (const char *)buf, rssi, snr);
+            }
 
+#if RMDS_LORA_LPL
+            lora_sleep();
+#else
             // Resume continuous receive
             lora_receive();
+#endif
+        }
+        rmds_lora_pm_lock(false);
+
+        if (esp_timer_get_time() >= next_mode_log) {
+            rmds_lora_log_mode_times(TAG);
+            rmds_lora_log_nodes(TAG);
+            next_mode_log += RMDS_LORA_MODE_LOG_S * 1000000LL;
         }
 
+#if RMDS_LORA_LPL
+        vTaskDelay(pdMS_TO_TICKS(RMDS_LORA_CAD_PERIOD_MS));
+#else
         vTaskDelay(pdMS_TO_TICKS(10));  // small delay to avoid hogging CPU
+#endif
     }
 }
 
 // Public API to start RX-only behavior
 void rmds_lora_start_rx_only(void)
 {
+    TaskHandle_t task = NULL;
     BaseType_t ok = xTaskCreate(
         rmds_lora_rx_task,
         "rmds_lora_rx_task",
-        4096,
+        RMDS_LORA_FEC ? 6144 : 4096,   // rebuilt frames are handled a few calls deeper
         NULL,
         5,
-        NULL
+        &task
     );
 
     if (ok != pdPASS) {
         ESP_LOGE(LORA_TAG, "Failed to create rmds_lora_rx_task");
+        return;
     }
+    rmds_metrics_register_task(task);
 }
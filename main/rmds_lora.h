@@ -6,20 +6,66 @@ extern "C" {
 
 #include "freertos/FreeRTOS.h"
 
-// Max length of the text payload we send over LoRa
-#define RMDS_LORA_PAYLOAD_MAX_LEN 96
+#include "rmds_tdma.h"
 
-// Start LoRa in TX-only mode (periodic packets every 400 ms).
-// Now sends the latest methane sensor payload provided via rmds_lora_set_payload().
+// Max length of one batched text packet we send over LoRa
+#define RMDS_LORA_PACKET_MAX_LEN 200
+
+// Slotted TDMA (rmds_tdma.h): the RX node broadcasts beacons, TX nodes send
+// only in their slot. Both ends must be built with the same setting, and
+// listen before talk (CONFIG_LORA_LBT) is best left off with it: its
+// backoff can push a packet past the end of the slot.
+#define RMDS_LORA_TDMA           0
+
+// Longest a TX node may wait for its slot: up to a superframe each to
+// reach the predicted beacon, to listen for it, and to reach the slot
+#if RMDS_LORA_TDMA
+#define RMDS_LORA_TDMA_WAIT_MAX_MS \
+    (3 * (RMDS_TDMA_BEACON_SLOT_MS + (RMDS_TDMA_MAX_SLOTS + 1) * RMDS_TDMA_SLOT_MS))
+#else
+#define RMDS_LORA_TDMA_WAIT_MAX_MS 0
+#endif
+
+// Acknowledged delivery (rmds_arq.h): the RX node answers every frame with
+// an ACK, the TX node keeps its frames until an ACK covers them and resends
+// them with backoff. Both ends must be built with the same setting. Not
+// with TDMA: its slots leave no room for the ACK.
+#define RMDS_LORA_ARQ            0
+
+// Longest a TX node stays awake per wake for resends and ACK windows
+#if RMDS_LORA_ARQ
+#define RMDS_LORA_ARQ_WAIT_MAX_MS 5000
+#else
+#define RMDS_LORA_ARQ_WAIT_MAX_MS 0
+#endif
+
+// Erasure code (rmds_fec.h): after every RMDS_LORA_FEC_K data frames the TX
+// node sends RMDS_LORA_FEC_M repair packets, from which the RX node rebuilds
+// up to M lost frames of the group without any reverse channel. Costs about
+// M/K more airtime. Both ends must be built with it; not with TDMA.
+#define RMDS_LORA_FEC            0
+#define RMDS_LORA_FEC_K          4
+#define RMDS_LORA_FEC_M          2
+
+// Output power range of the PA_BOOST pin (dBm)
+#define RMDS_LORA_TX_POWER_MIN   2
+#define RMDS_LORA_TX_POWER_MAX   17
+
+// Start LoRa in TX-only mode. The task powers up the radio, sends every
+// sample waiting in the RTC ring (rmds_samples.h), then waits for the next kick.
 void rmds_lora_start_tx_only(void);
 
+// Send the pending samples now, starting the TX task on first use.
+// Safe to call from the UART RX task.
+void rmds_lora_send_samples(void);
+
+// TX power for the next send (clamped to the range above). Applied by the
+// TX task before each drain; defaults to RMDS_LORA_TX_POWER_MAX.
+void rmds_lora_set_tx_power(int dbm);
+
 // Start LoRa in RX-only mode (continuous listen).
 void rmds_lora_start_rx_only(void);
 
-// Update the text payload that the TX task will send periodically.
-// Safe to call from the UART RX task.
-void rmds_lora_set_payload(const char *payload);
-
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,312 @@
+// rmds_metrics.c
+//
+// Gateway counters in Prometheus text format. Recording is a handful of
+// relaxed atomic adds; all formatting happens in the scrape handler.
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+
+#include "lora.h"
+#include "rmds_metrics.h"
+#include "rmds_uplink.h"
+
+#define METRICS_TAG "RMDS_METRICS"
+
+//  Fixed-bucket histogram
+//
+// Buckets are stored non-cumulative and summed on scrape.
+typedef struct {
+    const char    *name;
+    const char    *help;
+    const int32_t *bounds;       // ascending upper bounds, +Inf implied
+    int            nbounds;
+    int            scale;        // stored value = real value * scale
+    atomic_uint   *buckets;      // nbounds + 1
+    atomic_int     sum;
+    atomic_uint    count;
+} metrics_hist_t;
+
+#define METRICS_HIST(var, n, h, sc, ...)                                        \
+    static const int32_t var##_bounds[] = { __VA_ARGS__ };                      \
+    static atomic_uint var##_buckets[sizeof(var##_bounds) / sizeof(int32_t) + 1]; \
+    static metrics_hist_t var = {                                               \
+        .name = n, .help = h,                                                   \
+        .bounds = var##_bounds,                                                 \
+        .nbounds = sizeof(var##_bounds) / sizeof(int32_t),                      \
+        .scale = sc,                                                            \
+        .buckets = var##_buckets,                                               \
+    }
+
+// RSSI in dBm, SNR in quarter dB (the SX127x resolution), latency in ms
+METRICS_HIST(s_rssi_hist, "rmds_lora_rssi_dbm", "Received packet RSSI", 1,
+             -120, -110, -100, -90, -80, -70, -60);
+METRICS_HIST(s_snr_hist, "rmds_lora_snr_db", "Received packet SNR", 4,
+             -15, -10, -5, 0, 5, 10);
+METRICS_HIST(s_upload_hist, "rmds_uplink_latency_ms", "Uplink batch send time", 1,
+             100, 250, 500, 1000, 2500, 5000);
+
+static atomic_uint s_packets_received;
+static atomic_uint s_frames_rejected;
+static atomic_uint s_packets_skipped;
+static atomic_uint s_packets_late;
+static atomic_uint s_packets_duplicate;
+static atomic_uint s_nodes_tracked;
+static atomic_uint s_uploads_ok;
+static atomic_uint s_uploads_failed;
+static atomic_uint s_readings_uploaded;
+static atomic_uint s_readings_failed;
+
+static TaskHandle_t s_tasks[RMDS_METRICS_MAX_TASKS];
+static atomic_int   s_task_count;
+
+static httpd_handle_t s_server = NULL;
+
+static void hist_observe(metrics_hist_t *h, int32_t value)
+{
+    int i = 0;
+    while (i < h->nbounds && value > h->bounds[i] * h->scale) {
+        i++;
+    }
+    atomic_fetch_add_explicit(&h->buckets[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+}
+
+void rmds_metrics_packet_received(int rssi, float snr)
+{
+    atomic_fetch_add_explicit(&s_packets_received, 1, memory_order_relaxed);
+    hist_observe(&s_rssi_hist, rssi);
+    hist_observe(&s_snr_hist, (int32_t)(snr * 4.0f));
+}
+
+void rmds_metrics_frame_rejected(void)
+{
+    atomic_fetch_add_explicit(&s_frames_rejected, 1, memory_order_relaxed);
+}
+
+void rmds_metrics_link_packet(uint32_t skipped, bool late, bool duplicate, uint32_t nodes)
+{
+    if (skipped) {
+        atomic_fetch_add_explicit(&s_packets_skipped, skipped, memory_order_relaxed);
+    }
+    if (late) {
+        atomic_fetch_add_explicit(&s_packets_late, 1, memory_order_relaxed);
+    }
+    if (duplicate) {
+        atomic_fetch_add_explicit(&s_packets_duplicate, 1, memory_order_relaxed);
+    }
+    atomic_store_explicit(&s_nodes_tracked, nodes, memory_order_relaxed);
+}
+
+void rmds_metrics_readings(uint32_t readings, bool ok)
+{
+    atomic_fetch_add_explicit(ok ? &s_readings_uploaded : &s_readings_failed,
+                              readings, memory_order_relaxed);
+}
+
+void rmds_metrics_upload(uint32_t readings, bool ok, int64_t latency_us)
+{
+    atomic_fetch_add_explicit(ok ? &s_uploads_ok : &s_uploads_failed, 1, memory_order_relaxed);
+    rmds_metrics_readings(readings, ok);
+    hist_observe(&s_upload_hist, (int32_t)(latency_us / 1000));
+}
+
+void rmds_metrics_register_task(TaskHandle_t task)
+{
+    int slot = atomic_fetch_add(&s_task_count, 1);
+    if (slot >= RMDS_METRICS_MAX_TASKS) {
+        atomic_fetch_sub(&s_task_count, 1);
+        ESP_LOGW(METRICS_TAG, "Task table full, not exporting %s", pcTaskGetName(task));
+        return;
+    }
+    s_tasks[slot] = task;
+}
+
+//  Scrape side
+
+typedef struct {
+    httpd_req_t *req;
+    char  buf[512];
+    size_t len;
+    esp_err_t err;
+} metrics_out_t;
+
+static void out_flush(metrics_out_t *o)
+{
+    if (o->len > 0 && o->err == ESP_OK) {
+        o->err = httpd_resp_send_chunk(o->req, o->buf, (ssize_t)o->len);
+    }
+    o->len = 0;
+}
+
+static void out_printf(metrics_out_t *o, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void out_printf(metrics_out_t *o, const char *fmt, ...)
+{
+    // Straight into the chunk buffer; if it doesn't fit, send what is there
+    // and format again into the empty buffer, so no line is ever cut
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        size_t room = sizeof(o->buf) - o->len;
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(&o->buf[o->len], room, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            return;
+        }
+        if ((size_t)n < room) {
+            o->len += (size_t)n;
+            return;
+        }
+        out_flush(o);
+    }
+
+    // Longer than the whole buffer: better a failed scrape than a bad one
+    ESP_LOGE(METRICS_TAG, "Metrics text too long for one chunk");
+    o->err = ESP_ERR_INVALID_SIZE;
+}
+
+static void out_counter(metrics_out_t *o, const char *name, const char *help, uint32_t v)
+{
+    out_printf(o, "# HELP %s %s\n# TYPE %s counter\n%s %lu\n",
+               name, help, name, name, (unsigned long)v);
+}
+
+static void out_gauge(metrics_out_t *o, const char *name, const char *help, uint32_t v)
+{
+    out_printf(o, "# HELP %s %s\n# TYPE %s gauge\n%s %lu\n",
+               name, help, name, name, (unsigned long)v);
+}
+
+static void out_lora_modes(metrics_out_t *o)
+{
+    lora_mode_times_t t;
+    lora_get_mode_times(&t);
+
+    const struct { const char *mode; uint64_t us; } modes[] = {
+        { "sleep", t.sleep_us }, { "standby", t.standby_us }, { "tx", t.tx_us },
+        { "rx", t.rx_us }, { "cad", t.cad_us },
+    };
+    out_printf(o, "# HELP rmds_lora_mode_seconds_total Time the radio spent in each mode\n"
+                  "# TYPE rmds_lora_mode_seconds_total counter\n");
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+        out_printf(o, "rmds_lora_mode_seconds_total{mode=\"%s\"} %llu.%03llu\n",
+                   modes[i].mode,
+                   (unsigned long long)(modes[i].us / 1000000),
+                   (unsigned long long)(modes[i].us / 1000 % 1000));
+    }
+}
+
+static void out_hist(metrics_out_t *o, metrics_hist_t *h)
+{
+    out_printf(o, "# HELP %s %s\n# TYPE %s histogram\n", h->name, h->help, h->name);
+
+    uint32_t cumulative = 0;
+    for (int i = 0; i <= h->nbounds; ++i) {
+        cumulative += atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        if (i < h->nbounds) {
+            out_printf(o, "%s_bucket{le=\"%ld\"} %lu\n",
+                       h->name, (long)h->bounds[i], (unsigned long)cumulative);
+        } else {
+            out_printf(o, "%s_bucket{le=\"+Inf\"} %lu\n", h->name, (unsigned long)cumulative);
+        }
+    }
+
+    int32_t sum = atomic_load_explicit(&h->sum, memory_order_relaxed);
+    out_printf(o, "%s_sum %.2f\n%s_count %lu\n",
+               h->name, (double)sum / h->scale,
+               h->name, (unsigned long)atomic_load_explicit(&h->count, memory_order_relaxed));
+}
+
+static esp_err_t metrics_get_handler(httpd_req_t *req)
+{
+    metrics_out_t o = { .req = req, .len = 0, .err = ESP_OK };
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    // Radio
+    out_counter(&o, "rmds_lora_packets_received_total", "LoRa packets received with a valid CRC",
+                atomic_load(&s_packets_received));
+    out_counter(&o, "rmds_lora_crc_errors_total", "LoRa packets dropped on payload CRC error",
+                lora_crc_error_count());
+    out_counter(&o, "rmds_frames_rejected_total", "Packets that did not decode as a reading",
+                atomic_load(&s_frames_rejected));
+    out_counter(&o, "rmds_lora_packets_skipped_total", "Gaps in the node packet sequence numbers",
+                atomic_load(&s_packets_skipped));
+    out_counter(&o, "rmds_lora_packets_late_total", "Packets that arrived after a later one",
+                atomic_load(&s_packets_late));
+    out_counter(&o, "rmds_lora_packets_duplicate_total", "Packets received twice, not forwarded",
+                atomic_load(&s_packets_duplicate));
+    out_gauge(&o, "rmds_lora_nodes_tracked", "Sensor nodes in the gateway node table",
+              atomic_load(&s_nodes_tracked));
+    out_lora_modes(&o);
+    out_hist(&o, &s_rssi_hist);
+    out_hist(&o, &s_snr_hist);
+
+    // Pipeline / uplink
+    out_gauge(&o, "rmds_uplink_queue_depth", "Readings waiting for the uplink task",
+              rmds_uplink_queue_depth());
+    out_counter(&o, "rmds_uplink_batches_ok_total", "Uplink batches accepted",
+                atomic_load(&s_uploads_ok));
+    out_counter(&o, "rmds_uplink_batches_failed_total", "Uplink batches that failed",
+                atomic_load(&s_uploads_failed));
+    out_counter(&o, "rmds_uplink_readings_total", "Readings delivered upstream",
+                atomic_load(&s_readings_uploaded));
+    out_counter(&o, "rmds_uplink_readings_failed_total", "Readings lost to failed batches",
+                atomic_load(&s_readings_failed));
+    out_hist(&o, &s_upload_hist);
+
+    // System
+    out_gauge(&o, "rmds_heap_free_bytes", "Free heap",
+              heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    out_gauge(&o, "rmds_heap_min_free_bytes", "Lowest free heap since boot",
+              heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+
+    out_printf(&o, "# HELP rmds_task_stack_free_bytes Task stack high-water mark\n"
+                   "# TYPE rmds_task_stack_free_bytes gauge\n");
+    int tasks = atomic_load(&s_task_count);
+    for (int i = 0; i < tasks && i < RMDS_METRICS_MAX_TASKS; ++i) {
+        out_printf(&o, "rmds_task_stack_free_bytes{task=\"%s\"} %lu\n",
+                   pcTaskGetName(s_tasks[i]),
+                   (unsigned long)uxTaskGetStackHighWaterMark(s_tasks[i]));
+    }
+
+    out_flush(&o);
+    if (o.err != ESP_OK) {
+        return o.err;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+void rmds_metrics_start_server(void)
+{
+    if (s_server) {
+        return;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = RMDS_METRICS_PORT;
+    config.ctrl_port = RMDS_METRICS_PORT + 1;
+    config.task_priority = 2;   // below radio and uplink
+
+    if (httpd_start(&s_server, &config) != ESP_OK) {
+        ESP_LOGE(METRICS_TAG, "Failed to start metrics server");
+        s_server = NULL;
+        return;
+    }
+
+    static const httpd_uri_t metrics_uri = {
+        .uri     = "/metrics",
+        .method  = HTTP_GET,
+        .handler = metrics_get_handler,
+    };
+    httpd_register_uri_handler(s_server, &metrics_uri);
+
+    ESP_LOGI(METRICS_TAG, "Serving Prometheus metrics on :%d/metrics", RMDS_METRICS_PORT);
+}
@@ -0,0 +1,43 @@
+// rmds_metrics.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Port for the Prometheus scrape endpoint (GET /metrics)
+#define RMDS_METRICS_PORT      9100
+
+// Tasks whose stack high-water mark is exported
+#define RMDS_METRICS_MAX_TASKS 8
+
+/**
+ * Start the HTTP server that serves /metrics. Call once Wi-Fi is up.
+ */
+void rmds_metrics_start_server(void);
+
+/**
+ * Export this task's stack high-water mark.
+ */
+void rmds_metrics_register_task(TaskHandle_t task);
+
+// Hot-path recorders. Lock-free; formatting only happens on scrape.
+void rmds_metrics_packet_received(int rssi, float snr);
+void rmds_metrics_frame_rejected(void);
+// Per-node sequence check of one packet: sequence numbers skipped, a late
+// one filling an earlier gap, or a duplicate; and how many nodes are tracked
+void rmds_metrics_link_packet(uint32_t skipped, bool late, bool duplicate, uint32_t nodes);
+// One batch handed to the uplink backend, and its readings
+void rmds_metrics_upload(uint32_t readings, bool ok, int64_t latency_us);
+// Readings delivered or lost after their batch was counted (MQTT acks)
+void rmds_metrics_readings(uint32_t readings, bool ok);
+
+#ifdef __cplusplus
+}
+#endif
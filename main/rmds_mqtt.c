@@ -0,0 +1,195 @@
+// rmds_mqtt.c
+//
+// MQTT uplink backend. One persistent session to the broker; each reading
+// is published as compact JSON on its node's topic with QoS 1. Publishes
+// are enqueued into the client outbox so many can be in flight at once,
+// bounded by RMDS_MQTT_MAX_INFLIGHT. A reading counts as uploaded when the
+// broker acks it, and as failed if it expires from the outbox first.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "mqtt_client.h"
+
+#include "rmds_json.h"
+#include "rmds_uplink.h"
+#include "rmds_wifi.h"
+
+#define MQTT_TAG "RMDS_MQTT"
+
+#define RMDS_MQTT_BROKER_URI     "mqtt://192.168.1.10:1883"
+#define RMDS_MQTT_TOPIC_PREFIX   "rmds"
+#define RMDS_MQTT_KEEPALIVE_S    60
+
+// Unacknowledged QoS 1 messages allowed at once
+#define RMDS_MQTT_MAX_INFLIGHT   32
+
+// How long send_batch waits for the window to open before giving up
+#define RMDS_MQTT_WINDOW_WAIT_MS 5000
+
+#define RMDS_MQTT_PAYLOAD_MAX    192
+
+static esp_mqtt_client_handle_t s_mqtt_client = NULL;
+static SemaphoreHandle_t s_inflight_window = NULL;
+static volatile bool s_mqtt_connected = false;
+
+// Fixed-size sink so each payload is built without heap
+typedef struct {
+    char   buf[RMDS_MQTT_PAYLOAD_MAX];
+    size_t len;
+} rmds_mqtt_payload_t;
+
+static int rmds_mqtt_payload_sink(void *ctx, const char *data, size_t len)
+{
+    rmds_mqtt_payload_t *p = (rmds_mqtt_payload_t *)ctx;
+    if (p->len + len > sizeof(p->buf)) {
+        return -1;
+    }
+    memcpy(&p->buf[p->len], data, len);
+    p->len += len;
+    return 0;
+}
+
+static void rmds_mqtt_event_handler(void *handler_args,
+                                    esp_event_base_t base,
+                                    int32_t event_id,
+                                    void *event_data)
+{
+    (void)handler_args;
+    (void)base;
+
+    switch ((esp_mqtt_event_id_t)event_id) {
+    case MQTT_EVENT_CONNECTED:
+        s_mqtt_connected = true;
+        ESP_LOGI(MQTT_TAG, "Connected to broker");
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        // Session is persistent: the outbox is resent after reconnect
+        s_mqtt_connected = false;
+        ESP_LOGW(MQTT_TAG, "Disconnected from broker");
+        break;
+    case MQTT_EVENT_PUBLISHED:   // PUBACK received
+        rmds_uplink_delivered(1, true);
+        xSemaphoreGive(s_inflight_window);
+        break;
+    case MQTT_EVENT_DELETED:     // expired from the outbox without an ack
+        ESP_LOGW(MQTT_TAG, "Publish %d expired without an ack",
+                 ((esp_mqtt_event_handle_t)event_data)->msg_id);
+        rmds_uplink_delivered(1, false);
+        xSemaphoreGive(s_inflight_window);
+        break;
+    default:
+        break;
+    }
+}
+
+static esp_err_t rmds_mqtt_start(void)
+{
+    uint8_t mac[6];
+    char client_id[24];
+
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(client_id, sizeof(client_id), "rmds-gw-%02x%02x%02x", mac[3], mac[4], mac[5]);
+
+    s_inflight_window = xSemaphoreCreateCounting(RMDS_MQTT_MAX_INFLIGHT, RMDS_MQTT_MAX_INFLIGHT);
+    if (!s_inflight_window) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_mqtt_client_config_t cfg = {
+        .broker.address.uri = RMDS_MQTT_BROKER_URI,
+        .credentials.client_id = client_id,
+        .session.disable_clean_session = true,
+        .session.keepalive = RMDS_MQTT_KEEPALIVE_S,
+    };
+
+    s_mqtt_client = esp_mqtt_client_init(&cfg);
+    if (!s_mqtt_client) {
+        return ESP_FAIL;
+    }
+
+    esp_mqtt_client_register_event(s_mqtt_client, ESP_EVENT_ANY_ID,
+                                   rmds_mqtt_event_handler, NULL);
+
+    ESP_LOGI(MQTT_TAG, "Connecting to %s as %s", RMDS_MQTT_BROKER_URI, client_id);
+    return esp_mqtt_client_start(s_mqtt_client);
+}
+
+// Publishes can be queued while the broker reconnects, as long as Wi-Fi is up
+static bool rmds_mqtt_ready(void)
+{
+    return s_mqtt_client != NULL && rmds_wifi_is_connected();
+}
+
+// PUBLISH (fixed header + topic + packet id + payload) plus the PUBACK
+static size_t rmds_mqtt_wire_bytes(size_t topic_len, size_t payload_len)
+{
+    size_t remaining = 2 + topic_len + 2 + payload_len;
+    size_t len_bytes = remaining < 128 ? 1 : (remaining < 16384 ? 2 : 3);
+    return 1 + len_bytes + remaining + 4;
+}
+
+// Readings come back through rmds_uplink_delivered() once acked or
+// expired; the ones not queued here are reported failed right away
+static esp_err_t rmds_mqtt_send_batch(const rmds_reading_t *batch, size_t count,
+                                      size_t *wire_bytes)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const rmds_reading_t *r = &batch[i];
+
+        char topic[48];
+        int topic_len = snprintf(topic, sizeof(topic), RMDS_MQTT_TOPIC_PREFIX "/%08lx/reading",
+                                 (unsigned long)r->node);
+
+        rmds_mqtt_payload_t payload = { .len = 0 };
+        rmds_json_writer_t w;
+        rmds_json_init(&w, rmds_mqtt_payload_sink, &payload);
+        rmds_uplink_write_reading(&w, r);
+        if (rmds_json_finish(&w) != 0) {
+            ESP_LOGE(MQTT_TAG, "Payload too large for seq=%lu", (unsigned long)r->seq);
+            rmds_uplink_delivered(count - i, false);
+            *wire_bytes = total;
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        // Wait for a free in-flight slot
+        if (xSemaphoreTake(s_inflight_window, pdMS_TO_TICKS(RMDS_MQTT_WINDOW_WAIT_MS)) != pdTRUE) {
+            ESP_LOGW(MQTT_TAG, "In-flight window full, %u readings not sent",
+                     (unsigned int)(count - i));
+            rmds_uplink_delivered(count - i, false);
+            *wire_bytes = total;
+            return ESP_ERR_TIMEOUT;
+        }
+
+        int msg_id = esp_mqtt_client_enqueue(s_mqtt_client, topic,
+                                             payload.buf, (int)payload.len,
+                                             1, 0, true);
+        if (msg_id < 0) {
+            xSemaphoreGive(s_inflight_window);
+            ESP_LOGE(MQTT_TAG, "Enqueue failed (%d) for seq=%lu", msg_id, (unsigned long)r->seq);
+            rmds_uplink_delivered(count - i, false);
+            *wire_bytes = total;
+            return ESP_FAIL;
+        }
+
+        total += rmds_mqtt_wire_bytes((size_t)topic_len, payload.len);
+    }
+
+    *wire_bytes = total;
+    return ESP_OK;
+}
+
+const rmds_uplink_backend_t rmds_uplink_mqtt = {
+    .name       = "mqtt",
+    .start      = rmds_mqtt_start,
+    .ready      = rmds_mqtt_ready,
+    .send_batch = rmds_mqtt_send_batch,
+    .acks_later = true,
+};
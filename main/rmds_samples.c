@@ -0,0 +1,124 @@
+// rmds_samples.c
+//
+// RTC-memory ring of sensor readings. The TX node samples on every wake but
+// only powers the radio when RMDS_SAMPLES_TX_EVERY_N readings have piled up,
+// then sends them all in one packet.
+
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+
+#include "rmds_samples.h"
+
+#define SAMPLES_TAG "RMDS_SAMPLES"
+
+// Everything below survives deep sleep (not a power cycle)
+RTC_DATA_ATTR static rmds_sample_t s_ring[RMDS_SAMPLES_RING_LEN];
+RTC_DATA_ATTR static uint32_t s_head = 0;      // index of the oldest sample
+RTC_DATA_ATTR static uint32_t s_count = 0;     // samples waiting to be sent
+RTC_DATA_ATTR static uint32_t s_next_seq = 0;  // sample number of the next append
+RTC_DATA_ATTR static uint32_t s_dropped = 0;   // overwritten before being sent
+
+// Batch size for this wake, set from the battery policy
+static uint32_t s_tx_every = RMDS_SAMPLES_TX_EVERY_N;
+
+// UART task appends while the LoRa task peeks/consumes
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint16_t clamp_u16(uint32_t v)
+{
+    return v > UINT16_MAX ? UINT16_MAX : (uint16_t)v;
+}
+
+void rmds_samples_append(uint32_t ppm, uint32_t faults, uint32_t temp_dK)
+{
+    rmds_sample_t s = {
+        .ppm     = ppm,
+        .faults  = clamp_u16(faults),
+        .temp_dK = clamp_u16(temp_dK),
+        .time_s  = (uint32_t)time(NULL),
+    };
+    bool dropped = false;
+
+    taskENTER_CRITICAL(&s_lock);
+    // Garbage after a brown-out: start over rather than send junk
+    if (s_head >= RMDS_SAMPLES_RING_LEN || s_count > RMDS_SAMPLES_RING_LEN) {
+        s_head = 0;
+        s_count = 0;
+    }
+    if (s_count == RMDS_SAMPLES_RING_LEN) {
+        s_head = (s_head + 1) % RMDS_SAMPLES_RING_LEN;
+        s_count--;
+        s_dropped++;
+        dropped = true;
+    }
+    s_ring[(s_head + s_count) % RMDS_SAMPLES_RING_LEN] = s;
+    s_count++;
+    s_next_seq++;
+    uint32_t count = s_count;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (dropped) {
+        ESP_LOGW(SAMPLES_TAG, "Ring full, dropped oldest sample (%lu dropped total)",
+                 (unsigned long)s_dropped);
+    }
+    ESP_LOGI(SAMPLES_TAG, "Stored sample %lu/%lu (ppm=%lu)",
+             (unsigned long)count, (unsigned long)s_tx_every, (unsigned long)ppm);
+}
+
+size_t rmds_samples_pending(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    size_t n = s_count <= RMDS_SAMPLES_RING_LEN ? s_count : 0;
+    taskEXIT_CRITICAL(&s_lock);
+    return n;
+}
+
+bool rmds_samples_tx_due(void)
+{
+    return rmds_samples_pending() >= s_tx_every;
+}
+
+void rmds_samples_set_tx_every(uint32_t n)
+{
+    if (n < 1) {
+        n = 1;
+    } else if (n > RMDS_SAMPLES_RING_LEN) {
+        n = RMDS_SAMPLES_RING_LEN;   // never let the ring overwrite unsent samples
+    }
+    s_tx_every = n;
+}
+
+size_t rmds_samples_peek(rmds_sample_t *out, size_t max, uint32_t *first_seq)
+{
+    size_t n = 0;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (s_head < RMDS_SAMPLES_RING_LEN && s_count <= RMDS_SAMPLES_RING_LEN) {
+        n = s_count < max ? s_count : max;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = s_ring[(s_head + i) % RMDS_SAMPLES_RING_LEN];
+        }
+        if (first_seq) {
+            *first_seq = s_next_seq - s_count;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    return n;
+}
+
+void rmds_samples_consume(size_t n)
+{
+    taskENTER_CRITICAL(&s_lock);
+    if (n > s_count) {
+        n = s_count;
+    }
+    s_head = (s_head + n) % RMDS_SAMPLES_RING_LEN;
+    s_count -= n;
+    taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,54 @@
+// rmds_samples.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Compact sensor reading kept in RTC memory between deep-sleep cycles.
+ * 12 bytes each, so the whole ring costs a few hundred bytes of RTC slow RAM.
+ */
+typedef struct {
+    uint32_t ppm;        // concentration
+    uint16_t faults;     // sensor fault bits
+    uint16_t temp_dK;    // sensor temperature, Kelvin * 10
+    uint32_t time_s;     // RTC wall-clock second the sample was taken
+} rmds_sample_t;
+
+// Ring capacity. When full, the oldest sample is dropped.
+#define RMDS_SAMPLES_RING_LEN   32
+
+// Default: send once this many samples are waiting (one sample per wake =
+// every Nth wake). The battery policy raises it as the cell runs down.
+#define RMDS_SAMPLES_TX_EVERY_N 6
+
+// Store one reading. Safe to call from any task.
+void rmds_samples_append(uint32_t ppm, uint32_t faults, uint32_t temp_dK);
+
+// Number of samples not yet sent
+size_t rmds_samples_pending(void);
+
+// True once enough samples are waiting to be worth powering the radio
+bool rmds_samples_tx_due(void);
+
+// Change the batch size checked by rmds_samples_tx_due() (1..RING_LEN)
+void rmds_samples_set_tx_every(uint32_t n);
+
+/**
+ * Copy up to max of the oldest pending samples into out without removing them.
+ * first_seq receives the sample sequence number of out[0]; sample numbers
+ * are monotonic across deep sleep so the gateway can spot gaps.
+ */
+size_t rmds_samples_peek(rmds_sample_t *out, size_t max, uint32_t *first_seq);
+
+// Drop the n oldest samples once they have been sent
+void rmds_samples_consume(size_t n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,225 @@
+// rmds_status.c
+//
+// Live status screen on the OLED: latest reading, LoRa sequence, link
+// quality and uplink state, one page row each. Values are formatted on
+// every poke but a row is only redrawn when its text changed, and the flush
+// service then sends just the columns that differ. After
+// RMDS_STATUS_BLANK_AFTER_MS without a change the panel is switched off.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "display.h"
+#include "energy.h"
+#include "rmds_status.h"
+
+#define STATUS_TAG          "RMDS_STATUS"
+#define STATUS_VALUE_X      (6 * DISPLAY_FONT_ADVANCE)  // after the longest label
+#define STATUS_VALUE_CHARS  ((DISPLAY_WIDTH - STATUS_VALUE_X) / DISPLAY_FONT_ADVANCE)
+
+// One row per page; row 0 is the title
+enum {
+    STATUS_ROW_PPM = 1,
+    STATUS_ROW_FAULTS,
+    STATUS_ROW_TEMP,
+    STATUS_ROW_SEQ,
+    STATUS_ROW_RSSI,
+    STATUS_ROW_SNR,
+    STATUS_ROW_UPLINK,
+    STATUS_ROWS
+};
+
+static const char *const s_labels[STATUS_ROWS] = {
+    [0]                 = "RMDS status",
+    [STATUS_ROW_PPM]    = "PPM",
+    [STATUS_ROW_FAULTS] = "FAULT",
+    [STATUS_ROW_TEMP]   = "TEMP",
+    [STATUS_ROW_SEQ]    = "SEQ",
+    [STATUS_ROW_RSSI]   = "RSSI",
+    [STATUS_ROW_SNR]    = "SNR",
+    [STATUS_ROW_UPLINK] = "UP",
+};
+
+typedef struct {
+    bool        have_reading;
+    uint32_t    ppm;
+    uint32_t    faults;
+    uint32_t    temp_dK;
+
+    bool        have_seq;
+    uint32_t    seq;
+
+    bool        have_link;
+    int         rssi;
+    float       snr;
+
+    const char *uplink;     // backend name, NULL until the first batch
+    bool        uplink_ok;
+    uint32_t    queued;
+} status_values_t;
+
+static status_values_t s_values;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_task = NULL;
+
+// Wake the dashboard (if it is running) after a value was stored
+static void status_poke(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    TaskHandle_t task = s_task;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void rmds_status_reading(uint32_t ppm, uint32_t faults, uint32_t temp_dK)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_values.have_reading = true;
+    s_values.ppm = ppm;
+    s_values.faults = faults;
+    s_values.temp_dK = temp_dK;
+    taskEXIT_CRITICAL(&s_lock);
+    status_poke();
+}
+
+void rmds_status_lora_seq(uint32_t seq)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_values.have_seq = true;
+    s_values.seq = seq;
+    taskEXIT_CRITICAL(&s_lock);
+    status_poke();
+}
+
+void rmds_status_link(int rssi, float snr)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_values.have_link = true;
+    s_values.rssi = rssi;
+    s_values.snr = snr;
+    taskEXIT_CRITICAL(&s_lock);
+    status_poke();
+}
+
+void rmds_status_uplink(const char *backend, bool ok, uint32_t queued)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_values.uplink = backend;
+    s_values.uplink_ok = ok;
+    s_values.queued = queued;
+    taskEXIT_CRITICAL(&s_lock);
+    status_poke();
+}
+
+// Value column of every row; "--" until something was reported
+static void status_format(const status_values_t *v, char text[STATUS_ROWS][STATUS_VALUE_CHARS + 1])
+{
+    const size_t size = STATUS_VALUE_CHARS + 1;
+
+    for (int row = 1; row < STATUS_ROWS; row++) {
+        strcpy(text[row], "--");
+    }
+
+    if (v->have_reading) {
+        snprintf(text[STATUS_ROW_PPM], size, "%lu", (unsigned long)v->ppm);
+        if (v->faults) {
+            snprintf(text[STATUS_ROW_FAULTS], size, "0x%lX", (unsigned long)v->faults);
+        } else {
+            strcpy(text[STATUS_ROW_FAULTS], "none");
+        }
+        snprintf(text[STATUS_ROW_TEMP], size, "%lu.%lu K",
+                 (unsigned long)(v->temp_dK / 10), (unsigned long)(v->temp_dK % 10));
+    }
+    if (v->have_seq) {
+        snprintf(text[STATUS_ROW_SEQ], size, "%lu", (unsigned long)v->seq);
+    }
+    if (v->have_link) {
+        snprintf(text[STATUS_ROW_RSSI], size, "%d dBm", v->rssi);
+        snprintf(text[STATUS_ROW_SNR], size, "%.1f dB", v->snr);
+    }
+    if (v->uplink != NULL) {
+        snprintf(text[STATUS_ROW_UPLINK], size, "%s %s q%lu", v->uplink,
+                 v->uplink_ok ? "ok" : "FAIL", (unsigned long)v->queued);
+    }
+}
+
+static void status_set_power(bool on)
+{
+    esp_err_t err = display_set_power(on);
+    if (err == ESP_OK) {
+        energy_set_state(ENERGY_OLED, on ? ENERGY_OLED_ON : ENERGY_OLED_OFF);
+    } else if (err != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(STATUS_TAG, "Panel %s failed: %s", on ? "on" : "off", esp_err_to_name(err));
+    }
+}
+
+void rmds_status_run(void)
+{
+    static char shown[STATUS_ROWS][STATUS_VALUE_CHARS + 1];
+    static char text[STATUS_ROWS][STATUS_VALUE_CHARS + 1];
+    const TickType_t blank_after = pdMS_TO_TICKS(RMDS_STATUS_BLANK_AFTER_MS);
+
+    taskENTER_CRITICAL(&s_lock);
+    s_task = xTaskGetCurrentTaskHandle();
+    taskEXIT_CRITICAL(&s_lock);
+
+    // Labels once; from here on only value cells are touched
+    uint8_t *fb = display_begin_frame();
+    display_clear(fb);
+    for (int row = 0; row < STATUS_ROWS; row++) {
+        display_text_page(fb, 0, row, s_labels[row]);
+    }
+    display_submit();
+    ESP_LOGI(STATUS_TAG, "Dashboard up, panel off after %d s idle",
+             RMDS_STATUS_BLANK_AFTER_MS / 1000);
+
+    TickType_t last_change = xTaskGetTickCount();
+    bool blank = false;
+
+    while (1) {
+        taskENTER_CRITICAL(&s_lock);
+        status_values_t v = s_values;
+        taskEXIT_CRITICAL(&s_lock);
+        status_format(&v, text);
+
+        fb = NULL;
+        for (int row = 1; row < STATUS_ROWS; row++) {
+            if (strcmp(text[row], shown[row]) == 0) {
+                continue;
+            }
+            if (fb == NULL) {
+                fb = display_begin_update();
+            }
+            // Opaque cells overwrite the old value; blank whatever it
+            // had beyond the new one
+            int x = display_text_page(fb, STATUS_VALUE_X, row, text[row]);
+            display_fill_rect(fb, x, row * 8, DISPLAY_WIDTH - x, 8, false);
+            strcpy(shown[row], text[row]);
+        }
+
+        if (fb != NULL) {
+            display_submit();
+            last_change = xTaskGetTickCount();
+            if (blank) {
+                status_set_power(true);
+                blank = false;
+            }
+        }
+
+        TickType_t idle = xTaskGetTickCount() - last_change;
+        if (!blank && idle >= blank_after) {
+            ESP_LOGI(STATUS_TAG, "No change for %d s, panel off", RMDS_STATUS_BLANK_AFTER_MS / 1000);
+            status_set_power(false);
+            blank = true;
+        }
+        ulTaskNotifyTake(pdTRUE, blank ? portMAX_DELAY : blank_after - idle);
+    }
+}
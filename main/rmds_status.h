@@ -0,0 +1,30 @@
+// rmds_status.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Panel goes dark when no value has changed for this long; the next change
+// turns it back on
+#define RMDS_STATUS_BLANK_AFTER_MS  60000
+
+/**
+ * Run the status dashboard on the calling task. The display service must
+ * already be started (display_start()). Never returns.
+ */
+void rmds_status_run(void);
+
+// Recorders: keep the latest value and poke the dashboard. Cheap enough for
+// the UART, LoRa and uplink paths; nothing is drawn on the caller's task.
+void rmds_status_reading(uint32_t ppm, uint32_t faults, uint32_t temp_dK);
+void rmds_status_lora_seq(uint32_t seq);
+void rmds_status_link(int rssi, float snr);
+void rmds_status_uplink(const char *backend, bool ok, uint32_t queued);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,246 @@
+// rmds_uplink.c
+//
+// Backend-independent part of the cloud uplink: queueing, batching and
+// throughput stats. The backend is picked at build time.
+
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+
+#include "power.h"
+#include "rmds_metrics.h"
+#include "rmds_status.h"
+#include "rmds_uplink.h"
+
+#define UPLINK_TAG "RMDS_UPLINK"
+
+// 1: publish over MQTT, 0: HTTP Data API
+#define RMDS_UPLINK_USE_MQTT        0
+
+// Readings wait up to the window for company
+#define RMDS_UPLINK_QUEUE_LEN       32
+#define RMDS_UPLINK_BATCH_MAX       16
+#define RMDS_UPLINK_BATCH_WINDOW_MS 2000
+
+// Print throughput stats every N batches
+#define RMDS_UPLINK_STATS_EVERY     10
+
+#if RMDS_UPLINK_USE_MQTT
+static const rmds_uplink_backend_t *const s_backend = &rmds_uplink_mqtt;
+#else
+static const rmds_uplink_backend_t *const s_backend = &rmds_uplink_http;
+#endif
+
+static QueueHandle_t s_uplink_queue = NULL;
+
+// Full CPU clock while a batch is encoded/compressed and pushed out over Wi-Fi
+static esp_pm_lock_handle_t s_uplink_pm_lock = NULL;
+
+// Throughput since boot, for comparing backends. Readings are counted once
+// delivered, which for MQTT is on the broker's ack in the client's task.
+static uint32_t     s_batches;
+static atomic_uint  s_readings_sent;
+static atomic_uint  s_readings_failed;
+static uint64_t     s_wire_bytes;
+static int64_t      s_busy_us;         // inside send_batch
+static int64_t      s_first_send_us;   // start of the first send_batch
+static atomic_llong s_last_ack_us;     // latest ack of an acks_later backend
+
+void rmds_uplink_write_reading(rmds_json_writer_t *w, const rmds_reading_t *r)
+{
+    rmds_json_begin_object(w);
+    rmds_json_kv_uint(w, "node", r->node);
+    rmds_json_kv_uint(w, "seq", r->seq);
+    rmds_json_kv_uint(w, "ppm", r->ppm);
+    rmds_json_kv_uint(w, "faults", r->faults);
+    rmds_json_kv_fixed(w, "temp_K", (int32_t)r->temp_dK, 1);
+    rmds_json_kv_uint(w, "age_s", r->age_s);
+    if (r->battery_mv) {
+        rmds_json_kv_uint(w, "bat_mv", r->battery_mv);
+    }
+    rmds_json_kv_int(w, "rssi", r->rssi);
+    rmds_json_kv_fixed(w, "snr", (int32_t)lroundf(r->snr * 100.0f), 2);
+    rmds_json_kv_uint64(w, "gw_time_ms", (uint64_t)r->gw_time_ms);
+    rmds_json_end_object(w);
+}
+
+void rmds_uplink_delivered(uint32_t readings, bool ok)
+{
+    atomic_fetch_add_explicit(ok ? &s_readings_sent : &s_readings_failed,
+                              readings, memory_order_relaxed);
+    if (ok) {
+        atomic_store_explicit(&s_last_ack_us, esp_timer_get_time(), memory_order_relaxed);
+    }
+    rmds_metrics_readings(readings, ok);
+}
+
+// Delivered readings per second. HTTP delivers inside send_batch, so that
+// is the time to divide by; an MQTT reading is only delivered on its
+// PUBACK, after send_batch has returned, so there it is the time from the
+// first publish to the latest ack.
+static uint64_t rmds_uplink_msg_per_s(uint32_t sent)
+{
+    int64_t span_us = s_backend->acks_later
+        ? atomic_load_explicit(&s_last_ack_us, memory_order_relaxed) - s_first_send_us
+        : s_busy_us;
+    return span_us > 0 ? (uint64_t)sent * 1000000 / (uint64_t)span_us : 0;
+}
+
+static void rmds_uplink_log_stats(void)
+{
+    uint32_t sent = atomic_load_explicit(&s_readings_sent, memory_order_relaxed);
+
+    ESP_LOGI(UPLINK_TAG,
+             "%s: %lu readings in %lu batches, %llu msg/s, %llu bytes/reading, %lu failed",
+             s_backend->name,
+             (unsigned long)sent,
+             (unsigned long)s_batches,
+             (unsigned long long)rmds_uplink_msg_per_s(sent),
+             (unsigned long long)(sent ? s_wire_bytes / sent : 0),
+             (unsigned long)atomic_load_explicit(&s_readings_failed, memory_order_relaxed));
+}
+
+static void rmds_uplink_send(const rmds_reading_t *batch, size_t count)
+{
+    if (!s_backend->ready()) {
+        ESP_LOGW(UPLINK_TAG, "%s not ready, dropping %u readings",
+                 s_backend->name, (unsigned int)count);
+        atomic_fetch_add_explicit(&s_readings_failed, count, memory_order_relaxed);
+        rmds_metrics_upload(count, false, 0);
+        rmds_status_uplink(s_backend->name, false, rmds_uplink_queue_depth());
+        return;
+    }
+
+    size_t wire_bytes = 0;
+    if (s_uplink_pm_lock) {
+        esp_pm_lock_acquire(s_uplink_pm_lock);
+    }
+    int64_t t0 = esp_timer_get_time();
+    if (s_first_send_us == 0) {
+        s_first_send_us = t0;
+    }
+    esp_err_t err = s_backend->send_batch(batch, count, &wire_bytes);
+    int64_t elapsed_us = esp_timer_get_time() - t0;
+    if (s_uplink_pm_lock) {
+        esp_pm_lock_release(s_uplink_pm_lock);
+    }
+    s_busy_us += elapsed_us;
+    s_wire_bytes += wire_bytes;
+    // Readings still in flight are counted when the backend hears about them
+    rmds_metrics_upload(s_backend->acks_later ? 0 : count, err == ESP_OK, elapsed_us);
+    rmds_status_uplink(s_backend->name, err == ESP_OK, rmds_uplink_queue_depth());
+
+    s_batches++;
+    if (!s_backend->acks_later) {
+        atomic_fetch_add_explicit(err == ESP_OK ? &s_readings_sent : &s_readings_failed,
+                                  count, memory_order_relaxed);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(UPLINK_TAG, "%s: batch of %u failed: %s",
+                 s_backend->name, (unsigned int)count, esp_err_to_name(err));
+    }
+
+    if (s_batches % RMDS_UPLINK_STATS_EVERY == 0) {
+        rmds_uplink_log_stats();
+    }
+}
+
+// Collects readings into batches so the radio task never waits on the network
+static void rmds_uplink_task(void *pvParameters)
+{
+    (void)pvParameters;
+    static rmds_reading_t batch[RMDS_UPLINK_BATCH_MAX];
+
+    while (1) {
+        size_t count = 0;
+        xQueueReceive(s_uplink_queue, &batch[count++], portMAX_DELAY);
+
+        TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(RMDS_UPLINK_BATCH_WINDOW_MS);
+        while (count < RMDS_UPLINK_BATCH_MAX) {
+            TickType_t now = xTaskGetTickCount();
+            if ((int32_t)(deadline - now) <= 0 ||
+                xQueueReceive(s_uplink_queue, &batch[count], deadline - now) != pdTRUE) {
+                break;
+            }
+            count++;
+        }
+
+        rmds_uplink_send(batch, count);
+
+        if (uxQueueMessagesWaiting(s_uplink_queue) == 0) {
+            power_hold_release(POWER_HOLD_UPLINK);
+        }
+    }
+}
+
+void rmds_uplink_start(void)
+{
+    if (s_uplink_queue) {
+        return;
+    }
+
+    if (s_backend->start) {
+        esp_err_t err = s_backend->start();
+        if (err != ESP_OK) {
+            ESP_LOGE(UPLINK_TAG, "%s backend start failed: %s",
+                     s_backend->name, esp_err_to_name(err));
+        }
+    }
+
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "uplink", &s_uplink_pm_lock) != ESP_OK) {
+        s_uplink_pm_lock = NULL;   // PM disabled: nothing to hold
+    }
+
+    s_uplink_queue = xQueueCreate(RMDS_UPLINK_QUEUE_LEN, sizeof(rmds_reading_t));
+    if (!s_uplink_queue) {
+        ESP_LOGE(UPLINK_TAG, "Failed to create uplink queue");
+        return;
+    }
+
+    TaskHandle_t task = NULL;
+    BaseType_t ok = xTaskCreate(rmds_uplink_task,
+                                "rmds_uplink_task",
+                                8192,
+                                NULL,
+                                4,
+                                &task);
+    if (ok != pdPASS) {
+        ESP_LOGE(UPLINK_TAG, "Failed to create rmds_uplink_task");
+        return;
+    }
+    rmds_metrics_register_task(task);
+
+    ESP_LOGI(UPLINK_TAG, "Uplink started (%s backend)", s_backend->name);
+}
+
+uint32_t rmds_uplink_queue_depth(void)
+{
+    return s_uplink_queue ? (uint32_t)uxQueueMessagesWaiting(s_uplink_queue) : 0;
+}
+
+// Queue one reading for upload. Never blocks the caller.
+void send_frame_to_cloud(const rmds_reading_t *reading)
+{
+    if (!reading) {
+        ESP_LOGW(UPLINK_TAG, "send_frame_to_cloud: no reading, skipping");
+        return;
+    }
+    if (!s_uplink_queue) {
+        ESP_LOGW(UPLINK_TAG, "send_frame_to_cloud: uplink not started, dropping seq=%lu",
+                 (unsigned long)reading->seq);
+        return;
+    }
+    power_hold_acquire(POWER_HOLD_UPLINK);
+    if (xQueueSend(s_uplink_queue, reading, 0) != pdTRUE) {
+        ESP_LOGW(UPLINK_TAG, "send_frame_to_cloud: uplink queue full, dropping seq=%lu",
+                 (unsigned long)reading->seq);
+    }
+}
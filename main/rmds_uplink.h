@@ -0,0 +1,74 @@
+// rmds_uplink.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#include "rmds_frame.h"
+#include "rmds_json.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A way of getting readings off the gateway. The uplink task batches
+ * readings and hands them to exactly one backend.
+ */
+typedef struct {
+    const char *name;
+
+    // Open the session (may be NULL if there is nothing to set up)
+    esp_err_t (*start)(void);
+
+    // True when a batch can be sent right now
+    bool (*ready)(void);
+
+    // Send or queue a batch. *wire_bytes gets the bytes this cost on the wire.
+    esp_err_t (*send_batch)(const rmds_reading_t *batch, size_t count, size_t *wire_bytes);
+
+    // True if readings are only known to be delivered after send_batch
+    // returns. Such a backend reports every reading of a batch, the ones it
+    // couldn't queue included, through rmds_uplink_delivered().
+    bool acks_later;
+} rmds_uplink_backend_t;
+
+// HTTP Data API backend (rmds_wifi.c)
+extern const rmds_uplink_backend_t rmds_uplink_http;
+
+// MQTT backend with one persistent session (rmds_mqtt.c)
+extern const rmds_uplink_backend_t rmds_uplink_mqtt;
+
+/**
+ * Start the selected backend and the uplink task.
+ * Call after rmds_wifi_init().
+ */
+void rmds_uplink_start(void);
+
+/**
+ * Queue a single decoded LoRa reading for the cloud backend.
+ * Readings are batched and sent by the uplink task; this never blocks.
+ */
+void send_frame_to_cloud(const rmds_reading_t *reading);
+
+/**
+ * Readings currently waiting in the uplink queue.
+ */
+uint32_t rmds_uplink_queue_depth(void);
+
+/**
+ * Count readings of an acks_later backend as delivered (ok) or lost.
+ * Safe to call from any task.
+ */
+void rmds_uplink_delivered(uint32_t readings, bool ok);
+
+/**
+ * Write one reading as a JSON object (shared by the backends).
+ */
+void rmds_uplink_write_reading(rmds_json_writer_t *w, const rmds_reading_t *r);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,18 +2,28 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_netif.h"
+#include "esp_netif_net_stack.h"
+#include "lwip/dhcp.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 #include "esp_http_client.h"
 
+#include "energy.h"
+#include "rmds_deflate.h"
+#include "rmds_json.h"
+#include "rmds_uplink.h"
 #include "rmds_wifi.h"
 
 #define WIFI_TAG "RMDS_WIFI"
@@ -22,10 +32,37 @@
 #define RMDS_WIFI_SSID     "UMBC Visitor"
 #define RMDS_WIFI_PASS     ""
 
-// MongoDB Atlas Data API endpoint
-#define RMDS_CLOUD_URL     "https://data.mongodb-api.com/app/<APP_ID>/endpoint/data/v1/action/insertOne"
+// Optional static IP config. Leave RMDS_WIFI_STATIC_IP empty to use DHCP
+// (and the cached lease on fast reconnects).
+#define RMDS_WIFI_STATIC_IP      ""
+#define RMDS_WIFI_STATIC_NETMASK "255.255.255.0"
+#define RMDS_WIFI_STATIC_GW      ""
+#define RMDS_WIFI_STATIC_DNS     ""
+
+// Reuse the last DHCP lease on fast reconnects (skips the DHCP exchange)
+#define RMDS_WIFI_REUSE_LEASE    1
+
+// Lease length to assume when the server's isn't known (or is infinite)
+#define RMDS_WIFI_LEASE_DEFAULT_S 3600
+
+// How long the fast path may take before we fall back to a full connect
+#define RMDS_WIFI_FAST_TIMEOUT_MS 3000
+
+// MongoDB Atlas Data API endpoint (point at a local stand-in to test uploads)
+#define RMDS_CLOUD_URL     "https://data.mongodb-api.com/app/<APP_ID>/endpoint/data/v1/action/insertMany"
 #define RMDS_CLOUD_API_KEY "<YOUR_DATA_API_KEY>"
 
+#define RMDS_CLOUD_DATA_SOURCE "Cluster0"
+#define RMDS_CLOUD_DATABASE    "class_project_db"
+#define RMDS_CLOUD_COLLECTION  "myCollection"
+
+// 1: gzip upload bodies (Content-Encoding: gzip). Costs ~5 KB static RAM
+// and some CPU per batch, saves most of the bytes on the wire.
+#define RMDS_UPLOAD_GZIP            0
+
+// Largest HTTP chunk written in one go
+#define RMDS_HTTP_CHUNK_MAX         256
+
 // Event bits
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
@@ -34,6 +71,263 @@ static EventGroupHandle_t s_wifi_event_group;
 static int s_retry_num = 0;
 static const int MAX_RETRY = 5;
 
+static esp_netif_t *s_sta_netif = NULL;
+
+#if RMDS_UPLOAD_GZIP
+static rmds_deflate_t s_deflate;   // fixed compressor budget, one upload at a time
+#endif
+
+//  AP / lease cache
+//
+// Kept in RTC memory so deep-sleep wakes can skip the scan and DHCP, and
+// mirrored to NVS so a cold boot can at least skip the scan.
+#define RMDS_WIFI_CACHE_MAGIC  0x52574332u   // "RWC2"
+#define RMDS_WIFI_NVS_NS       "rmds_wifi"
+#define RMDS_WIFI_NVS_KEY      "ap_cache"
+
+typedef struct {
+    uint32_t magic;
+    char     ssid[33];
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    uint8_t  have_lease;
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t dns;
+    uint32_t lease_renew_s;   // wall clock (s) at which the lease is due to renew (T1)
+} rmds_wifi_cache_t;
+
+// Connect latency per path, accumulated across deep sleep
+typedef struct {
+    uint32_t count;
+    uint64_t total_us;
+} rmds_wifi_latency_t;
+
+RTC_DATA_ATTR static rmds_wifi_cache_t   s_wifi_cache;
+RTC_DATA_ATTR static rmds_wifi_latency_t s_fast_latency;
+RTC_DATA_ATTR static rmds_wifi_latency_t s_full_latency;
+
+// Only while rmds_wifi_init() waits for its connect: later (runtime)
+// disconnects take the normal retry path and aren't timed
+static bool    s_connecting = false;
+static bool    s_fast_path = false;
+static int64_t s_connect_start_us = 0;
+
+// The cached lease is applied with DHCP stopped; this timer starts DHCP
+// again when the lease is due to renew
+static bool               s_lease_from_cache = false;
+static esp_timer_handle_t s_renew_timer = NULL;
+
+static bool rmds_wifi_cache_valid(const rmds_wifi_cache_t *c)
+{
+    return c->magic == RMDS_WIFI_CACHE_MAGIC &&
+           c->channel != 0 &&
+           strncmp(c->ssid, RMDS_WIFI_SSID, sizeof(c->ssid)) == 0;
+}
+
+static void rmds_wifi_cache_load(void)
+{
+    if (rmds_wifi_cache_valid(&s_wifi_cache)) {
+        return;  // survived deep sleep
+    }
+
+    nvs_handle_t nvs;
+    if (nvs_open(RMDS_WIFI_NVS_NS, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    size_t len = sizeof(s_wifi_cache);
+    if (nvs_get_blob(nvs, RMDS_WIFI_NVS_KEY, &s_wifi_cache, &len) != ESP_OK ||
+        len != sizeof(s_wifi_cache)) {
+        memset(&s_wifi_cache, 0, sizeof(s_wifi_cache));
+    }
+    nvs_close(nvs);
+
+    // The wall clock starts again from zero after a power cut, so a lease
+    // from flash can't be aged: keep the AP, ask DHCP for the address
+    s_wifi_cache.have_lease = 0;
+}
+
+// Cached lease not yet due for renewal?
+static bool rmds_wifi_lease_fresh(const rmds_wifi_cache_t *c)
+{
+    return c->have_lease && (uint32_t)time(NULL) < c->lease_renew_s;
+}
+
+// Length of the lease DHCP just got us, in seconds
+static uint32_t rmds_wifi_lease_time_s(void)
+{
+    // Set by lwIP when the ACK arrives; one word, safe to read from here
+    struct netif *lwip_netif = esp_netif_get_netif_impl(s_sta_netif);
+    struct dhcp *dhcp = lwip_netif ? netif_dhcp_data(lwip_netif) : NULL;
+    uint32_t lease = dhcp ? dhcp->offered_t0_lease : 0;
+
+    if (lease == 0 || lease == 0xFFFFFFFFu) {
+        lease = RMDS_WIFI_LEASE_DEFAULT_S;
+    }
+    return lease;
+}
+
+// Only touches flash when the AP or lease actually changed
+static void rmds_wifi_cache_store(const rmds_wifi_cache_t *c)
+{
+    if (memcmp(&s_wifi_cache, c, sizeof(*c)) == 0) {
+        return;
+    }
+    s_wifi_cache = *c;
+
+    nvs_handle_t nvs;
+    if (nvs_open(RMDS_WIFI_NVS_NS, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_blob(nvs, RMDS_WIFI_NVS_KEY, c, sizeof(*c)) == ESP_OK) {
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+}
+
+static void rmds_wifi_cache_invalidate(void)
+{
+    rmds_wifi_cache_t empty = { 0 };
+    rmds_wifi_cache_store(&empty);
+}
+
+static bool rmds_wifi_has_static_ip(void)
+{
+    return strlen(RMDS_WIFI_STATIC_IP) > 0;
+}
+
+// Stop DHCP and apply a fixed address. Returns false if nothing to apply.
+static bool rmds_wifi_apply_ip(uint32_t ip, uint32_t netmask, uint32_t gw, uint32_t dns)
+{
+    if (ip == 0) {
+        return false;
+    }
+
+    esp_err_t err = esp_netif_dhcpc_stop(s_sta_netif);
+    if (err != ESP_OK && err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED) {
+        ESP_LOGW(WIFI_TAG, "dhcpc_stop failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    esp_netif_ip_info_t info = {
+        .ip.addr      = ip,
+        .netmask.addr = netmask,
+        .gw.addr      = gw,
+    };
+    if (esp_netif_set_ip_info(s_sta_netif, &info) != ESP_OK) {
+        esp_netif_dhcpc_start(s_sta_netif);
+        return false;
+    }
+
+    if (dns != 0) {
+        esp_netif_dns_info_t dns_info = { 0 };
+        dns_info.ip.type = ESP_IPADDR_TYPE_V4;
+        dns_info.ip.u_addr.ip4.addr = dns;
+        esp_netif_set_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns_info);
+    }
+    return true;
+}
+
+static bool rmds_wifi_apply_static_ip(void)
+{
+    if (!rmds_wifi_has_static_ip()) {
+        return false;
+    }
+    return rmds_wifi_apply_ip(esp_ip4addr_aton(RMDS_WIFI_STATIC_IP),
+                              esp_ip4addr_aton(RMDS_WIFI_STATIC_NETMASK),
+                              esp_ip4addr_aton(RMDS_WIFI_STATIC_GW),
+                              strlen(RMDS_WIFI_STATIC_DNS) > 0
+                                  ? esp_ip4addr_aton(RMDS_WIFI_STATIC_DNS) : 0);
+}
+
+static void rmds_wifi_record_latency(void)
+{
+    int64_t elapsed_us = esp_timer_get_time() - s_connect_start_us;
+    rmds_wifi_latency_t *stat = s_fast_path ? &s_fast_latency : &s_full_latency;
+
+    stat->count++;
+    stat->total_us += (uint64_t)elapsed_us;
+
+    ESP_LOGI(WIFI_TAG,
+             "Connected via %s path in %lld ms (avg fast=%llu ms over %lu, full=%llu ms over %lu)",
+             s_fast_path ? "fast" : "full",
+             (long long)(elapsed_us / 1000),
+             (unsigned long long)(s_fast_latency.count ? s_fast_latency.total_us / s_fast_latency.count / 1000 : 0),
+             (unsigned long)s_fast_latency.count,
+             (unsigned long long)(s_full_latency.count ? s_full_latency.total_us / s_full_latency.count / 1000 : 0),
+             (unsigned long)s_full_latency.count);
+}
+
+// Remember the AP (and lease) we just got onto
+static void rmds_wifi_remember_connection(const ip_event_got_ip_t *got_ip)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+
+    rmds_wifi_cache_t c = { 0 };
+    c.magic = RMDS_WIFI_CACHE_MAGIC;
+    snprintf(c.ssid, sizeof(c.ssid), "%s", RMDS_WIFI_SSID);
+    memcpy(c.bssid, ap.bssid, sizeof(c.bssid));
+    c.channel = ap.primary;
+
+    if (s_lease_from_cache) {
+        // Still the cached lease, not a new one: keep its renewal time
+        c.have_lease    = 1;
+        c.ip            = s_wifi_cache.ip;
+        c.netmask       = s_wifi_cache.netmask;
+        c.gw            = s_wifi_cache.gw;
+        c.dns           = s_wifi_cache.dns;
+        c.lease_renew_s = s_wifi_cache.lease_renew_s;
+    } else if (RMDS_WIFI_REUSE_LEASE && !rmds_wifi_has_static_ip()) {
+        esp_netif_dns_info_t dns_info = { 0 };
+        esp_netif_get_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns_info);
+
+        c.have_lease = 1;
+        c.ip      = got_ip->ip_info.ip.addr;
+        c.netmask = got_ip->ip_info.netmask.addr;
+        c.gw      = got_ip->ip_info.gw.addr;
+        c.dns     = dns_info.ip.u_addr.ip4.addr;
+        // Reuse it until T1, half the lease, when DHCP itself would renew
+        c.lease_renew_s = (uint32_t)time(NULL) + rmds_wifi_lease_time_s() / 2;
+    }
+
+    rmds_wifi_cache_store(&c);
+}
+
+// Lease renewal due: hand the address back to DHCP, whose ACK arrives as a
+// new GOT_IP and is remembered with its own lease
+static void rmds_wifi_renew_lease(void *arg)
+{
+    (void)arg;
+    ESP_LOGI(WIFI_TAG, "Cached lease due for renewal, starting DHCP");
+    s_lease_from_cache = false;
+    esp_netif_dhcpc_start(s_sta_netif);
+}
+
+// Running on the cached lease: start DHCP when it is due to renew
+static void rmds_wifi_schedule_renewal(void)
+{
+    uint32_t now = (uint32_t)time(NULL);
+    uint32_t left_s = s_wifi_cache.lease_renew_s > now ? s_wifi_cache.lease_renew_s - now : 0;
+
+    if (!s_renew_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = rmds_wifi_renew_lease,
+            .name     = "wifi_renew",
+        };
+        if (esp_timer_create(&args, &s_renew_timer) != ESP_OK) {
+            rmds_wifi_renew_lease(NULL);
+            return;
+        }
+    }
+    esp_timer_stop(s_renew_timer);
+    esp_timer_start_once(s_renew_timer, (uint64_t)left_s * 1000000);
+    ESP_LOGI(WIFI_TAG, "Using cached lease, DHCP restarts in %lu s", (unsigned long)left_s);
+}
+
 // Wi-Fi event handler
 static void wifi_event_handler(void *arg,
                                esp_event_base_t event_base,
@@ -41,10 +335,17 @@ static void wifi_event_handler(void *arg,
                                void *event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        energy_set_state(ENERGY_WIFI, ENERGY_WIFI_ON);
         esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_STOP) {
+        energy_set_state(ENERGY_WIFI, ENERGY_WIFI_OFF);
     } else if (event_base == WIFI_EVENT &&
                event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < MAX_RETRY) {
+        xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        if (s_fast_path) {
+            // Cached AP is gone or moved; let rmds_wifi_init() do a full connect
+            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+        } else if (s_retry_num < MAX_RETRY) {
             esp_wifi_connect();
             s_retry_num++;
             ESP_LOGW(WIFI_TAG, "Retrying Wi-Fi connection (%d/%d)",
@@ -56,6 +357,10 @@ static void wifi_event_handler(void *arg,
                event_id == IP_EVENT_STA_GOT_IP) {
         ESP_LOGI(WIFI_TAG, "Got IP address");
         s_retry_num = 0;
+        if (s_connecting) {
+            rmds_wifi_record_latency();
+        }
+        rmds_wifi_remember_connection((const ip_event_got_ip_t *)event_data);
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
@@ -77,7 +382,7 @@ void rmds_wifi_init(void)
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    s_sta_netif = esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -106,22 +411,86 @@ void rmds_wifi_init(void)
 
     wifi_config.sta.threshold.authmode = WIFI_AUTH_OPEN;
 
+    // Fast path: go straight to the cached BSSID/channel, and skip DHCP if
+    // we have a static IP or a cached lease not yet due for renewal.
+    rmds_wifi_cache_load();
+    bool static_ip = rmds_wifi_apply_static_ip();
+    s_fast_path = rmds_wifi_cache_valid(&s_wifi_cache);
+
+    if (s_fast_path) {
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, s_wifi_cache.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = s_wifi_cache.channel;
+
+        // An expired lease is left to DHCP
+        if (!static_ip && rmds_wifi_lease_fresh(&s_wifi_cache)) {
+            s_lease_from_cache = rmds_wifi_apply_ip(s_wifi_cache.ip, s_wifi_cache.netmask,
+                                                    s_wifi_cache.gw, s_wifi_cache.dns);
+        }
+    }
+
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+
+    s_connecting = true;
+    s_connect_start_us = esp_timer_get_time();
     ESP_ERROR_CHECK(esp_wifi_start());
 
     ESP_LOGI(WIFI_TAG,
-             "Wi-Fi init done. Connecting to SSID \"%s\"...",
-             RMDS_WIFI_SSID);
+             "Wi-Fi init done. Connecting to SSID \"%s\" (%s)...",
+             RMDS_WIFI_SSID,
+             s_fast_path ? "cached BSSID/channel" : "full scan");
 
     EventBits_t bits = xEventGroupWaitBits(
         s_wifi_event_group,
         WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
         pdFALSE,
         pdFALSE,
-        portMAX_DELAY);
+        s_fast_path ? pdMS_TO_TICKS(RMDS_WIFI_FAST_TIMEOUT_MS) : portMAX_DELAY);
+
+    if (s_fast_path && !(bits & WIFI_CONNECTED_BIT)) {
+        ESP_LOGW(WIFI_TAG, "Fast reconnect failed, falling back to full scan%s",
+                 static_ip ? "" : " + DHCP");
+
+        s_fast_path = false;
+        s_lease_from_cache = false;
+        rmds_wifi_cache_invalidate();
+
+        wifi_config.sta.bssid_set = false;
+        memset(wifi_config.sta.bssid, 0, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = 0;
+        ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+
+        if (!static_ip) {
+            esp_netif_dhcpc_start(s_sta_netif);
+        }
+
+        s_retry_num = 0;
+        xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
+        s_connect_start_us = esp_timer_get_time();
+
+        if (bits & WIFI_FAIL_BIT) {
+            esp_wifi_connect();
+        } else {
+            // Still trying the cached AP; the disconnect event reconnects
+            esp_wifi_disconnect();
+        }
+
+        bits = xEventGroupWaitBits(
+            s_wifi_event_group,
+            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
+            pdFALSE,
+            pdFALSE,
+            portMAX_DELAY);
+    }
+
+    s_connecting = false;
+    s_fast_path = false;
 
     if (bits & WIFI_CONNECTED_BIT) {
+        if (s_lease_from_cache) {
+            rmds_wifi_schedule_renewal();
+        }
         ESP_LOGI(WIFI_TAG, "Connected to Wi-Fi, ready for cloud traffic");
     } else if (bits & WIFI_FAIL_BIT) {
         ESP_LOGE(WIFI_TAG, "Failed to connect to Wi-Fi");
@@ -143,29 +512,96 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
-// Send data to MongoDB Atlas via Data API
-void send_frame_to_cloud(const char *payload)
+// Body pipeline state for one upload:
+// JSON writer -> (optional gzip) -> HTTP chunk framing -> client
+typedef struct {
+    esp_http_client_handle_t client;
+    rmds_deflate_t *z;          // NULL when sending plain JSON
+    size_t   wire_bytes;        // body bytes handed to the client
+    int64_t  io_us;             // time spent inside HTTP writes
+    int64_t  deflate_us;        // compressor CPU time (excluding I/O)
+} rmds_upload_ctx_t;
+
+// One HTTP chunk per call, framed and sent with a single write so TLS
+// emits one record per chunk.
+static int rmds_http_chunk_write(rmds_upload_ctx_t *up, const void *data, size_t len)
 {
-    if (!payload || payload[0] == '\0') {
-        ESP_LOGW(WIFI_TAG, "send_frame_to_cloud: empty payload, skipping");
-        return;
+    char chunk[RMDS_HTTP_CHUNK_MAX + 16];
+    const char *p = (const char *)data;
+    int64_t t0 = esp_timer_get_time();
+    int ret = 0;
+
+    while (len > 0 && ret == 0) {
+        size_t take = len < RMDS_HTTP_CHUNK_MAX ? len : RMDS_HTTP_CHUNK_MAX;
+
+        int n = snprintf(chunk, sizeof(chunk), "%x\r\n", (unsigned int)take);
+        memcpy(&chunk[n], p, take);
+        n += (int)take;
+        chunk[n++] = '\r';
+        chunk[n++] = '\n';
+
+        if (esp_http_client_write(up->client, chunk, n) != n) {
+            ret = -1;
+        }
+        up->wire_bytes += take;
+        p += take;
+        len -= take;
     }
 
-    // Build JSON body for MongoDB Data API
-    char json_body[512];
-    int written = snprintf(json_body, sizeof(json_body),
-                           "{"
-                           "\"collection\":\"myCollection\","
-                           "\"database\":\"class_project_db\","
-                           "\"dataSource\":\"Cluster0\","
-                           "\"document\":{\"raw\":\"%s\"}"
-                           "}",
-                           payload);
-    if (written <= 0 || written >= (int)sizeof(json_body)) {
-        ESP_LOGE(WIFI_TAG, "JSON body too long or error");
-        return;
+    up->io_us += esp_timer_get_time() - t0;
+    return ret;
+}
+
+static int rmds_deflate_to_http_sink(void *ctx, const uint8_t *data, size_t len)
+{
+    return rmds_http_chunk_write((rmds_upload_ctx_t *)ctx, data, len);
+}
+
+static int rmds_json_to_body_sink(void *ctx, const char *data, size_t len)
+{
+    rmds_upload_ctx_t *up = (rmds_upload_ctx_t *)ctx;
+
+    if (!up->z) {
+        return rmds_http_chunk_write(up, data, len);
     }
 
+    int64_t io_before = up->io_us;
+    int64_t t0 = esp_timer_get_time();
+    int ret = rmds_deflate_write(up->z, data, len);
+    up->deflate_us += (esp_timer_get_time() - t0) - (up->io_us - io_before);
+    return ret;
+}
+
+// Data API insertMany envelope around a batch of typed readings
+static void rmds_write_insert_many(rmds_json_writer_t *w,
+                                   const rmds_reading_t *batch, size_t count)
+{
+    rmds_json_begin_object(w);
+    rmds_json_kv_string(w, "collection", RMDS_CLOUD_COLLECTION);
+    rmds_json_kv_string(w, "database", RMDS_CLOUD_DATABASE);
+    rmds_json_kv_string(w, "dataSource", RMDS_CLOUD_DATA_SOURCE);
+
+    rmds_json_key(w, "documents");
+    rmds_json_begin_array(w);
+    for (size_t i = 0; i < count; ++i) {
+        rmds_uplink_write_reading(w, &batch[i]);
+    }
+    rmds_json_end_array(w);
+
+    rmds_json_end_object(w);
+}
+
+bool rmds_wifi_is_connected(void)
+{
+    return s_wifi_event_group &&
+           (xEventGroupGetBits(s_wifi_event_group) & WIFI_CONNECTED_BIT);
+}
+
+// Send a batch of readings to MongoDB Atlas via Data API.
+// The body is streamed straight into the request with chunked encoding.
+static esp_err_t rmds_http_send_batch(const rmds_reading_t *batch, size_t count,
+                                      size_t *wire_bytes)
+{
     esp_http_client_config_t config = {
         .url = RMDS_CLOUD_URL,
         .method = HTTP_METHOD_POST,
@@ -176,25 +612,93 @@ void send_frame_to_cloud(const char *payload)
     esp_http_client_handle_t client = esp_http_client_init(&config);
     if (!client) {
         ESP_LOGE(WIFI_TAG, "Failed to init HTTP client");
-        return;
+        return ESP_ERR_NO_MEM;
     }
 
     esp_http_client_set_header(client, "Content-Type", "application/json");
+    if (RMDS_UPLOAD_GZIP) {
+        esp_http_client_set_header(client, "Content-Encoding", "gzip");
+    }
     if (strlen(RMDS_CLOUD_API_KEY) > 0) {
         esp_http_client_set_header(client, "api-key", RMDS_CLOUD_API_KEY);
     }
 
-    esp_http_client_set_post_field(client, json_body, strlen(json_body));
+    int64_t t_start = esp_timer_get_time();
 
-    ESP_LOGI(WIFI_TAG, "Sending payload to MongoDB Atlas: %s", json_body);
+    // -1: length unknown, client adds "Transfer-Encoding: chunked"
+    esp_err_t err = esp_http_client_open(client, -1);
+    if (err != ESP_OK) {
+        ESP_LOGE(WIFI_TAG, "HTTP open failed: %s", esp_err_to_name(err));
+        esp_http_client_cleanup(client);
+        return err;
+    }
+
+    rmds_upload_ctx_t up = {
+        .client = client,
+#if RMDS_UPLOAD_GZIP
+        .z = &s_deflate,
+#endif
+    };
+    if (up.z) {
+        rmds_deflate_begin(up.z, rmds_deflate_to_http_sink, &up);
+    }
+
+    rmds_json_writer_t w;
+    rmds_json_init(&w, rmds_json_to_body_sink, &up);
+    rmds_write_insert_many(&w, batch, count);
+
+    int body_err = rmds_json_finish(&w);
+    if (body_err == 0 && up.z) {
+        int64_t io_before = up.io_us;
+        int64_t t0 = esp_timer_get_time();
+        body_err = rmds_deflate_finish(up.z);
+        up.deflate_us += (esp_timer_get_time() - t0) - (up.io_us - io_before);
+    }
 
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
+    static const char last_chunk[] = "0\r\n\r\n";
+    if (body_err != 0 ||
+        esp_http_client_write(client, last_chunk, sizeof(last_chunk) - 1) !=
+            (int)sizeof(last_chunk) - 1) {
+        ESP_LOGE(WIFI_TAG, "HTTP body write failed (%u readings)", (unsigned int)count);
+        esp_http_client_close(client);
+        esp_http_client_cleanup(client);
+        return ESP_FAIL;
+    }
+
+    *wire_bytes = up.wire_bytes;
+
+    if (up.z) {
+        ESP_LOGI(WIFI_TAG,
+                 "Upload: %u readings, %u JSON bytes -> %u gzip bytes (%u%%), deflate %lld us",
+                 (unsigned int)count,
+                 (unsigned int)w.total,
+                 (unsigned int)up.wire_bytes,
+                 (unsigned int)(w.total ? up.wire_bytes * 100 / w.total : 0),
+                 (long long)up.deflate_us);
+    } else {
+        ESP_LOGI(WIFI_TAG, "Upload: %u readings, %u JSON bytes",
+                 (unsigned int)count, (unsigned int)w.total);
+    }
+
+    if (esp_http_client_fetch_headers(client) >= 0) {
         int status = esp_http_client_get_status_code(client);
-        ESP_LOGI(WIFI_TAG, "HTTP POST done, status = %d", status);
+        ESP_LOGI(WIFI_TAG, "HTTP POST done, status = %d (%lld ms)",
+                 status, (long long)((esp_timer_get_time() - t_start) / 1000));
+        err = (status >= 200 && status < 300) ? ESP_OK : ESP_FAIL;
     } else {
-        ESP_LOGE(WIFI_TAG, "HTTP POST failed: %s", esp_err_to_name(err));
+        ESP_LOGE(WIFI_TAG, "HTTP POST failed: no response headers");
+        err = ESP_FAIL;
     }
 
+    esp_http_client_close(client);
     esp_http_client_cleanup(client);
-}
\ No newline at end of file
+    return err;
+}
+
+const rmds_uplink_backend_t rmds_uplink_http = {
+    .name       = "http",
+    .start      = NULL,
+    .ready      = rmds_wifi_is_connected,
+    .send_batch = rmds_http_send_batch,
+    .acks_later = false,
+};
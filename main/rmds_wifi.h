@@ -1,6 +1,8 @@
 // rmds_wifi.h
 #pragma once
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -12,9 +14,9 @@ extern "C" {
 void rmds_wifi_init(void);
 
 /**
- * Send a single LoRa payload up to the cloud backend.
+ * True once an IP address has been obtained (and not lost since).
  */
-void send_frame_to_cloud(const char *payload);
+bool rmds_wifi_is_connected(void);
 
 #ifdef __cplusplus
 }
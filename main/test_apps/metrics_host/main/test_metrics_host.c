@@ -0,0 +1,81 @@
+// test_metrics_host.c
+//
+// The gateway's Prometheus endpoint (main/rmds_metrics.c) on the linux
+// target. Every counter is driven to a many-digit value first, so the
+// longest metric names carry their longest lines, then /metrics is served
+// on RMDS_METRICS_PORT. pytest_metrics_host.py scrapes it and checks that
+// every line of the exposition is a complete HELP, TYPE or sample line and
+// that the counters hold the values recorded here.
+//
+// The radio and the uplink queue are stood in for below.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "lora.h"
+#include "rmds_metrics.h"
+#include "rmds_uplink.h"
+
+#define PACKETS         123456
+#define REJECTED        4321
+#define SKIPPED_EACH    7
+#define LATE            555
+#define DUPLICATE       12345
+#define NODES           42
+#define BATCHES_OK      2000
+#define BATCHES_FAILED  150
+#define BATCH_READINGS  16
+#define READINGS_LOST   1234    // acked late as failed (MQTT)
+#define QUEUE_DEPTH     31
+#define CRC_ERRORS      98765
+
+uint32_t lora_crc_error_count(void)
+{
+    return CRC_ERRORS;
+}
+
+void lora_get_mode_times(lora_mode_times_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->sleep_us   = 86400ull * 1000000 * 365;
+    out->standby_us = 3600ull * 1000000 + 1;
+    out->tx_us      = 123456789;
+    out->rx_us      = 999999999999ull;
+    out->cad_us     = 1500;
+}
+
+uint32_t rmds_uplink_queue_depth(void)
+{
+    return QUEUE_DEPTH;
+}
+
+void app_main(void)
+{
+    for (int i = 0; i < PACKETS; i++) {
+        rmds_metrics_packet_received(-125 + i % 80, -20.0f + (float)(i % 35));
+        rmds_metrics_link_packet(SKIPPED_EACH, i < LATE, i < DUPLICATE, NODES);
+    }
+    for (int i = 0; i < REJECTED; i++) {
+        rmds_metrics_frame_rejected();
+    }
+    for (int i = 0; i < BATCHES_OK; i++) {
+        rmds_metrics_upload(BATCH_READINGS, true, (int64_t)(i % 7000) * 1000);
+    }
+    for (int i = 0; i < BATCHES_FAILED; i++) {
+        rmds_metrics_upload(BATCH_READINGS, false, 5000000);
+    }
+    rmds_metrics_readings(READINGS_LOST, false);
+    rmds_metrics_register_task(xTaskGetCurrentTaskHandle());
+
+    rmds_metrics_start_server();
+    printf("Metrics host test: serving on port %d\n", RMDS_METRICS_PORT);
+    fflush(stdout);
+
+    // The pytest scrapes, then ends the process
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
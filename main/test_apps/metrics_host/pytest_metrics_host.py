@@ -0,0 +1,80 @@
+# SPDX-License-Identifier: CC0-1.0
+import logging
+import re
+import time
+import urllib.request
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+
+NAME = r'[a-zA-Z_:][a-zA-Z0-9_:]*'
+HELP_RE = re.compile(rf'# HELP ({NAME}) \S.*')
+TYPE_RE = re.compile(rf'# TYPE ({NAME}) (counter|gauge|histogram)')
+SAMPLE_RE = re.compile(rf'({NAME})(\{{{NAME}="[^"\\]*"\}})? (-?[0-9]+(\.[0-9]+)?)')
+
+# What test_metrics_host.c recorded
+EXPECTED = {
+    'rmds_lora_packets_received_total': 123456,
+    'rmds_lora_crc_errors_total': 98765,
+    'rmds_frames_rejected_total': 4321,
+    # Per-node sequence tracking, the longest names in the exposition
+    'rmds_lora_packets_skipped_total': 123456 * 7,
+    'rmds_lora_packets_late_total': 555,
+    'rmds_lora_packets_duplicate_total': 12345,
+    'rmds_lora_nodes_tracked': 42,
+    'rmds_uplink_queue_depth': 31,
+    'rmds_uplink_batches_ok_total': 2000,
+    'rmds_uplink_batches_failed_total': 150,
+    'rmds_uplink_readings_total': 2000 * 16,
+    'rmds_uplink_readings_failed_total': 150 * 16 + 1234,
+    'rmds_lora_rssi_dbm_count': 123456,
+    'rmds_uplink_latency_ms_count': 2150,
+}
+
+
+def scrape(port: int) -> str:
+    for _ in range(20):
+        try:
+            with urllib.request.urlopen(f'http://127.0.0.1:{port}/metrics', timeout=5) as r:
+                return r.read().decode()
+        except OSError:
+            time.sleep(0.5)
+    raise AssertionError('no answer on /metrics')
+
+
+def family(sample: str, types: dict) -> str:
+    for suffix in ('_bucket', '_sum', '_count'):
+        base = sample[:-len(suffix)]
+        if sample.endswith(suffix) and types.get(base) == 'histogram':
+            return base
+    return sample
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_metrics_host(dut: IdfDut) -> None:
+    port = int(dut.expect(r'Metrics host test: serving on port (\d+)').group(1))
+    text = scrape(port)
+    assert text.endswith('\n'), 'exposition does not end with a newline'
+
+    helps, types, values = set(), {}, {}
+    for n, line in enumerate(text[:-1].split('\n'), 1):
+        if m := HELP_RE.fullmatch(line):
+            assert m.group(1) not in helps, f'line {n}: second HELP for {m.group(1)}'
+            helps.add(m.group(1))
+        elif m := TYPE_RE.fullmatch(line):
+            assert m.group(1) in helps, f'line {n}: TYPE before HELP for {m.group(1)}'
+            types[m.group(1)] = m.group(2)
+        elif m := SAMPLE_RE.fullmatch(line):
+            name = family(m.group(1), types)
+            assert name in types, f'line {n}: sample of {name} without a TYPE'
+            if not m.group(2):
+                values[m.group(1)] = float(m.group(3))
+        else:
+            raise AssertionError(f'line {n} is not a complete exposition line: {line!r}')
+
+    logging.info(f'{len(types)} metric families, {len(text)} bytes')
+    assert set(types) == helps, f'HELP without TYPE: {sorted(helps - set(types))}'
+    for name, want in EXPECTED.items():
+        assert values.get(name) == want, f'{name} is {values.get(name)}, expected {want}'
@@ -0,0 +1,239 @@
+// test_upload_host.c
+//
+// Upload body compression (main/rmds_deflate.c) on the linux target. Each
+// case feeds one input through the gzip encoder and prints the stream as
+// hex; pytest_upload_host.py inflates it with Python's gzip module and
+// compares it with the same input built in Python:
+//   empty:   no bytes at all, just the header, an empty block and trailer
+//   short:   fewer bytes than the shortest match
+//   random:  incompressible bytes, all literals
+//   long:    runs longer than a match and a pattern repeating beyond the
+//            1 KB window, several times the encoder's buffer
+//   json:    an insertMany body from the JSON writer, as uploaded
+//   *_split: the same inputs written in pieces of 1 to 17 bytes, which must
+//            give the very same stream as one write
+// Then a sink that fails part way through must fail the upload.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rmds_deflate.h"
+#include "rmds_json.h"
+
+#define GZ_OUT_MAX      16384
+#define RANDOM_LEN      3000
+#define LONG_RUN_A      1000
+#define LONG_SEG_LEN    1500    // longer than RMDS_DEFLATE_WSIZE
+#define LONG_SEG_REPS   4
+#define LONG_RUN_Z      600
+#define JSON_READINGS   64
+#define INPUT_MAX       16384
+#define SPLIT_MAX       17
+#define SINK_FAIL_AT    100
+
+typedef struct {
+    uint8_t data[GZ_OUT_MAX];
+    size_t  len;
+    size_t  fail_at;            // 0: never fail
+} gz_out_t;
+
+static rmds_deflate_t s_z;      // too big for the stack, as on the device
+static gz_out_t       s_out;
+static gz_out_t       s_split_out;
+static uint8_t        s_input[INPUT_MAX];
+static int            s_failed;
+
+static int gz_sink(void *ctx, const uint8_t *data, size_t len)
+{
+    gz_out_t *out = ctx;
+    if ((out->fail_at && out->len + len > out->fail_at) || out->len + len > sizeof(out->data)) {
+        return -1;
+    }
+    memcpy(&out->data[out->len], data, len);
+    out->len += len;
+    return 0;
+}
+
+// Same generator as pytest_upload_host.py
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static size_t make_random(uint8_t *buf)
+{
+    uint32_t rng = 0x2545F491u;
+    for (size_t i = 0; i < RANDOM_LEN; i++) {
+        buf[i] = (uint8_t)xorshift32(&rng);
+    }
+    return RANDOM_LEN;
+}
+
+static size_t make_long(uint8_t *buf)
+{
+    uint32_t rng = 0x9E3779B9u;
+    size_t n = 0;
+
+    memset(buf, 'a', LONG_RUN_A);
+    n += LONG_RUN_A;
+    for (size_t i = 0; i < LONG_SEG_LEN; i++) {
+        buf[n + i] = (uint8_t)('a' + xorshift32(&rng) % 26);
+    }
+    for (int r = 1; r < LONG_SEG_REPS; r++) {
+        memcpy(&buf[n + r * LONG_SEG_LEN], &buf[n], LONG_SEG_LEN);
+    }
+    n += LONG_SEG_LEN * LONG_SEG_REPS;
+    memset(&buf[n], 'z', LONG_RUN_Z);
+    return n + LONG_RUN_Z;
+}
+
+typedef struct {
+    uint8_t *buf;
+    size_t   len;
+} json_buf_t;
+
+static int json_sink(void *ctx, const char *data, size_t len)
+{
+    json_buf_t *b = ctx;
+    if (b->len + len > INPUT_MAX) {
+        return -1;
+    }
+    memcpy(&b->buf[b->len], data, len);
+    b->len += len;
+    return 0;
+}
+
+// The envelope of rmds_write_insert_many() around readings that change
+// from one to the next like real ones; the pytest knows the same values
+static size_t make_json(uint8_t *buf)
+{
+    json_buf_t b = { .buf = buf };
+    rmds_json_writer_t w;
+
+    rmds_json_init(&w, json_sink, &b);
+    rmds_json_begin_object(&w);
+    rmds_json_kv_string(&w, "collection", "myCollection");
+    rmds_json_kv_string(&w, "database", "class_project_db");
+    rmds_json_kv_string(&w, "dataSource", "Cluster0");
+    rmds_json_key(&w, "documents");
+    rmds_json_begin_array(&w);
+    for (uint32_t i = 0; i < JSON_READINGS; i++) {
+        rmds_json_begin_object(&w);
+        rmds_json_kv_uint(&w, "node", 0x3C6100 + i % 4);
+        rmds_json_kv_uint(&w, "seq", i);
+        rmds_json_kv_uint(&w, "ppm", 400 + i * 37 % 900);
+        rmds_json_kv_uint(&w, "faults", i % 9 == 0);
+        rmds_json_kv_fixed(&w, "temp_K", (int32_t)(2931 + i % 20), 1);
+        rmds_json_kv_uint(&w, "age_s", i % 30);
+        if (i % 2 == 0) {
+            rmds_json_kv_uint(&w, "bat_mv", 3700 + i % 200);
+        }
+        rmds_json_kv_int(&w, "rssi", -(int32_t)(60 + i % 40));
+        rmds_json_kv_fixed(&w, "snr", (int32_t)(i * 7 % 1500) - 300, 2);
+        rmds_json_kv_uint64(&w, "gw_time_ms", 1760000000000ull + i * 10000ull);
+        rmds_json_end_object(&w);
+    }
+    rmds_json_end_array(&w);
+    rmds_json_end_object(&w);
+
+    if (rmds_json_finish(&w) != 0) {
+        printf("FAIL json: writer error\n");
+        s_failed++;
+        return 0;
+    }
+    return b.len;
+}
+
+static int gz_compress(gz_out_t *out, const uint8_t *data, size_t len, bool split)
+{
+    memset(out, 0, sizeof(*out));
+    rmds_deflate_begin(&s_z, gz_sink, out);
+
+    size_t off = 0, piece = 1;
+    while (off < len) {
+        size_t take = split ? piece : len - off;
+        if (take > len - off) {
+            take = len - off;
+        }
+        if (rmds_deflate_write(&s_z, &data[off], take) != 0) {
+            return -1;
+        }
+        off += take;
+        piece = piece % SPLIT_MAX + 1;
+    }
+    return rmds_deflate_finish(&s_z);
+}
+
+static void gz_print(const char *name, size_t in_len, const gz_out_t *out)
+{
+    printf("GZ %s in=%u out=%u gz=", name, (unsigned int)in_len, (unsigned int)out->len);
+    for (size_t i = 0; i < out->len; i++) {
+        printf("%02x", out->data[i]);
+    }
+    printf("\n");
+}
+
+static void run_case(const char *name, const uint8_t *data, size_t len)
+{
+    char split_name[32];
+
+    if (gz_compress(&s_out, data, len, false) != 0) {
+        printf("FAIL %s: encoder error\n", name);
+        s_failed++;
+        return;
+    }
+    gz_print(name, len, &s_out);
+
+    snprintf(split_name, sizeof(split_name), "%s_split", name);
+    if (gz_compress(&s_split_out, data, len, true) != 0) {
+        printf("FAIL %s: encoder error\n", split_name);
+        s_failed++;
+        return;
+    }
+    gz_print(split_name, len, &s_split_out);
+
+    if (s_split_out.len != s_out.len || memcmp(s_split_out.data, s_out.data, s_out.len) != 0) {
+        printf("FAIL %s: differs from a single write\n", split_name);
+        s_failed++;
+    }
+}
+
+static void run_sink_error(void)
+{
+    size_t len = make_random(s_input);
+
+    memset(&s_out, 0, sizeof(s_out));
+    s_out.fail_at = SINK_FAIL_AT;
+    rmds_deflate_begin(&s_z, gz_sink, &s_out);
+    int write_err = rmds_deflate_write(&s_z, s_input, len);
+    int finish_err = rmds_deflate_finish(&s_z);
+
+    bool ok = write_err != 0 && finish_err != 0;
+    printf("GZ sink_error: write=%d finish=%d %s\n", write_err, finish_err, ok ? "ok" : "FAIL");
+    if (!ok) {
+        s_failed++;
+    }
+}
+
+void app_main(void)
+{
+    printf("Upload host tests: %u byte encoder state, %d byte window\n",
+           (unsigned int)sizeof(rmds_deflate_t), RMDS_DEFLATE_WSIZE);
+
+    run_case("empty", s_input, 0);
+    run_case("short", (const uint8_t *)"RMDS", 4);
+    run_case("random", s_input, make_random(s_input));
+    run_case("long", s_input, make_long(s_input));
+    run_case("json", s_input, make_json(s_input));
+    run_sink_error();
+
+    printf("Upload host tests done, %d failed\n", s_failed);
+    fflush(stdout);
+    exit(0);
+}
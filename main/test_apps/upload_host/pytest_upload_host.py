@@ -0,0 +1,92 @@
+# SPDX-License-Identifier: CC0-1.0
+import gzip
+import logging
+import zlib
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+from upload_standin import check_insert_many
+
+# JSON bodies must at least halve; real batches do better than this
+JSON_MAX_RATIO = 0.5
+# Fixed Huffman codes spend 9 bits on most bytes above 0x8F
+RANDOM_MAX_GROWTH = 1.15
+
+
+def xorshift32(state: int):
+    while True:
+        state ^= (state << 13) & 0xFFFFFFFF
+        state ^= state >> 17
+        state ^= (state << 5) & 0xFFFFFFFF
+        yield state
+
+
+def make_random() -> bytes:
+    rng = xorshift32(0x2545F491)
+    return bytes(next(rng) & 0xFF for _ in range(3000))
+
+
+def make_long() -> bytes:
+    rng = xorshift32(0x9E3779B9)
+    seg = bytes(ord('a') + next(rng) % 26 for _ in range(1500))
+    return b'a' * 1000 + seg * 4 + b'z' * 600
+
+
+def json_reading(i: int) -> dict:
+    r = {
+        'node': 0x3C6100 + i % 4,
+        'seq': i,
+        'ppm': 400 + i * 37 % 900,
+        'faults': int(i % 9 == 0),
+        'temp_K': (2931 + i % 20) / 10,
+        'age_s': i % 30,
+    }
+    if i % 2 == 0:
+        r['bat_mv'] = 3700 + i % 200
+    r['rssi'] = -(60 + i % 40)
+    r['snr'] = (i * 7 % 1500 - 300) / 100
+    r['gw_time_ms'] = 1760000000000 + i * 10000
+    return r
+
+
+EXPECTED = {
+    'empty': b'',
+    'short': b'RMDS',
+    'random': make_random(),
+    'long': make_long(),
+}
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_upload_host(dut: IdfDut) -> None:
+    streams, bodies = {}, {}
+    for name in ['empty', 'short', 'random', 'long', 'json']:
+        for case in [name, f'{name}_split']:
+            m = dut.expect(rf'GZ {case} in=(\d+) out=(\d+) gz=([0-9a-f]*)\r?\n')
+            size_in, size_out, gz = int(m.group(1)), int(m.group(2)), bytes.fromhex(m.group(3).decode())
+            assert len(gz) == size_out, f'{case}: {len(gz)} bytes printed, {size_out} reported'
+            data = gzip.decompress(gz)
+            # Raw inflate as well, past the 10 byte header, for a second decoder's opinion
+            assert zlib.decompressobj(-zlib.MAX_WBITS).decompress(gz[10:]) == data, case
+            assert len(data) == size_in, f'{case}: {len(data)} bytes inflated, {size_in} written'
+            logging.info(f'{case}: {size_in} -> {size_out} bytes')
+            streams[case], bodies[case] = data, gz
+
+    for name, want in EXPECTED.items():
+        assert streams[name] == want, f'{name}: inflated stream differs from the input'
+        assert streams[f'{name}_split'] == want, f'{name}_split: inflated stream differs from the input'
+
+    random_growth = len(bodies['random']) / len(EXPECTED['random'])
+    assert random_growth < RANDOM_MAX_GROWTH, f'incompressible input grew by {random_growth:.2f}x'
+
+    json_ratio = len(bodies['json']) / len(streams['json'])
+    assert json_ratio < JSON_MAX_RATIO, f'JSON body only compressed to {json_ratio:.2f}'
+
+    # As the stand-in would take it from the device
+    readings = check_insert_many(bodies['json'], 'gzip')
+    assert readings == [json_reading(i) for i in range(64)]
+
+    dut.expect('GZ sink_error: write=-1 finish=-1 ok')
+    dut.expect('Upload host tests done, 0 failed')
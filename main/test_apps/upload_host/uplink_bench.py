@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: CC0-1.0
+"""Uplink throughput from the receiving end, for comparing the backends.
+
+Run one of these on a PC while the gateway forwards readings, then read
+msg/s and bytes/reading off the summary lines (the gateway logs its own
+side every RMDS_UPLINK_STATS_EVERY batches):
+
+    # HTTP (RMDS_UPLINK_USE_MQTT 0): point RMDS_CLOUD_URL at this host
+    python uplink_bench.py http [--port 8080]
+
+    # MQTT (RMDS_UPLINK_USE_MQTT 1): subscribe at RMDS_MQTT_BROKER_URI,
+    # needs paho-mqtt
+    python uplink_bench.py mqtt --broker 192.168.1.10 [--port 1883]
+
+msg/s is readings received per second between the first message and the
+latest. bytes/reading counts what the gateway sent above TCP: request line,
+headers and body for HTTP (gzip when RMDS_UPLOAD_GZIP is 1), PUBLISH plus
+its PUBACK for MQTT as rmds_mqtt_wire_bytes() counts them. The payload part
+is the body or the PUBLISH payload alone.
+"""
+import argparse
+import json
+import threading
+import time
+from http.server import ThreadingHTTPServer
+
+from upload_standin import READING_KEYS, UploadHandler
+
+REPORT_EVERY_S = 10
+
+
+class Totals:
+    def __init__(self, name: str) -> None:
+        self.name = name
+        self.lock = threading.Lock()
+        self.readings = 0
+        self.messages = 0
+        self.wire_bytes = 0
+        self.payload_bytes = 0
+        self.first = None
+        self.first_readings = 0
+        self.last = None
+
+    def add(self, readings: int, wire_bytes: int, payload_bytes: int) -> None:
+        now = time.monotonic()
+        with self.lock:
+            if self.first is None:
+                self.first, self.first_readings = now, readings
+            self.last = now
+            self.readings += readings
+            self.messages += 1
+            self.wire_bytes += wire_bytes
+            self.payload_bytes += payload_bytes
+
+    def report(self) -> None:
+        with self.lock:
+            if not self.readings:
+                print(f'{self.name}: nothing received yet')
+                return
+            span = self.last - self.first
+            # The first message only starts the clock
+            rate = f'{(self.readings - self.first_readings) / span:.1f}' if span > 0 else '-'
+            print(f'{self.name}: {self.readings} readings in {self.messages} messages, '
+                  f'{rate} msg/s, {self.wire_bytes / self.readings:.1f} bytes/reading '
+                  f'({self.payload_bytes / self.readings:.1f} of it payload)', flush=True)
+
+
+def report_forever(totals: Totals) -> None:
+    while True:
+        time.sleep(REPORT_EVERY_S)
+        totals.report()
+
+
+def bench_http(port: int) -> None:
+    totals = Totals('http')
+
+    class BenchHandler(UploadHandler):
+        def log_request(self, code='-', size='-') -> None:
+            pass
+
+        def accepted(self, readings: list, body: bytes) -> None:
+            head = len(self.raw_requestline) + len(self.headers.as_bytes())
+            totals.add(len(readings), head + len(body), len(body))
+
+    server = ThreadingHTTPServer(('', port), BenchHandler)
+    threading.Thread(target=report_forever, args=(totals,), daemon=True).start()
+    print(f'http: insertMany stand-in on port {port}')
+    server.serve_forever()
+
+
+def mqtt_wire_bytes(topic_len: int, payload_len: int) -> int:
+    # Same as rmds_mqtt_wire_bytes(): PUBLISH QoS 1 and its PUBACK
+    remaining = 2 + topic_len + 2 + payload_len
+    len_bytes = 1 if remaining < 128 else (2 if remaining < 16384 else 3)
+    return 1 + len_bytes + remaining + 4
+
+
+def bench_mqtt(broker: str, port: int) -> None:
+    import paho.mqtt.client as mqtt
+
+    totals = Totals('mqtt')
+
+    def on_connect(client, userdata, flags, reason_code, properties=None) -> None:
+        client.subscribe('rmds/+/reading', qos=1)
+
+    def on_message(client, userdata, msg) -> None:
+        reading = json.loads(msg.payload)
+        missing = [k for k in READING_KEYS if k not in reading]
+        if missing:
+            print(f'{msg.topic}: missing {missing}')
+            return
+        topic_len = len(msg.topic.encode())
+        totals.add(1, mqtt_wire_bytes(topic_len, len(msg.payload)), len(msg.payload))
+
+    client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2, client_id='rmds-bench')
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(broker, port)
+    threading.Thread(target=report_forever, args=(totals,), daemon=True).start()
+    print(f'mqtt: subscribed at {broker}:{port}')
+    client.loop_forever()
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest='backend', required=True)
+    http = sub.add_parser('http')
+    http.add_argument('--port', type=int, default=8080)
+    mqtt = sub.add_parser('mqtt')
+    mqtt.add_argument('--broker', required=True)
+    mqtt.add_argument('--port', type=int, default=1883)
+    args = parser.parse_args()
+
+    if args.backend == 'http':
+        bench_http(args.port)
+    else:
+        bench_mqtt(args.broker, args.port)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: CC0-1.0
+"""Local stand-in for the Data API insertMany endpoint.
+
+Point RMDS_CLOUD_URL (main/rmds_wifi.c) at http://<this host>:8080/insertMany
+to watch real uploads without Atlas. Every body is taken apart the way the
+cloud would: chunked transfer, then gzip when the request says
+Content-Encoding: gzip (RMDS_UPLOAD_GZIP), then the insertMany envelope and
+each reading in it. A good upload gets 200 and a line with its sizes, a bad
+one gets 400 and the reason.
+
+    python main/test_apps/upload_host/upload_standin.py [--port 8080]
+
+pytest_upload_host.py checks the encoder's output with check_insert_many().
+"""
+import argparse
+import gzip
+import json
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+ENVELOPE = {
+    'collection': 'myCollection',
+    'database': 'class_project_db',
+    'dataSource': 'Cluster0',
+}
+READING_KEYS = {
+    'node': int,
+    'seq': int,
+    'ppm': int,
+    'faults': int,
+    'temp_K': (int, float),
+    'age_s': int,
+    'rssi': int,
+    'snr': (int, float),
+    'gw_time_ms': int,
+}
+READING_OPTIONAL = {'bat_mv': int}
+
+
+def decode_body(body: bytes, encoding: str) -> bytes:
+    if encoding == 'gzip':
+        return gzip.decompress(body)    # checks the CRC and length trailer too
+    if encoding not in ('', 'identity'):
+        raise ValueError(f'unexpected Content-Encoding {encoding!r}')
+    return body
+
+
+def check_insert_many(body: bytes, encoding: str = '') -> list:
+    """Decode an upload body and check it; returns the readings."""
+    doc = json.loads(decode_body(body, encoding))
+    if not isinstance(doc, dict):
+        raise ValueError('body is not a JSON object')
+    for key, want in ENVELOPE.items():
+        if doc.get(key) != want:
+            raise ValueError(f'{key} is {doc.get(key)!r}, expected {want!r}')
+
+    readings = doc.get('documents')
+    if not isinstance(readings, list) or not readings:
+        raise ValueError('no documents')
+    for i, r in enumerate(readings):
+        if not isinstance(r, dict):
+            raise ValueError(f'document {i} is not an object')
+        for key, kind in READING_KEYS.items():
+            if not isinstance(r.get(key), kind):
+                raise ValueError(f'document {i}: {key} missing or not a number')
+        extra = set(r) - set(READING_KEYS) - set(READING_OPTIONAL)
+        if extra:
+            raise ValueError(f'document {i}: unexpected {sorted(extra)}')
+    return readings
+
+
+def read_chunked(rfile) -> bytes:
+    body = b''
+    while True:
+        size = int(rfile.readline().split(b';')[0], 16)
+        chunk = rfile.read(size + 2)
+        if chunk[size:] != b'\r\n':
+            raise ValueError('bad chunk framing')
+        if size == 0:
+            return body
+        body += chunk[:size]
+
+
+class UploadHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def do_POST(self) -> None:
+        try:
+            if self.headers.get('Transfer-Encoding', '').lower() == 'chunked':
+                body = read_chunked(self.rfile)
+            else:
+                body = self.rfile.read(int(self.headers.get('Content-Length', 0)))
+            encoding = self.headers.get('Content-Encoding', '').lower()
+            readings = check_insert_many(body, encoding)
+        except (ValueError, OSError, EOFError, zlib.error) as e:
+            self.log_message('rejected: %s', e)
+            self.reply(400, {'error': str(e)})
+            return
+
+        self.accepted(readings, body)
+        self.reply(200, {'insertedIds': [f'{r["node"]:x}-{r["seq"]}' for r in readings]})
+
+    def accepted(self, readings: list, body: bytes) -> None:
+        self.log_message('%d readings, %d body bytes (%s), %.1f bytes/reading',
+                         len(readings), len(body),
+                         self.headers.get('Content-Encoding', 'plain'),
+                         len(body) / len(readings))
+
+    def reply(self, status: int, doc: dict) -> None:
+        data = json.dumps(doc).encode()
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--port', type=int, default=8080)
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer(('', args.port), UploadHandler)
+    print(f'insertMany stand-in on port {args.port}')
+    server.serve_forever()
+
+
+if __name__ == '__main__':
+    main()